@@ -0,0 +1,168 @@
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <string>
+#include <vector>
+#include "../src/displays/advanced_display.h"
+#include "../src/emulators/chip8.h"
+#include "../src/emulators/schip.h"
+
+// Opcode pair counts over a ROM corpus and the dispatches the fused pairs of the release loop save
+// Usage: fusion_benchmark [--frames <n>] <rom>...
+// ROMs ending in .sch8 run on SChip, the rest on Chip8 with the COSMAC VIP quirks
+
+class BenchmarkChip8 : public Chip8 {
+public:
+    BenchmarkChip8(SimpleDisplay& display, InputHandler& inputHandler): Chip8(display, inputHandler, COSMAC_VIP_QUIRKS) {}
+
+    // Lasts until the next loadRom or loadState
+    void disableFusion() {
+        fusions = FusionTable{};
+    }
+};
+
+class BenchmarkSChip : public SChip {
+public:
+    BenchmarkSChip(AdvancedDisplay& display, InputHandler& inputHandler): SChip(display, inputHandler) {}
+
+    void disableFusion() {
+        fusions = FusionTable{};
+    }
+};
+
+struct RomResult {
+    uint64_t instructions;
+    uint64_t fused;
+    double unfusedSeconds;
+    double fusedSeconds;
+};
+
+// Pattern with the operands zeroed, so classifyFusion can be asked about an opcode class
+static uint16_t sampleInstruction(Opcode op) {
+    uint16_t ins{};
+    for (const char* c{ OPCODE_PATTERNS[static_cast<int>(op)] }; *c != '\0'; c++) {
+        int digit{ *c >= '0' && *c <= '9' ? *c - '0' : *c >= 'A' && *c <= 'F' ? *c - 'A' + 10 : 0 };
+        ins = ins << 4 | digit;
+    }
+    return ins;
+}
+
+template<typename Core, typename Display>
+static RomResult measureRom(const std::vector<uint8_t>& rom, int frameCount, std::vector<uint64_t>& pairCounts) {
+    RomResult result{};
+
+    // Pair counts, the profiler selects the loop that dispatches every instruction
+    {
+        InputHandler inputHandler{};
+        Display display{};
+        Core core{display, inputHandler};
+        ExecutionProfiler profiler{ "fusion_benchmark" };
+        core.setProfiler(&profiler);
+        core.seedRandom(1);
+        core.loadRom(rom.data(), rom.size());
+        core.runFrames(frameCount);
+        for (int first{}; first < OPCODE_COUNT; first++) {
+            for (int second{}; second < OPCODE_COUNT; second++) {
+                pairCounts[first * OPCODE_COUNT + second] += profiler.getOpcodePairCount(static_cast<Opcode>(first), static_cast<Opcode>(second));
+            }
+        }
+    }
+
+    for (bool isFused : { false, true }) {
+        InputHandler inputHandler{};
+        Display display{};
+        Core core{display, inputHandler};
+        core.seedRandom(1);
+        core.loadRom(rom.data(), rom.size());
+        if (!isFused) {
+            core.disableFusion();
+        }
+
+        auto start{ std::chrono::steady_clock::now() };
+        core.runFrames(frameCount);
+        std::chrono::duration<double> elapsed{ std::chrono::steady_clock::now() - start };
+
+        if (isFused) {
+            result.instructions = core.getInstructionCount();
+            result.fused = core.getFusedCount();
+            result.fusedSeconds = elapsed.count();
+        } else {
+            result.unfusedSeconds = elapsed.count();
+        }
+    }
+    return result;
+}
+
+int main(int argc, char* argv[]) {
+    int frameCount{ 3000 };
+    std::vector<std::string> files;
+    for (int i{1}; i < argc; i++) {
+        if (strcmp(argv[i], "--frames") == 0 && i + 1 < argc) {
+            frameCount = atoi(argv[++i]);
+        } else {
+            files.emplace_back(argv[i]);
+        }
+    }
+
+    if (files.empty()) {
+        printf("Usage: %s [--frames <n>] <rom>...\n", argv[0]);
+        return 1;
+    }
+
+    std::vector<uint64_t> pairCounts(OPCODE_COUNT * OPCODE_COUNT);
+    RomResult total{};
+
+    printf("%-40s %14s %14s %8s %10s %10s\n", "ROM", "Instructions", "Saved", "Saved%", "Unfused", "Fused");
+    for (const std::string& file : files) {
+        std::ifstream input{ file, std::ios::binary };
+        if (!input.is_open()) {
+            printf("Error: Could not open %s\n", file.c_str());
+            continue;
+        }
+        std::vector<uint8_t> rom{ std::istreambuf_iterator<char>(input), std::istreambuf_iterator<char>() };
+
+        bool isSchip{ file.size() > 5 && file.compare(file.size() - 5, 5, ".sch8") == 0 };
+        RomResult result{ isSchip ? measureRom<BenchmarkSChip, AdvancedDisplay>(rom, frameCount, pairCounts)
+                                  : measureRom<BenchmarkChip8, SimpleDisplay>(rom, frameCount, pairCounts) };
+
+        std::string name{ file.substr(file.find_last_of('/') + 1) };
+        printf("%-40.40s %14llu %14llu %7.2f%% %8.2fms %8.2fms\n", name.c_str(), (unsigned long long) result.instructions,
+               (unsigned long long) result.fused, result.instructions ? 100.0 * result.fused / result.instructions : 0.0,
+               result.unfusedSeconds * 1e3, result.fusedSeconds * 1e3);
+
+        total.instructions += result.instructions;
+        total.fused += result.fused;
+        total.unfusedSeconds += result.unfusedSeconds;
+        total.fusedSeconds += result.fusedSeconds;
+    }
+
+    printf("%-40s %14llu %14llu %7.2f%% %8.2fms %8.2fms\n", "Total", (unsigned long long) total.instructions,
+           (unsigned long long) total.fused, total.instructions ? 100.0 * total.fused / total.instructions : 0.0,
+           total.unfusedSeconds * 1e3, total.fusedSeconds * 1e3);
+
+    // Most frequent pairs of the corpus, the candidates for fusion
+    uint64_t pairTotal{};
+    std::vector<int> pairs;
+    for (int i{}; i < OPCODE_COUNT * OPCODE_COUNT; i++) {
+        pairTotal += pairCounts[i];
+        if (pairCounts[i] > 0) {
+            pairs.push_back(i);
+        }
+    }
+    std::sort(pairs.begin(), pairs.end(), [&](int a, int b) { return pairCounts[a] > pairCounts[b]; });
+
+    printf("\nMost frequent opcode pairs\n");
+    for (int i{}; i < (int) pairs.size() && i < 24; i++) {
+        auto first{ static_cast<Opcode>(pairs[i] / OPCODE_COUNT) };
+        auto second{ static_cast<Opcode>(pairs[i] % OPCODE_COUNT) };
+        bool isFused{ classifyFusion(sampleInstruction(first), sampleInstruction(second)) != Fusion::NONE };
+        printf("  %s %s  %14llu  %6.2f%%  %s\n", OPCODE_PATTERNS[pairs[i] / OPCODE_COUNT], OPCODE_PATTERNS[pairs[i] % OPCODE_COUNT],
+               (unsigned long long) pairCounts[pairs[i]], pairTotal ? 100.0 * pairCounts[pairs[i]] / pairTotal : 0.0,
+               isFused ? "fused" : "");
+    }
+    return 0;
+}
@@ -0,0 +1,93 @@
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include "SDL.h"
+#include "../src/displays/advanced_display.h"
+#include "../src/emulators/schip.h"
+
+// Measures SChip instructions per second without frame pacing
+// Usage: schip_benchmark <rom> [frames]
+
+// Reproduces the per instruction side effects of the execution loop before they were batched to frame boundaries
+class LegacyLoopSChip : public SChip {
+public:
+    LegacyLoopSChip(AdvancedDisplay& display, InputHandler& inputHandler): SChip(display, inputHandler) {}
+
+    bool runLegacyFrames(int frameCount) {
+        for (int frame{}; frame < frameCount; frame++) {
+            if (delay_timer > 0) {
+                delay_timer--;
+            }
+
+            if (sound_timer > 0) {
+                sound_timer--;
+            }
+
+            for (int count{}; count < INSTRUCTIONS_PER_FRAME; count++) {
+                uint16_t ins = (memory[program_counter] << 8) + memory[program_counter + 1];
+                program_counter += 2;
+
+                if (!decode(ins)) {
+                    return false;
+                }
+
+                fflush(stdout);
+                SDL_PauseAudio(sound_timer > 0 ? 0 : 1);
+            }
+
+            display.updateWindowSurface();
+        }
+        return true;
+    }
+};
+
+template<typename Function>
+double measureInstructionsPerSecond(int frameCount, Function run) {
+    auto start{ std::chrono::steady_clock::now() };
+    bool isFinished{ run() };
+    std::chrono::duration<double> elapsed{ std::chrono::steady_clock::now() - start };
+
+    if (!isFinished) {
+        printf("Warning: ROM exited before %d frames, numbers are not comparable\n", frameCount);
+    }
+    return (double) frameCount * INSTRUCTIONS_PER_FRAME / elapsed.count();
+}
+
+int main(int argc, char* argv[]) {
+    if (argc < 2) {
+        printf("Usage: %s <rom> [frames]\n", argv[0]);
+        return 1;
+    }
+
+    std::string file{ argv[1] };
+    int frameCount{ argc > 2 ? atoi(argv[2]) : 100000 };
+
+    double legacy;
+    {
+        InputHandler inputHandler{};
+        AdvancedDisplay display{};
+        LegacyLoopSChip emulator{display, inputHandler};
+        if (!emulator.load(file)) {
+            return 1;
+        }
+        legacy = measureInstructionsPerSecond(frameCount, [&]() { return emulator.runLegacyFrames(frameCount); });
+    }
+
+    double batched;
+    {
+        InputHandler inputHandler{};
+        AdvancedDisplay display{};
+        SChip emulator{display, inputHandler};
+        if (!emulator.load(file)) {
+            return 1;
+        }
+        batched = measureInstructionsPerSecond(frameCount, [&]() { return emulator.runFrames(frameCount); });
+    }
+
+    printf("Frames:                   %d\n", frameCount);
+    printf("Per instruction I/O:      %12.0f instructions/s\n", legacy);
+    printf("Frame batched:            %12.0f instructions/s\n", batched);
+    printf("Speedup:                  %12.2fx\n", batched / legacy);
+    return 0;
+}
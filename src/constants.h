@@ -13,8 +13,12 @@ constexpr int SCREEN_HEIGHT{PIXEL_SIZE * HEIGHT + (HEIGHT - 1)};
 constexpr int HIRES_SCREEN_WIDTH{PIXEL_SIZE / 2 * HIRES_WIDTH + (HIRES_WIDTH - 1)};
 constexpr int HIRES_SCREEN_HEIGHT{PIXEL_SIZE / 2 * HIRES_HEIGHT + (HIRES_HEIGHT - 1)};
 constexpr int RAM_SIZE{4096};
+constexpr int STACK_SIZE{16}; // Return addresses, deeper calls wrap around and overwrite the oldest
 constexpr int INSTRUCTION_PER_SECOND{1000};
+constexpr int INSTRUCTIONS_PER_FRAME{18}; // Matches the original frame loop at 1000 instructions per second
+constexpr int MAX_RUN_AHEAD_FRAMES{8}; // Input lag games build in is a frame or two, more only costs time
 constexpr int AUDIO_SAMPLE_RATE{44100};
+constexpr uint64_t FRAME_DURATION_NS{1000000000 / 60};
 
 constexpr uint32_t GRID_COLOR{0xFF101010};
 
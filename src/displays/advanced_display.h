@@ -1,35 +1,50 @@
 #ifndef CHIP8_EMULATOR_ADVANCED_DISPLAY_H
 #define CHIP8_EMULATOR_ADVANCED_DISPLAY_H
 
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <vector>
 #include "../constants.h"
+#include "../extras/frame_hash.h"
 
 class AdvancedDisplay {
 protected:
-    bool** display; // 2D array to store screen state so that don't need to check actual pixel value
+    // Screen state so that don't need to check actual pixel value
+    // Row major with a stride of HIRES_WIDTH in both modes, one byte per pixel, 1 == white
+    std::vector<uint8_t> ownedPixels;
+    uint8_t* pixels;
     int width;
     int height;
     int pixelSize;
+    int loresPixelSize; // Hires pixels are half as big
     int screenWidth;
     int screenHeight;
     bool isHires; // FALSE == LORES; TRUE == HIRES
 
 public:
+    static constexpr int BUFFER_SIZE{HIRES_WIDTH * HIRES_HEIGHT};
+
     // Constructor
-    AdvancedDisplay(): width{WIDTH}, height{HEIGHT}, pixelSize{PIXEL_SIZE},
-        screenWidth{SCREEN_WIDTH}, screenHeight{SCREEN_HEIGHT}, isHires{} {
-        display = new bool*[HIRES_WIDTH];
-        for (int i{}; i < HIRES_WIDTH; i++) {
-            display[i] = new bool[HIRES_HEIGHT]();
-        }
+    // Renders into storage of BUFFER_SIZE bytes if given, so callers can read frames without copying
+    explicit AdvancedDisplay(uint8_t* storage = nullptr, int loresPixelSize = PIXEL_SIZE): width{WIDTH}, height{HEIGHT},
+        pixelSize{loresPixelSize}, loresPixelSize{loresPixelSize}, screenWidth{loresPixelSize * WIDTH + (WIDTH - 1)},
+        screenHeight{loresPixelSize * HEIGHT + (HEIGHT - 1)}, isHires{} {
+        if (storage == nullptr) {
+            ownedPixels.resize(BUFFER_SIZE);
+            storage = ownedPixels.data();
+        }
+        pixels = storage;
+        memset(pixels, 0, BUFFER_SIZE);
     }
 
+    // Pixels may point into the object itself
+    AdvancedDisplay(const AdvancedDisplay&) = delete;
+    AdvancedDisplay& operator=(const AdvancedDisplay&) = delete;
+
     // Destructor
-    virtual ~AdvancedDisplay() {
-        for (int i{}; i < HIRES_WIDTH; i++) {
-            delete[] display[i];
-        }
-        delete[] display;
-    };
+    virtual ~AdvancedDisplay() = default;
 
     // Getter
     [[nodiscard]] int getWidth() const {
@@ -40,15 +55,35 @@ public:
         return height;
     }
 
-    // For Debugging
-    bool** getDisplay() {
-        return display;
+    [[nodiscard]] bool isHiresMode() const {
+        return isHires;
+    }
+
+    [[nodiscard]] bool getPixel(int x, int y) const {
+        return pixels[y * HIRES_WIDTH + x];
+    }
+
+    uint8_t* getPixels() {
+        return pixels;
+    }
+
+    // The mode is folded into the lowest bit, a blank lores screen differs from a blank hires one
+    [[nodiscard]] uint64_t getFrameHash() const {
+        return hashFramebuffer(pixels, BUFFER_SIZE) ^ isHires;
+    }
+
+    // Takes over the mode and screen contents of other, used when forking an emulator
+    void copyFrom(const AdvancedDisplay& other) {
+        switchOperationalMode(other.isHires);
+        memcpy(pixels, other.pixels, BUFFER_SIZE);
     }
 
+    // For Debugging
+
     void printDisplay() {
         for (int i{}; i < height; i++) {
             for (int j{}; j < width; j++) {
-                printf("%d ", display[j][i] ? 1 : 0);
+                printf("%d ", getPixel(j, i) ? 1 : 0);
             }
             printf("\n");
         }
@@ -56,7 +91,7 @@ public:
 
     // Basic Operations
     virtual void drawPixel(int x, int y, bool isWhite) {
-        display[x][y] = isWhite;
+        pixels[y * HIRES_WIDTH + x] = isWhite;
     }
 
     virtual void clearScreen() {
@@ -70,16 +105,30 @@ public:
     virtual bool flipPixel(int x, int y) {
         bool flag{};
 
-        if (display[x][y]) {
-            display[x][y] = false;
+        uint8_t& pixel{ pixels[y * HIRES_WIDTH + x] };
+        if (pixel) {
+            pixel = false;
             flag = true;
         } else {
-            display[x][y] = true;
+            pixel = true;
         }
 
         return flag;
     }
 
+    // Framebuffer only, for cores that know the display is exactly an AdvancedDisplay and inline the draw
+    bool flipFramebufferPixel(int x, int y) {
+        uint8_t& pixel{ pixels[y * HIRES_WIDTH + x] };
+        pixel ^= 1;
+        return pixel == 0;
+    }
+
+    void clearFramebuffer() {
+        for (int y{}; y < height; y++) {
+            memset(pixels + y * HIRES_WIDTH, 0, width);
+        }
+    }
+
     virtual void switchOperationalMode(bool val) {
         if (isHires == val) {
             return;
@@ -91,15 +140,15 @@ public:
         if (isHires) {
             width = HIRES_WIDTH;
             height = HIRES_HEIGHT;
-            pixelSize = PIXEL_SIZE / 2;
-            screenWidth = HIRES_SCREEN_WIDTH;
-            screenHeight = HIRES_SCREEN_HEIGHT;
+            pixelSize = std::max(loresPixelSize / 2, 1);
+            screenWidth = pixelSize * HIRES_WIDTH + (HIRES_WIDTH - 1);
+            screenHeight = pixelSize * HIRES_HEIGHT + (HIRES_HEIGHT - 1);
         } else {
             width = WIDTH;
             height = HEIGHT;
-            pixelSize = PIXEL_SIZE;
-            screenWidth = SCREEN_WIDTH;
-            screenHeight = SCREEN_HEIGHT;
+            pixelSize = loresPixelSize;
+            screenWidth = pixelSize * WIDTH + (WIDTH - 1);
+            screenHeight = pixelSize * HEIGHT + (HEIGHT - 1);
         }
     }
 
@@ -113,7 +162,7 @@ public:
 
         for (int i{height - size - 1}; i >= 0; i--) {
             for (int j{}; j < width; j++) {
-                drawPixel(j, i + size, display[j][i]);
+                drawPixel(j, i + size, getPixel(j, i));
             }
         }
 
@@ -131,7 +180,7 @@ public:
 
         for (int i{size}; i < height; i++) {
             for (int j{}; j < width; j++) {
-                drawPixel(j, i - size, display[j][i]);
+                drawPixel(j, i - size, getPixel(j, i));
             }
         }
 
@@ -149,7 +198,7 @@ public:
 
         for (int i{}; i < height; i++) {
             for (int j{size}; j < width; j++) {
-                drawPixel(j - size, i, display[j][i]);
+                drawPixel(j - size, i, getPixel(j, i));
             }
         }
 
@@ -167,7 +216,7 @@ public:
 
         for (int i{}; i < height; i++) {
             for (int j{width - size - 1}; j >= 0; j--) {
-                drawPixel(j + size, i, display[j][i]);
+                drawPixel(j + size, i, getPixel(j, i));
             }
         }
 
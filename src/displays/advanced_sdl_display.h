@@ -10,6 +10,8 @@ class AdvancedSDLDisplay : public AdvancedDisplay {
 protected:
     SDL_Window* window;
     SDL_Surface* surface;
+    uint32_t foregroundColor; // 0xAARRGGBB
+    uint32_t backgroundColor;
 
     void setupGrid() {
         auto* verticals = new SDL_Rect[width - 1];
@@ -31,7 +33,10 @@ protected:
     }
 
 public:
-    AdvancedSDLDisplay(SDL_Window* window, SDL_Surface* surface): AdvancedDisplay(), window{window}, surface{surface} {
+    // Starts in lores, the window has to be loresPixelSize * WIDTH + (WIDTH - 1) by loresPixelSize * HEIGHT + (HEIGHT - 1)
+    AdvancedSDLDisplay(SDL_Window* window, SDL_Surface* surface, int loresPixelSize = PIXEL_SIZE):
+        AdvancedDisplay(nullptr, loresPixelSize), window{window}, surface{surface},
+        foregroundColor{0xFFFFFFFF}, backgroundColor{0x00000000} {
         setupGrid();
     }
 
@@ -58,106 +63,31 @@ public:
         int x_start{ x * (pixelSize + 1) };
         int y_start{ y * (pixelSize + 1) };
         SDL_Rect r{x_start, y_start, pixelSize, pixelSize};
-        SDL_FillRect(surface, &r, isWhite ? 0xFFFFFFFF : 0x00000000);
+        SDL_FillRect(surface, &r, isWhite ? foregroundColor : backgroundColor);
     }
 
-    bool flipPixel(int x, int y) override {
-        bool flag{AdvancedDisplay::flipPixel(x, y)};
-        drawPixel(x, y, !flag);
-        return flag;
-    }
-
-    void updateWindowSurface() override {
-        SDL_UpdateWindowSurface(window);
-    }
-
-    void clearScreen() override {
-        for (int i{}; i < width; i++) {
-            for (int j{}; j < height; j++) {
-                drawPixel(i, j, false);
-            }
-        }
-
-        SDL_UpdateWindowSurface(window);
-    }
-
-    void scrollUp(int size) override {
-        if (!isHires) {
-            size /= 2;
-        }
+    // Repaints the whole screen in the new colours
+    void setColors(uint32_t foreground, uint32_t background) {
+        foregroundColor = foreground;
+        backgroundColor = background;
 
-        for (int i{size}; i < height; i++) {
-            for (int j{}; j < width; j++) {
-                drawPixel(j, i - size, display[j][i]);
+        SDL_FillRect(surface, nullptr, GRID_COLOR);
+        for (int y{}; y < height; y++) {
+            for (int x{}; x < width; x++) {
+                drawPixel(x, y, getPixel(x, y));
             }
         }
-
-        for (int i{height - size}; i < height; i++) {
-            for (int j{}; j < width; j++) {
-                drawPixel(j, i, false);
-            }
-        }
-
-        SDL_UpdateWindowSurface(window);
+        updateWindowSurface();
     }
 
-    void scrollDown(int size) override {
-        if (!isHires) {
-            size /= 2;
-        }
-
-        for (int i{height - size - 1}; i >= 0; i--) {
-            for (int j{}; j < width; j++) {
-                drawPixel(j, i + size, display[j][i]);
-            }
-        }
-
-        for (int i{}; i < size; i++) {
-            for (int j{}; j < width; j++) {
-                drawPixel(j, i, false);
-            }
-        }
-
-        SDL_UpdateWindowSurface(window);
-    }
-
-    void scrollRight(int size) override {
-        if (!isHires) {
-            size /= 2;
-        }
-
-        for (int i{}; i < height; i++) {
-            for (int j{width - size - 1}; j >= 0; j--) {
-                drawPixel(j + size, i, display[j][i]);
-            }
-        }
-
-        for (int i{}; i < height; i++) {
-            for (int j{}; j < size; j++) {
-                drawPixel(j, i, false);
-            }
-        }
-
-        SDL_UpdateWindowSurface(window);
+    bool flipPixel(int x, int y) override {
+        bool flag{AdvancedDisplay::flipPixel(x, y)};
+        drawPixel(x, y, !flag);
+        return flag;
     }
 
-    void scrollLeft(int size) override {
-        if (!isHires) {
-            size /= 2;
-        }
-
-        for (int i{}; i < height; i++) {
-            for (int j{size}; j < width; j++) {
-                drawPixel(j - size, i, display[j][i]);
-            }
-        }
-
-        for (int i{}; i < height; i++) {
-            for (int j{width - size}; j < width; j++) {
-                drawPixel(j, i, false);
-            }
-        }
-
+    // Clears and scrolls are inherited, the surface is only presented here once per frame
+    void updateWindowSurface() override {
         SDL_UpdateWindowSurface(window);
     }
 };
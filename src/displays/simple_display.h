@@ -1,40 +1,62 @@
 #ifndef CHIP8_EMULATOR_SIMPLE_DISPLAY_H
 #define CHIP8_EMULATOR_SIMPLE_DISPLAY_H
 
+#include <cstdint>
+#include <cstring>
+#include <vector>
 #include "../constants.h"
+#include "../extras/frame_hash.h"
 
-// 2D Array based Simple Display
+// Flat framebuffer based Simple Display
 class SimpleDisplay {
 protected:
-    bool** display;
+    std::vector<uint8_t> ownedPixels;
+    uint8_t* pixels; // Row major, one byte per pixel, 1 == white
 
 public:
-    SimpleDisplay() {
-        display = new bool*[WIDTH];
-        for (int i{}; i < WIDTH; i++) {
-            display[i] = new bool[HEIGHT]();
+    static constexpr int BUFFER_SIZE{WIDTH * HEIGHT};
+
+    // Renders into storage of BUFFER_SIZE bytes if given, so callers can read frames without copying
+    explicit SimpleDisplay(uint8_t* storage = nullptr) {
+        if (storage == nullptr) {
+            ownedPixels.resize(BUFFER_SIZE);
+            storage = ownedPixels.data();
         }
+        pixels = storage;
+        memset(pixels, 0, BUFFER_SIZE);
     }
 
-    virtual ~SimpleDisplay() {
-        for (int i{}; i < WIDTH; i++) {
-            delete[] display[i];
-        }
-        delete[] display;
+    // Pixels may point into the object itself
+    SimpleDisplay(const SimpleDisplay&) = delete;
+    SimpleDisplay& operator=(const SimpleDisplay&) = delete;
+
+    virtual ~SimpleDisplay() = default;
+
+    [[nodiscard]] bool getPixel(int x, int y) const {
+        return pixels[y * WIDTH + x];
+    }
+
+    uint8_t* getPixels() {
+        return pixels;
+    }
+
+    [[nodiscard]] uint64_t getFrameHash() const {
+        return hashFramebuffer(pixels, BUFFER_SIZE);
     }
 
-    bool** getArrayDisplay() {
-        return display;
+    // Takes over the screen contents of other, used when forking an emulator
+    void copyFrom(const SimpleDisplay& other) {
+        memcpy(pixels, other.pixels, BUFFER_SIZE);
     }
 
     virtual void drawPixel(int x, int y, bool isWhite) {
-        display[x][y] = isWhite;
+        pixels[y * WIDTH + x] = isWhite;
     }
 
     virtual bool flipPixel(int x, int y) {
         bool flag{};
 
-        if (display[x][y]) {
+        if (pixels[y * WIDTH + x]) {
             drawPixel(x, y, false);
             flag = true;
         } else{
@@ -44,6 +66,17 @@ public:
         return flag;
     }
 
+    // Framebuffer only, for cores that know the display is exactly a SimpleDisplay and inline the draw
+    bool flipFramebufferPixel(int x, int y) {
+        uint8_t& pixel{ pixels[y * WIDTH + x] };
+        pixel ^= 1;
+        return pixel == 0;
+    }
+
+    void clearFramebuffer() {
+        memset(pixels, 0, BUFFER_SIZE);
+    }
+
     // To be used after flipping all pixels
     virtual void updateWindowSurface() {
     }
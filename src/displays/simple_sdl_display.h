@@ -8,16 +8,19 @@ class SimpleSDLDisplay : public SimpleDisplay {
 private:
     SDL_Window* window;
     SDL_Surface* surface;
+    int pixelSize;
+    uint32_t foregroundColor; // 0xAARRGGBB
+    uint32_t backgroundColor;
 
     void setupGrid() {
         auto* verticals = new SDL_Rect[WIDTH - 1];
         for (int i{}; i < WIDTH - 1; i++) {
-            verticals[i] = SDL_Rect{ (i + 1) * PIXEL_SIZE + i, 0, 1, SCREEN_HEIGHT };
+            verticals[i] = SDL_Rect{ (i + 1) * pixelSize + i, 0, 1, pixelSize * HEIGHT + (HEIGHT - 1) };
         }
 
         auto* horizontals = new SDL_Rect[HEIGHT - 1];
         for (int i{}; i < HEIGHT - 1; i++) {
-            horizontals[i] = SDL_Rect{ 0, (i + 1) * PIXEL_SIZE + i, SCREEN_WIDTH, 1 };
+            horizontals[i] = SDL_Rect{ 0, (i + 1) * pixelSize + i, pixelSize * WIDTH + (WIDTH - 1), 1 };
         }
 
         SDL_FillRects(surface, verticals, WIDTH - 1, GRID_COLOR);
@@ -29,17 +32,33 @@ private:
     }
 
 public:
-    SimpleSDLDisplay(SDL_Window* window, SDL_Surface* surface): SimpleDisplay(), window{window}, surface{surface} {
+    // The window has to be pixelSize * WIDTH + (WIDTH - 1) by pixelSize * HEIGHT + (HEIGHT - 1) to fit the grid
+    SimpleSDLDisplay(SDL_Window* window, SDL_Surface* surface, int pixelSize = PIXEL_SIZE): SimpleDisplay(), window{window},
+        surface{surface}, pixelSize{pixelSize}, foregroundColor{0xFFFFFFFF}, backgroundColor{0x00000000} {
         setupGrid();
     }
 
     void drawPixel(int x, int y, bool isWhite) override {
         SimpleDisplay::drawPixel(x, y, isWhite);
 
-        int x_start{ x * (PIXEL_SIZE + 1) };
-        int y_start{ y * (PIXEL_SIZE + 1) };
-        SDL_Rect r{x_start, y_start, PIXEL_SIZE, PIXEL_SIZE};
-        SDL_FillRect(surface, &r, isWhite ? 0xFFFFFFFF : 0x00000000);
+        int x_start{ x * (pixelSize + 1) };
+        int y_start{ y * (pixelSize + 1) };
+        SDL_Rect r{x_start, y_start, pixelSize, pixelSize};
+        SDL_FillRect(surface, &r, isWhite ? foregroundColor : backgroundColor);
+    }
+
+    // Repaints the whole screen in the new colours
+    void setColors(uint32_t foreground, uint32_t background) {
+        foregroundColor = foreground;
+        backgroundColor = background;
+
+        SDL_FillRect(surface, nullptr, GRID_COLOR);
+        for (int y{}; y < HEIGHT; y++) {
+            for (int x{}; x < WIDTH; x++) {
+                drawPixel(x, y, getPixel(x, y));
+            }
+        }
+        updateWindowSurface();
     }
 
     bool flipPixel(int x, int y) override {
@@ -52,16 +71,6 @@ public:
     void updateWindowSurface() override {
         SDL_UpdateWindowSurface(window);
     }
-
-    void clearScreen() override {
-        for (int i{}; i < WIDTH; i++) {
-            for (int j{}; j < HEIGHT; j++) {
-                drawPixel(i, j, false);
-            }
-        }
-
-        SDL_UpdateWindowSurface(window);
-    }
 };
 
 #endif
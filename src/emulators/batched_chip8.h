@@ -0,0 +1,500 @@
+#ifndef CHIP8_EMULATOR_BATCHED_CHIP8_H
+#define CHIP8_EMULATOR_BATCHED_CHIP8_H
+
+#include <array>
+#include <cstdint>
+#include <cstring>
+#include <random>
+#include "../constants.h"
+
+// Experimental: N Chip8 instances running the same ROM in lockstep
+// State is kept as structure of arrays (V[16][N], pc[N], I[N]) so that while every lane sits on the same
+// instruction, arithmetic, skips and jumps run as one loop over the lanes that the compiler turns into vector code
+// Lanes fall back to one scalar step each as soon as their program counters or opcodes disagree,
+// and rejoin the vector path by themselves once they line up again
+// Semantics follow Chip8::decode with COSMAC_VIP_QUIRKS if isOlder is set and MODERN_CHIP8_QUIRKS otherwise
+template<int N>
+class BatchedChip8 {
+    static_assert(N > 0 && N <= 64, "Lane masks are 64 bits wide");
+
+private:
+    // CPU state, lane index last so each row is one vector
+    alignas(64) uint8_t V[16][N];
+    alignas(64) uint16_t pc[N];
+    alignas(64) uint16_t I[N];
+    alignas(64) uint8_t delayTimer[N];
+    alignas(64) uint8_t soundTimer[N];
+    alignas(64) uint16_t stack[16][N];
+    alignas(64) uint8_t sp[N];
+    alignas(64) uint16_t keys[N];
+    int8_t pendingKey[N];
+
+    // Per lane memory and framebuffer, laid out like SimpleDisplay
+    std::array<std::array<uint8_t, RAM_SIZE>, N> memory;
+    std::array<std::array<uint8_t, WIDTH * HEIGHT>, N> pixels;
+
+    std::array<std::mt19937, N> engines;
+    std::uniform_int_distribution<> dist{ 0, 0xFF };
+
+    bool isOlder;
+    uint64_t isDone;        // Bit per lane, set once the lane hit an invalid instruction
+    uint64_t vectorSteps;
+    uint64_t scalarSteps;
+
+    static constexpr uint64_t ALL_LANES{ N == 64 ? ~0ULL : (1ULL << N) - 1 };
+
+    uint16_t fetch(int lane) const {
+        return (memory[lane][pc[lane] & 0xFFF] << 8) + memory[lane][(pc[lane] + 1) & 0xFFF];
+    }
+
+    // One instruction on every lane in mask. Every lane is known to share pc and opcode
+    // Returns false if the instruction has no vector form
+    bool executeVector(uint16_t ins, uint64_t mask);
+
+    // One instruction on one lane, pc already advanced. Returns false on an invalid instruction
+    bool executeScalar(int lane, uint16_t ins);
+
+public:
+    explicit BatchedChip8(bool isOlder);
+
+    // Every lane gets the same ROM
+    bool loadRom(const uint8_t* data, size_t size);
+
+    void seedRandom(int lane, uint32_t seed) {
+        engines[lane].seed(seed);
+    }
+
+    // Bit N is key N
+    void setKeyState(int lane, uint16_t mask) {
+        keys[lane] = mask;
+    }
+
+    // One 60Hz frame on every lane that is still running
+    void runFrame();
+
+    // Getter
+    [[nodiscard]] uint8_t getRegister(int lane, int x) const { return V[x][lane]; }
+    [[nodiscard]] uint16_t getPC(int lane) const { return pc[lane]; }
+    [[nodiscard]] uint16_t getIndex(int lane) const { return I[lane]; }
+    [[nodiscard]] uint8_t getDelayTimer(int lane) const { return delayTimer[lane]; }
+    [[nodiscard]] uint8_t getSoundTimer(int lane) const { return soundTimer[lane]; }
+    [[nodiscard]] const uint8_t* getMemory(int lane) const { return memory[lane].data(); }
+    [[nodiscard]] const uint8_t* getPixels(int lane) const { return pixels[lane].data(); }
+    [[nodiscard]] bool isLaneDone(int lane) const { return (isDone >> lane) & 1; }
+    [[nodiscard]] uint64_t getVectorSteps() const { return vectorSteps; }
+    [[nodiscard]] uint64_t getScalarSteps() const { return scalarSteps; }
+};
+
+
+template<int N>
+BatchedChip8<N>::BatchedChip8(bool isOlder)
+    : V{}, pc{}, I{}, delayTimer{}, soundTimer{}, stack{}, sp{}, keys{}, pendingKey{}, memory{}, pixels{},
+    isOlder{isOlder}, isDone{}, vectorSteps{}, scalarSteps{}
+{
+    for (int lane{}; lane < N; lane++) {
+        pc[lane] = 0x200;
+        pendingKey[lane] = -1;
+        for (int i{0x50}; i <= 0x9F; i++) {
+            memory[lane][i] = FONT[i - 0x50];
+        }
+    }
+}
+
+template<int N>
+bool BatchedChip8<N>::loadRom(const uint8_t* data, size_t size) {
+    if (size > RAM_SIZE - 0x200) {
+        return false;
+    }
+
+    for (int lane{}; lane < N; lane++) {
+        memcpy(memory[lane].data() + 0x200, data, size);
+    }
+    return true;
+}
+
+template<int N>
+void BatchedChip8<N>::runFrame() {
+    for (int lane{}; lane < N; lane++) {
+        delayTimer[lane] -= delayTimer[lane] > 0;
+        soundTimer[lane] -= soundTimer[lane] > 0;
+    }
+
+    // Lanes still inside this frame. A lane leaves after DXYN or an invalid instruction
+    uint64_t active{ ALL_LANES & ~isDone };
+
+    for (int count{}; count < INSTRUCTIONS_PER_FRAME && active != 0; count++) {
+        int first{};
+        while (!((active >> first) & 1)) {
+            first++;
+        }
+        uint16_t ins{ fetch(first) };
+
+        bool isLockstep{true};
+        for (int lane{first + 1}; lane < N; lane++) {
+            if ((active >> lane) & 1 && (pc[lane] != pc[first] || fetch(lane) != ins)) {
+                isLockstep = false;
+                break;
+            }
+        }
+
+        if (isLockstep && executeVector(ins, active)) {
+            vectorSteps++;
+        } else {
+            // DXYN has no vector form, so this is also where lanes leave the frame
+            for (int lane{}; lane < N; lane++) {
+                if (!((active >> lane) & 1)) {
+                    continue;
+                }
+
+                uint16_t laneIns{ fetch(lane) };
+                pc[lane] += 2;
+                if (!executeScalar(lane, laneIns)) {
+                    isDone |= 1ULL << lane;
+                    active &= ~(1ULL << lane);
+                } else if (laneIns >> 12 == 0xD) {
+                    active &= ~(1ULL << lane);
+                }
+            }
+            scalarSteps++;
+        }
+    }
+}
+
+template<int N>
+bool BatchedChip8<N>::executeVector(uint16_t ins, uint64_t mask) {
+    // Lanes outside the mask must not change, so every loop either masks or is only used when all lanes run
+    if (mask != ALL_LANES) {
+        return false;
+    }
+
+    uint8_t x = (ins >> 8) & 0xF;
+    uint8_t y = (ins >> 4) & 0xF;
+    uint8_t nn = ins & 0xFF;
+    uint16_t nnn = ins & 0xFFF;
+
+    switch (ins >> 12) {
+        case 0x1:
+            for (int l{}; l < N; l++) pc[l] = nnn;
+            return true;
+        case 0x2:
+            for (int l{}; l < N; l++) {
+                stack[sp[l] & 0xF][l] = pc[l] + 2;
+                sp[l]++;
+                pc[l] = nnn;
+            }
+            return true;
+        case 0x3:
+            for (int l{}; l < N; l++) pc[l] += 2 + ((V[x][l] == nn) << 1);
+            return true;
+        case 0x4:
+            for (int l{}; l < N; l++) pc[l] += 2 + ((V[x][l] != nn) << 1);
+            return true;
+        case 0x5:
+            for (int l{}; l < N; l++) pc[l] += 2 + ((V[x][l] == V[y][l]) << 1);
+            return true;
+        case 0x6:
+            for (int l{}; l < N; l++) V[x][l] = nn;
+            for (int l{}; l < N; l++) pc[l] += 2;
+            return true;
+        case 0x7:
+            for (int l{}; l < N; l++) V[x][l] += nn;
+            for (int l{}; l < N; l++) pc[l] += 2;
+            return true;
+        case 0x8: {
+            uint8_t* vx{ V[x] };
+            uint8_t* vy{ V[y] };
+            uint8_t* vf{ V[15] };
+            switch (ins & 0xF) {
+                case 0x0:
+                    for (int l{}; l < N; l++) vx[l] = vy[l];
+                    break;
+                case 0x1:
+                    for (int l{}; l < N; l++) vx[l] |= vy[l];
+                    for (int l{}; l < N; l++) vf[l] = 0;
+                    break;
+                case 0x2:
+                    for (int l{}; l < N; l++) vx[l] &= vy[l];
+                    for (int l{}; l < N; l++) vf[l] = 0;
+                    break;
+                case 0x3:
+                    for (int l{}; l < N; l++) vx[l] ^= vy[l];
+                    for (int l{}; l < N; l++) vf[l] = 0;
+                    break;
+                case 0x4: {
+                    uint8_t flag[N];
+                    for (int l{}; l < N; l++) flag[l] = (vx[l] + vy[l]) > 255;
+                    for (int l{}; l < N; l++) vx[l] += vy[l];
+                    for (int l{}; l < N; l++) vf[l] = flag[l];
+                    break;
+                }
+                case 0x5: {
+                    uint8_t flag[N];
+                    for (int l{}; l < N; l++) flag[l] = vx[l] >= vy[l];
+                    for (int l{}; l < N; l++) vx[l] -= vy[l];
+                    for (int l{}; l < N; l++) vf[l] = flag[l];
+                    break;
+                }
+                case 0x7: {
+                    uint8_t flag[N];
+                    for (int l{}; l < N; l++) flag[l] = vy[l] >= vx[l];
+                    for (int l{}; l < N; l++) vx[l] = vy[l] - vx[l];
+                    for (int l{}; l < N; l++) vf[l] = flag[l];
+                    break;
+                }
+                case 0x6: {
+                    uint8_t flag[N];
+                    if (isOlder) {
+                        for (int l{}; l < N; l++) vx[l] = vy[l];
+                    }
+                    for (int l{}; l < N; l++) flag[l] = vx[l] & 1;
+                    for (int l{}; l < N; l++) vx[l] >>= 1;
+                    for (int l{}; l < N; l++) vf[l] = flag[l];
+                    break;
+                }
+                case 0xE: {
+                    uint8_t flag[N];
+                    if (isOlder) {
+                        for (int l{}; l < N; l++) vx[l] = vy[l];
+                    }
+                    for (int l{}; l < N; l++) flag[l] = vx[l] >> 7;
+                    for (int l{}; l < N; l++) vx[l] <<= 1;
+                    for (int l{}; l < N; l++) vf[l] = flag[l];
+                    break;
+                }
+                default:
+                    return false;
+            }
+            for (int l{}; l < N; l++) pc[l] += 2;
+            return true;
+        }
+        case 0x9:
+            for (int l{}; l < N; l++) pc[l] += 2 + ((V[x][l] != V[y][l]) << 1);
+            return true;
+        case 0xA:
+            for (int l{}; l < N; l++) I[l] = nnn;
+            for (int l{}; l < N; l++) pc[l] += 2;
+            return true;
+        case 0xE:
+            if ((ins & 0xF) == 0xE) {
+                for (int l{}; l < N; l++) pc[l] += 2 + (((keys[l] >> (V[x][l] & 0xF)) & 1) << 1);
+                return true;
+            } else if ((ins & 0xF) == 0x1) {
+                for (int l{}; l < N; l++) pc[l] += 2 + ((~keys[l] >> (V[x][l] & 0xF) & 1) << 1);
+                return true;
+            }
+            return false;
+        case 0xF:
+            switch (nn) {
+                case 0x07:
+                    for (int l{}; l < N; l++) V[x][l] = delayTimer[l];
+                    break;
+                case 0x15:
+                    for (int l{}; l < N; l++) delayTimer[l] = V[x][l];
+                    break;
+                case 0x18:
+                    for (int l{}; l < N; l++) soundTimer[l] = V[x][l];
+                    break;
+                case 0x29:
+                    for (int l{}; l < N; l++) I[l] = (V[x][l] & 0xF) * 5 + 0x50;
+                    break;
+                default:
+                    return false;
+            }
+            for (int l{}; l < N; l++) pc[l] += 2;
+            return true;
+        default:
+            return false;
+    }
+}
+
+template<int N>
+bool BatchedChip8<N>::executeScalar(int lane, uint16_t ins) {
+    uint8_t* mem{ memory[lane].data() };
+    uint8_t x = (ins >> 8) & 0xF;
+    uint8_t y = (ins >> 4) & 0xF;
+    uint8_t nn = ins & 0xFF;
+    uint16_t nnn = ins & 0xFFF;
+    uint8_t& vx{ V[x][lane] };
+    uint8_t& vy{ V[y][lane] };
+    uint8_t& vf{ V[15][lane] };
+    uint16_t& p{ pc[lane] };
+    uint16_t& index{ I[lane] };
+
+    switch (ins >> 12) {
+        case 0x0:
+            if (ins == 0x00E0) {
+                pixels[lane].fill(0);
+            } else if (ins == 0x00EE) {
+                sp[lane]--;
+                p = stack[sp[lane] & 0xF][lane];
+            } else {
+                return false;
+            }
+            return true;
+        case 0x1:
+            p = nnn;
+            return true;
+        case 0x2:
+            stack[sp[lane] & 0xF][lane] = p;
+            sp[lane]++;
+            p = nnn;
+            return true;
+        case 0x3:
+            p += (vx == nn) << 1;
+            return true;
+        case 0x4:
+            p += (vx != nn) << 1;
+            return true;
+        case 0x5:
+            p += (vx == vy) << 1;
+            return true;
+        case 0x6:
+            vx = nn;
+            return true;
+        case 0x7:
+            vx += nn;
+            return true;
+        case 0x8: {
+            switch (ins & 0xF) {
+                case 0x0: vx = vy; return true;
+                case 0x1: vx |= vy; vf = 0; return true;
+                case 0x2: vx &= vy; vf = 0; return true;
+                case 0x3: vx ^= vy; vf = 0; return true;
+                case 0x4: {
+                    uint8_t flag = (vx + vy) > 255;
+                    vx += vy;
+                    vf = flag;
+                    return true;
+                }
+                case 0x5: {
+                    uint8_t flag = vx >= vy;
+                    vx -= vy;
+                    vf = flag;
+                    return true;
+                }
+                case 0x7: {
+                    uint8_t flag = vy >= vx;
+                    vx = vy - vx;
+                    vf = flag;
+                    return true;
+                }
+                case 0x6: {
+                    if (isOlder) vx = vy;
+                    uint8_t flag = vx & 1;
+                    vx >>= 1;
+                    vf = flag;
+                    return true;
+                }
+                case 0xE: {
+                    if (isOlder) vx = vy;
+                    uint8_t flag = vx >> 7;
+                    vx <<= 1;
+                    vf = flag;
+                    return true;
+                }
+                default:
+                    return false;
+            }
+        }
+        case 0x9:
+            p += (vx != vy) << 1;
+            return true;
+        case 0xA:
+            index = nnn;
+            return true;
+        case 0xB:
+            p = nnn + (isOlder ? V[0][lane] : vx);
+            return true;
+        case 0xC:
+            vx = dist(engines[lane]) & nn;
+            return true;
+        case 0xD: {
+            uint8_t origin_y = vy;
+            uint8_t origin_x = vx;
+            vf = 0;
+
+            for (uint8_t line{}; line < (ins & 0xF); line++) {
+                uint8_t row = (origin_y + line) % HEIGHT;
+                uint8_t column = origin_x % WIDTH;
+                uint8_t sprite{ mem[(index + line) & 0xFFF] };
+
+                for (int i{}; i < 8 && column < WIDTH; i++, column++) {
+                    if (sprite & (0x80 >> i)) {
+                        uint8_t& pixel{ pixels[lane][row * WIDTH + column] };
+                        vf |= pixel;
+                        pixel ^= 1;
+                    }
+                }
+
+                if (row >= 31) {
+                    break;
+                }
+            }
+            return true;
+        }
+        case 0xE:
+            if ((ins & 0xF) == 0xE) {
+                p += ((keys[lane] >> (vx & 0xF)) & 1) << 1;
+            } else if ((ins & 0xF) == 0x1) {
+                p += ((~keys[lane] >> (vx & 0xF)) & 1) << 1;
+            } else {
+                return false;
+            }
+            return true;
+        case 0xF:
+            switch (nn) {
+                case 0x07: vx = delayTimer[lane]; return true;
+                case 0x15: delayTimer[lane] = vx; return true;
+                case 0x18: soundTimer[lane] = vx; return true;
+                case 0x1E:
+                    index += vx;
+                    if (index >= 4096) {
+                        vf = 1;
+                        index -= 4096;
+                    }
+                    return true;
+                case 0x0A:
+                    if (pendingKey[lane] == -1) {
+                        for (int key{}; key < 16; key++) {
+                            if ((keys[lane] >> key) & 1) {
+                                vx = key;
+                                pendingKey[lane] = key;
+                                break;
+                            }
+                        }
+                        p -= 2;
+                    } else if ((keys[lane] >> pendingKey[lane]) & 1) {
+                        p -= 2;
+                    } else {
+                        pendingKey[lane] = -1;
+                    }
+                    return true;
+                case 0x29:
+                    index = (vx & 0xF) * 5 + 0x50;
+                    return true;
+                case 0x33:
+                    mem[index & 0xFFF] = vx / 100;
+                    mem[(index + 1) & 0xFFF] = (vx % 100) / 10;
+                    mem[(index + 2) & 0xFFF] = vx % 10;
+                    return true;
+                case 0x55:
+                    for (uint8_t i{}; i <= x; i++) {
+                        mem[(index + i) & 0xFFF] = V[i][lane];
+                    }
+                    if (isOlder) index += x + 1;
+                    return true;
+                case 0x65:
+                    for (uint8_t i{}; i <= x; i++) {
+                        V[i][lane] = mem[(index + i) & 0xFFF];
+                    }
+                    if (isOlder) index += x + 1;
+                    return true;
+                default:
+                    return false;
+            }
+        default:
+            return false;
+    }
+}
+
+#endif
@@ -1,8 +1,23 @@
 #ifndef CHIP8_EMULATOR_EMULATOR_H
 #define CHIP8_EMULATOR_EMULATOR_H
 
+#include <cstddef>
+#include <cstdint>
 #include <string>
+#include "../extras/audio_output.h"
+#include "../extras/debugger.h"
 #include "../extras/input_handler.h"
+#include "../extras/profiler.h"
+#include "../extras/run_control.h"
+#include "../extras/tracer.h"
+
+// Where a cooperative step handed the thread back
+enum class StepResult : uint8_t {
+    FRAME,    // A frame ended
+    KEY_WAIT, // FX0A started waiting for a key mid frame, the next step finishes the frame
+    STOPPED,  // The attached Debugger is stopped
+    EXITED    // The ROM exited or hit an instruction that cannot be decoded
+};
 
 // Interface for Chip8, SChip and XOChip
 class Emulator {
@@ -12,7 +27,42 @@ protected:
 
 public:
     virtual ~Emulator() = default;
-    virtual void run(std::string& filename, bool& stopSignal) {};
+    virtual void run(std::string& filename, RunControl& control) {};
+
+    // Paced run of whatever is loaded, after loadRom or loadState, until control stops it or the ROM exits
+    // Pausing, stepping and the speed multiplier take effect at the next frame boundary
+    virtual void resume(RunControl& control) = 0;
+
+    virtual bool loadRom(const uint8_t* data, size_t size) = 0;
+    virtual bool runFrames(int frameCount) = 0;
+
+    // Runs until the end of the frame or the first FX0A of the frame that waits, then returns
+    // Lets a scheduler interleave many cores on one thread instead of giving each a blocking run loop
+    virtual StepResult step() = 0;
+
+    // Runs one instruction, mid frame if it has to, the frame ends with its last instruction
+    // Breakpoints of an attached Debugger are not checked for it. Returns false once the ROM exits
+    virtual bool runInstruction() = 0;
+
+    virtual bool saveState(const std::string& path) const = 0;
+    virtual bool loadState(const std::string& path) = 0;
+
+    virtual void setProfiler(ExecutionProfiler* executionProfiler) = 0;
+    virtual void setTracer(InstructionTracer* instructionTracer) = 0;
+    virtual void setAudioOutput(AudioOutput* audioOutput) = 0;
+    virtual void setDebugger(Debugger* instructionDebugger) = 0;
+    virtual void setInstructionsPerFrame(int count) = 0;
+    virtual void setRunAheadFrames(int count) = 0;
+
+    // Machine state for debuggers, only while the core is not running or stopped by its Debugger
+    [[nodiscard]] virtual DebugRegisters getDebugRegisters() const = 0;
+    virtual void setDebugRegisters(const DebugRegisters& debugRegisters) = 0;
+    [[nodiscard]] virtual uint8_t readMemory(uint16_t address) const = 0;
+    virtual void writeMemory(uint16_t address, uint8_t value) = 0;
+
+    // Totals since construction, updated at the end of every frame
+    [[nodiscard]] virtual uint64_t getInstructionCount() const = 0;
+    [[nodiscard]] virtual uint64_t getFrameCount() const = 0;
 };
 
 #endif
@@ -0,0 +1,82 @@
+#ifndef CHIP8_EMULATOR_FUSION_H
+#define CHIP8_EMULATOR_FUSION_H
+
+#include <array>
+#include <cstdint>
+#include "../constants.h"
+#include "../extras/paged_memory.h"
+
+// Instruction pairs the release loop runs in one dispatch, picked from the opcode pair counts of the profiler
+// over test_roms. None of them reads keys or random numbers, so running the second one without its own
+// input event replay changes nothing the ROM can see
+enum class Fusion : uint8_t {
+    NONE,
+    SET_SET,    // 6XNN 6YNN
+    ADD_ADD,    // 7XNN 7YNN
+    ADD_SKIP,   // 7XNN 3YNN/4YNN
+    SKIP_JUMP,  // 3XNN/4XNN/5XY0/9XY0 1NNN
+    INDEX_DRAW, // ANNN DXYN
+    INDEX_ADD,  // ANNN FX1E
+    INDEX_LOAD  // ANNN FX65
+};
+
+constexpr Fusion classifyFusion(uint16_t first, uint16_t second) {
+    switch (first >> 12) {
+        case 0x3:
+        case 0x4:
+        case 0x5:
+        case 0x9:
+            return second >> 12 == 0x1 ? Fusion::SKIP_JUMP : Fusion::NONE;
+        case 0x6:
+            return second >> 12 == 0x6 ? Fusion::SET_SET : Fusion::NONE;
+        case 0x7:
+            if (second >> 12 == 0x7) {
+                return Fusion::ADD_ADD;
+            }
+            return second >> 12 == 0x3 || second >> 12 == 0x4 ? Fusion::ADD_SKIP : Fusion::NONE;
+        case 0xA:
+            if (second >> 12 == 0xD) {
+                return Fusion::INDEX_DRAW;
+            }
+            if ((second & 0xF0FF) == 0xF01E) {
+                return Fusion::INDEX_ADD;
+            }
+            return (second & 0xF0FF) == 0xF065 ? Fusion::INDEX_LOAD : Fusion::NONE;
+        default:
+            return Fusion::NONE;
+    }
+}
+
+// Fusion of the pair starting at every address of RAM
+// An entry is either NONE or matches the bytes in memory, so every write to RAM has to invalidate the entries
+// it overlaps before the next instruction runs
+class FusionTable {
+private:
+    std::array<Fusion, RAM_SIZE> fusions;
+
+public:
+    FusionTable() {
+        fusions.fill(Fusion::NONE);
+    }
+
+    void build(const PagedMemory& memory) {
+        for (int address{}; address < RAM_SIZE; address++) {
+            uint16_t first{ (uint16_t) (memory[address] << 8 | memory[address + 1]) };
+            uint16_t second{ (uint16_t) (memory[address + 2] << 8 | memory[address + 3]) };
+            fusions[address] = classifyFusion(first, second);
+        }
+    }
+
+    // Self modifying code loses its fusions until the next build, pairs cover the three bytes before a write
+    void invalidate(uint16_t address, int size) {
+        for (int i{-3}; i < size; i++) {
+            fusions[(address + i) & (RAM_SIZE - 1)] = Fusion::NONE;
+        }
+    }
+
+    Fusion operator[](uint16_t address) const {
+        return fusions[address & (RAM_SIZE - 1)];
+    }
+};
+
+#endif
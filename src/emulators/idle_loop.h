@@ -0,0 +1,88 @@
+#ifndef CHIP8_EMULATOR_IDLE_LOOP_H
+#define CHIP8_EMULATOR_IDLE_LOOP_H
+
+#include <algorithm>
+#include <cstdint>
+#include <vector>
+#include "../extras/input_handler.h"
+#include "../extras/paged_memory.h"
+
+// Loops that leave the machine exactly as they found it on every pass until a timer tick or key change
+// Running them again changes nothing but the instruction count, so whole passes can be skipped
+struct IdleLoop {
+    int length;        // Instructions per pass, 0 if there is no idle loop
+    bool isInputBound; // Ends on a key change rather than at the next frame
+    int delayRegister; // Register every pass loads the delay timer into, -1 if none
+};
+
+// Called after ins at address ran and moved the program counter back to pc
+// Recognises a jump to self, FX0A waiting for a key, "FX07; 3XNN/4XNN; 1NNN" waiting on the delay timer
+// and "(6XNN;) EX9E/EXA1; 1NNN" polling a key
+inline IdleLoop findIdleLoop(const PagedMemory& memory, uint16_t address, uint16_t ins, uint16_t pc,
+                             const std::vector<uint8_t>& registers, uint8_t delayTimer, InputHandler& inputHandler) {
+    if (pc == address) {
+        if (ins >> 12 == 0x1) {
+            return { 1, false, -1 };
+        }
+        // FX0A that repeats has either nothing to register or registered its key and waits for the release
+        if ((ins & 0xF0FF) == 0xF00A) {
+            return { 1, true, -1 };
+        }
+        return { 0, false, -1 };
+    }
+
+    if (ins >> 12 != 0x1) {
+        return { 0, false, -1 };
+    }
+
+    uint16_t first{ (uint16_t) (memory[pc] << 8 | memory[pc + 1]) };
+    uint16_t second{ (uint16_t) (memory[pc + 2] << 8 | memory[pc + 3]) };
+    uint8_t x{ (uint8_t) ((first >> 8) & 0xF) };
+
+    // The jump is the only way out of the skip, so the loop goes round again while the skip is not taken
+    if (address == pc + 4 && (first & 0xF0FF) == 0xF007 && ((second >> 8) & 0xF) == x) {
+        if (second >> 12 == 0x3 && delayTimer != (second & 0xFF)) {
+            return { 3, false, x };
+        }
+        if (second >> 12 == 0x4 && delayTimer == (second & 0xFF)) {
+            return { 3, false, x };
+        }
+        return { 0, false, -1 };
+    }
+
+    // Key in a register that the loop either leaves alone or sets to the same value every pass
+    uint16_t skip{ first };
+    int length{ 2 };
+    if (address == pc + 4 && first >> 12 == 0x6 && ((second >> 8) & 0xF) == x) {
+        skip = second;
+        length = 3;
+    } else if (address != pc + 2) {
+        return { 0, false, -1 };
+    }
+
+    bool isPressed{ inputHandler.isKeyPressed(registers[(skip >> 8) & 0xF] & 0xF) };
+    if (((skip & 0xF0FF) == 0xE09E && !isPressed) || ((skip & 0xF0FF) == 0xE0A1 && isPressed)) {
+        return { length, true, -1 };
+    }
+    return { 0, false, -1 };
+}
+
+// Instructions that can be skipped from the one at index next, in whole passes of loop
+// Each instruction of a frame applies the input events up to its own time in the window, so input bound loops stop
+// before the first instruction that would see a queued event
+inline int idleInstructionsToSkip(const IdleLoop& loop, int next, int instructionsPerFrame, uint64_t inputWindowStart,
+                                  uint64_t inputWindow, const InputHandler& inputHandler) {
+    int limit{ instructionsPerFrame };
+    uint64_t eventTime{ inputHandler.getNextEventTime() };
+    if (loop.isInputBound && eventTime < inputWindowStart + inputWindow) {
+        uint64_t delay{ eventTime > inputWindowStart ? eventTime - inputWindowStart : 0 };
+        limit = delay == 0 ? 0 : (int) std::min<uint64_t>(limit, (delay * instructionsPerFrame + inputWindow - 1) / inputWindow);
+    }
+
+    if (limit <= next) {
+        return 0;
+    }
+    return (limit - next) / loop.length * loop.length;
+}
+
+#endif
@@ -0,0 +1,157 @@
+#ifndef CHIP8_EMULATOR_OPCODES_H
+#define CHIP8_EMULATOR_OPCODES_H
+
+#include <cstdint>
+
+// Every instruction form understood by Chip8::decode and SChip::decode
+// Used by tooling (profiler, disassembler) to name instructions without decoding them
+enum class Opcode : uint8_t {
+    SCROLL_DOWN,     // 00CN
+    CLEAR,           // 00E0
+    RETURN,          // 00EE
+    SCROLL_RIGHT,    // 00FB
+    SCROLL_LEFT,     // 00FC
+    EXIT,            // 00FD
+    LORES,           // 00FE
+    HIRES,           // 00FF
+    JUMP,            // 1NNN
+    CALL,            // 2NNN
+    SKIP_EQ_IMM,     // 3XNN
+    SKIP_NE_IMM,     // 4XNN
+    SKIP_EQ_REG,     // 5XY0
+    SET_IMM,         // 6XNN
+    ADD_IMM,         // 7XNN
+    SET_REG,         // 8XY0
+    OR,              // 8XY1
+    AND,             // 8XY2
+    XOR,             // 8XY3
+    ADD_REG,         // 8XY4
+    SUB,             // 8XY5
+    SHIFT_RIGHT,     // 8XY6
+    SUB_REVERSE,     // 8XY7
+    SHIFT_LEFT,      // 8XYE
+    SKIP_NE_REG,     // 9XY0
+    SET_INDEX,       // ANNN
+    JUMP_OFFSET,     // BNNN
+    RANDOM,          // CXNN
+    DRAW,            // DXYN
+    DRAW_BIG,        // DXY0
+    SKIP_KEY,        // EX9E
+    SKIP_NOT_KEY,    // EXA1
+    GET_DELAY,       // FX07
+    WAIT_KEY,        // FX0A
+    SET_DELAY,       // FX15
+    SET_SOUND,       // FX18
+    ADD_INDEX,       // FX1E
+    FONT,            // FX29
+    BIG_FONT,        // FX30
+    BCD,             // FX33
+    STORE,           // FX55
+    LOAD,            // FX65
+    SAVE_FLAGS,      // FX75
+    LOAD_FLAGS,      // FX85
+    INVALID,
+    COUNT
+};
+
+constexpr int OPCODE_COUNT{ static_cast<int>(Opcode::COUNT) };
+
+constexpr const char* OPCODE_PATTERNS[OPCODE_COUNT]{
+        "00CN", "00E0", "00EE", "00FB", "00FC", "00FD", "00FE", "00FF",
+        "1NNN", "2NNN", "3XNN", "4XNN", "5XY0", "6XNN", "7XNN",
+        "8XY0", "8XY1", "8XY2", "8XY3", "8XY4", "8XY5", "8XY6", "8XY7", "8XYE",
+        "9XY0", "ANNN", "BNNN", "CXNN", "DXYN", "DXY0", "EX9E", "EXA1",
+        "FX07", "FX0A", "FX15", "FX18", "FX1E", "FX29", "FX30", "FX33", "FX55", "FX65", "FX75", "FX85",
+        "????"
+};
+
+// Mirrors the switch in SChip::decode. Chip8 rejects the SCHIP only forms at decode time
+constexpr Opcode classifyOpcode(uint16_t ins) {
+    switch (ins >> 12) {
+        case 0x0:
+            if ((ins >> 4) == 0xC) return Opcode::SCROLL_DOWN;
+            switch (ins) {
+                case 0x00E0: return Opcode::CLEAR;
+                case 0x00EE: return Opcode::RETURN;
+                case 0x00FB: return Opcode::SCROLL_RIGHT;
+                case 0x00FC: return Opcode::SCROLL_LEFT;
+                case 0x00FD: return Opcode::EXIT;
+                case 0x00FE: return Opcode::LORES;
+                case 0x00FF: return Opcode::HIRES;
+                default: return Opcode::INVALID;
+            }
+        case 0x1: return Opcode::JUMP;
+        case 0x2: return Opcode::CALL;
+        case 0x3: return Opcode::SKIP_EQ_IMM;
+        case 0x4: return Opcode::SKIP_NE_IMM;
+        case 0x5: return Opcode::SKIP_EQ_REG;
+        case 0x6: return Opcode::SET_IMM;
+        case 0x7: return Opcode::ADD_IMM;
+        case 0x8:
+            switch (ins % 0x10) {
+                case 0x0: return Opcode::SET_REG;
+                case 0x1: return Opcode::OR;
+                case 0x2: return Opcode::AND;
+                case 0x3: return Opcode::XOR;
+                case 0x4: return Opcode::ADD_REG;
+                case 0x5: return Opcode::SUB;
+                case 0x6: return Opcode::SHIFT_RIGHT;
+                case 0x7: return Opcode::SUB_REVERSE;
+                case 0xE: return Opcode::SHIFT_LEFT;
+                default: return Opcode::INVALID;
+            }
+        case 0x9: return Opcode::SKIP_NE_REG;
+        case 0xA: return Opcode::SET_INDEX;
+        case 0xB: return Opcode::JUMP_OFFSET;
+        case 0xC: return Opcode::RANDOM;
+        case 0xD: return ins % 0x10 == 0 ? Opcode::DRAW_BIG : Opcode::DRAW;
+        case 0xE:
+            if (ins % 0x10 == 0xE) return Opcode::SKIP_KEY;
+            if (ins % 0x10 == 0x1) return Opcode::SKIP_NOT_KEY;
+            return Opcode::INVALID;
+        case 0xF:
+            switch (ins % 0x100) {
+                case 0x07: return Opcode::GET_DELAY;
+                case 0x0A: return Opcode::WAIT_KEY;
+                case 0x15: return Opcode::SET_DELAY;
+                case 0x18: return Opcode::SET_SOUND;
+                case 0x1E: return Opcode::ADD_INDEX;
+                case 0x29: return Opcode::FONT;
+                case 0x30: return Opcode::BIG_FONT;
+                case 0x33: return Opcode::BCD;
+                case 0x55: return Opcode::STORE;
+                case 0x65: return Opcode::LOAD;
+                case 0x75: return Opcode::SAVE_FLAGS;
+                case 0x85: return Opcode::LOAD_FLAGS;
+                default: return Opcode::INVALID;
+            }
+        default:
+            return Opcode::INVALID;
+    }
+}
+
+// Mirrors the switch in Chip8::decode, which has no SCHIP forms and draws DXY0 as a sprite of no rows
+constexpr Opcode classifyChip8Opcode(uint16_t ins) {
+    switch (classifyOpcode(ins)) {
+        case Opcode::SCROLL_DOWN:
+        case Opcode::SCROLL_RIGHT:
+        case Opcode::SCROLL_LEFT:
+        case Opcode::EXIT:
+        case Opcode::LORES:
+        case Opcode::HIRES:
+        case Opcode::BIG_FONT:
+        case Opcode::SAVE_FLAGS:
+        case Opcode::LOAD_FLAGS:
+            return Opcode::INVALID;
+        case Opcode::DRAW_BIG:
+            return Opcode::DRAW;
+        default:
+            return classifyOpcode(ins);
+    }
+}
+
+constexpr const char* opcodePattern(Opcode op) {
+    return OPCODE_PATTERNS[static_cast<int>(op)];
+}
+
+#endif
@@ -0,0 +1,108 @@
+#ifndef CHIP8_EMULATOR_QUIRKS_H
+#define CHIP8_EMULATOR_QUIRKS_H
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <type_traits>
+#include <utility>
+
+// Behaviours that CHIP-8 interpreters disagree on and ROMs were written against
+// Cores are compiled once per combination, so QuirkFlags below must be a compile time constant in the hot path
+struct Quirks {
+    bool shiftUsesVY;          // 8XY6 and 8XYE copy VY into VX before shifting
+    bool loadStoreIncrementsI; // FX55 and FX65 leave I pointing past the last register
+    bool jumpUsesVX;           // BXNN jumps to XNN + VX instead of NNN + V0
+    bool vblankWait;           // DXYN ends the frame, like waiting for the vertical interrupt
+    bool clipSprites;          // Sprites are cut off at the screen edge instead of wrapping around
+    bool logicResetsVF;        // 8XY1, 8XY2 and 8XY3 clear VF
+
+    [[nodiscard]] constexpr uint8_t getFlags() const;
+    static constexpr Quirks fromFlags(uint8_t flags);
+};
+
+namespace QuirkFlags {
+    constexpr uint8_t SHIFT_USES_VY{1 << 0};
+    constexpr uint8_t LOAD_STORE_INCREMENTS_I{1 << 1};
+    constexpr uint8_t JUMP_USES_VX{1 << 2};
+    constexpr uint8_t VBLANK_WAIT{1 << 3};
+    constexpr uint8_t CLIP_SPRITES{1 << 4};
+    constexpr uint8_t LOGIC_RESETS_VF{1 << 5};
+
+    // Not a quirk, added by the cores when their display is a plain framebuffer so the release loop draws inline
+    constexpr uint8_t FRAMEBUFFER_DISPLAY{1 << 6};
+    constexpr int COMBINATIONS{1 << 7};
+
+    // VBLANK_WAIT only changes the frame loop, so decode is instantiated with it cleared
+    constexpr uint8_t DECODE_FLAGS{(uint8_t) ~VBLANK_WAIT};
+    // Profiled, traced and debugged runs keep the virtual display calls instead of doubling their instantiations
+    constexpr uint8_t DIAGNOSTIC_FLAGS{(uint8_t) ~FRAMEBUFFER_DISPLAY};
+}
+
+constexpr uint8_t Quirks::getFlags() const {
+    return (shiftUsesVY ? QuirkFlags::SHIFT_USES_VY : 0)
+        | (loadStoreIncrementsI ? QuirkFlags::LOAD_STORE_INCREMENTS_I : 0)
+        | (jumpUsesVX ? QuirkFlags::JUMP_USES_VX : 0)
+        | (vblankWait ? QuirkFlags::VBLANK_WAIT : 0)
+        | (clipSprites ? QuirkFlags::CLIP_SPRITES : 0)
+        | (logicResetsVF ? QuirkFlags::LOGIC_RESETS_VF : 0);
+}
+
+constexpr Quirks Quirks::fromFlags(uint8_t flags) {
+    return {
+        (flags & QuirkFlags::SHIFT_USES_VY) != 0,
+        (flags & QuirkFlags::LOAD_STORE_INCREMENTS_I) != 0,
+        (flags & QuirkFlags::JUMP_USES_VX) != 0,
+        (flags & QuirkFlags::VBLANK_WAIT) != 0,
+        (flags & QuirkFlags::CLIP_SPRITES) != 0,
+        (flags & QuirkFlags::LOGIC_RESETS_VF) != 0
+    };
+}
+
+// Profiles
+// The original interpreter on the COSMAC VIP
+constexpr Quirks COSMAC_VIP_QUIRKS{ true, true, false, true, true, true };
+// VIP timing and drawing, with the shift, load/store and jump behaviour most later CHIP-8 games assume
+constexpr Quirks MODERN_CHIP8_QUIRKS{ false, false, true, true, true, true };
+// SUPER-CHIP 1.1 on the HP 48
+constexpr Quirks SCHIP_QUIRKS{ false, false, true, false, true, false };
+// XO-CHIP as implemented by Octo
+constexpr Quirks XO_CHIP_QUIRKS{ true, true, false, false, false, false };
+
+// Looks up a profile by name ("vip", "chip8", "schip", "xochip"), returns false if there is none
+inline bool findQuirksProfile(const std::string& name, Quirks& quirks) {
+    if (name == "vip") {
+        quirks = COSMAC_VIP_QUIRKS;
+    } else if (name == "chip8") {
+        quirks = MODERN_CHIP8_QUIRKS;
+    } else if (name == "schip") {
+        quirks = SCHIP_QUIRKS;
+    } else if (name == "xochip") {
+        quirks = XO_CHIP_QUIRKS;
+    } else {
+        return false;
+    }
+    return true;
+}
+
+// Calls fn(std::integral_constant<uint8_t, QuirkFlags>{}) with the runtime flags turned into a template argument
+// One table lookup per call, the code inside fn sees the quirks as constants
+template<typename Fn, size_t Flags>
+decltype(auto) invokeWithQuirks(Fn& fn) {
+    return fn(std::integral_constant<uint8_t, (uint8_t) Flags>{});
+}
+
+template<typename Fn, size_t... Flags>
+decltype(auto) dispatchQuirks(uint8_t flags, Fn& fn, std::index_sequence<Flags...>) {
+    using Result = decltype(fn(std::integral_constant<uint8_t, 0>{}));
+    static constexpr std::array<Result (*)(Fn&), sizeof...(Flags)> table{ &invokeWithQuirks<Fn, Flags>... };
+    return table[flags % sizeof...(Flags)](fn);
+}
+
+template<typename Fn>
+decltype(auto) dispatchQuirks(uint8_t flags, Fn&& fn) {
+    return dispatchQuirks(flags, fn, std::make_index_sequence<QuirkFlags::COMBINATIONS>{});
+}
+
+#endif
@@ -0,0 +1,174 @@
+#include <cstdio>
+#include "idle_loop.h"
+#include "recompiled_chip8.h"
+
+RecompiledChip8::RecompiledChip8(SimpleDisplay& display, InputHandler& inputHandler, const Quirks& quirks,
+                                 const RecompiledRom& compiled)
+    : Chip8(display, inputHandler, quirks), compiled{compiled}, isCompiled{}, frameInstruction{}, inputWindowStart{},
+    isFrameOver{}, isDecodeFailed{}
+{
+    for (size_t i{}; i + 1 < compiled.blockCount * 2; i += 2) {
+        for (uint32_t address{ compiled.blocks[i] }; address < compiled.blocks[i + 1] && address < RAM_SIZE; address++) {
+            compiledCode.set(address);
+        }
+    }
+}
+
+void RecompiledChip8::checkCompiledCode() {
+    isCompiled = true;
+    for (size_t i{}; i < compiled.size && isCompiled; i++) {
+        isCompiled = memory[0x200 + i] == compiled.rom[i];
+    }
+}
+
+// Only ever drops the compiled code, bytes of the ROM outside the compiled blocks are data the program may change
+void RecompiledChip8::checkCompiledBlocks() {
+    for (size_t i{}; i < compiled.size && isCompiled; i++) {
+        isCompiled = !compiledCode.test(0x200 + i) || memory[0x200 + i] == compiled.rom[i];
+    }
+}
+
+bool RecompiledChip8::loadRom(const uint8_t* data, size_t size) {
+    if (!Chip8::loadRom(data, size)) {
+        return false;
+    }
+    checkCompiledCode();
+    return true;
+}
+
+bool RecompiledChip8::loadState(const std::string& path) {
+    if (!Chip8::loadState(path)) {
+        return false;
+    }
+    checkCompiledCode();
+    return true;
+}
+
+void RecompiledChip8::reset(const RomImage& image, uint32_t seed) {
+    Chip8::reset(image, seed);
+    checkCompiledCode();
+}
+
+void RecompiledChip8::loadSnapshot(const Chip8Snapshot& snapshot) {
+    Chip8::loadSnapshot(snapshot);
+    checkCompiledCode();
+}
+
+void RecompiledChip8::writeMemory(uint16_t address, uint8_t value) {
+    if (compiledCode.test(address % RAM_SIZE)) {
+        isCompiled = false;
+    }
+    Chip8::writeMemory(address, value);
+}
+
+bool RecompiledChip8::interpret(uint16_t ins) {
+    uint16_t address{ (uint16_t) (program_counter - 2) };
+
+    // Stores into compiled code
+    int written{};
+    if ((ins & 0xF0FF) == 0xF033) {
+        written = 3;
+    } else if ((ins & 0xF0FF) == 0xF055) {
+        written = ((ins >> 8) & 0xF) + 1;
+    }
+    for (int i{}; i < written; i++) {
+        if (compiledCode.test((index_register + i) % RAM_SIZE)) {
+            isCompiled = false;
+        }
+    }
+
+    if (!decode(ins)) {
+        isDecodeFailed = true;
+        isFrameOver = true;
+        return false;
+    }
+
+    if (program_counter <= address) {
+        skipIdleLoop(address, ins);
+    }
+
+    // DXYN waits for the next vertical interrupt
+    if ((quirks.getFlags() & QuirkFlags::VBLANK_WAIT) != 0 && ins >> 12 == 0xD) {
+        isFrameOver = true;
+    }
+    return program_counter == address + 2 && !isFrameOver && isCompiled;
+}
+
+void RecompiledChip8::skipIdleLoop(uint16_t address, uint16_t ins) {
+    IdleLoop loop{ findIdleLoop(memory, address, ins, program_counter, registers, delay_timer, inputHandler) };
+    int skipped{ loop.length > 0 ? idleInstructionsToSkip(loop, frameInstruction, instructionsPerFrame, inputWindowStart, FRAME_DURATION_NS, inputHandler) : 0 };
+
+    // The timer may have ticked since this pass loaded it, the skipped passes leave the new value
+    if (skipped > 0 && loop.delayRegister >= 0) {
+        registers[loop.delayRegister] = delay_timer;
+    }
+    frameInstruction += skipped;
+}
+
+// Same steps as the release loop of Chip8::runFrame for one instruction
+bool RecompiledChip8::interpretInstruction() {
+    inputHandler.applyEvents(inputWindowStart + frameInstruction * FRAME_DURATION_NS / instructionsPerFrame);
+    uint16_t ins = (memory[program_counter] << 8) + memory[program_counter + 1];
+    program_counter += 2;
+    frameInstruction++;
+
+    interpret(ins);
+    if (isDecodeFailed) {
+        printf("Instruction: %d. Program Counter: %d.\n", ins, program_counter - 2);
+        return false;
+    }
+    return true;
+}
+
+bool RecompiledChip8::runFrames(int frameCount) {
+    if (profiler != nullptr || tracer != nullptr || debugger != nullptr || resumeInstruction >= 0) {
+        bool isRunning{ Chip8::runFrames(frameCount) };
+        checkCompiledBlocks();
+        return isRunning;
+    }
+
+    for (int frame{}; frame < frameCount; frame++) {
+        if (delay_timer > 0) {
+            delay_timer--;
+        }
+
+        if (sound_timer > 0) {
+            sound_timer--;
+        }
+
+        frameInstruction = 0;
+        inputWindowStart = InputHandler::now();
+        isFrameOver = false;
+        isDecodeFailed = false;
+        while (frameInstruction < instructionsPerFrame && !isFrameOver) {
+            if (isCompiled) {
+                compiled.run(*this);
+                if (frameInstruction >= instructionsPerFrame || isFrameOver) {
+                    break;
+                }
+            }
+
+            // Control left the compiled blocks
+            if (!interpretInstruction()) {
+                instructionCount += frameInstruction - 1;
+                return false;
+            }
+        }
+
+        instructionCount += frameInstruction;
+        framesCompleted++;
+        display.updateWindowSurface();
+    }
+    return true;
+}
+
+bool RecompiledChip8::runInstruction() {
+    bool isRunning{ Chip8::runInstruction() };
+    checkCompiledBlocks();
+    return isRunning;
+}
+
+void RecompiledChip8::resume(RunControl& control) {
+    Chip8::resume(control);
+    checkCompiledBlocks();
+}
@@ -0,0 +1,121 @@
+#ifndef CHIP8_EMULATOR_RECOMPILED_CHIP8_H
+#define CHIP8_EMULATOR_RECOMPILED_CHIP8_H
+
+#include <bitset>
+#include <cstddef>
+#include <cstdint>
+#include "../constants.h"
+#include "chip8.h"
+
+class RecompiledChip8;
+
+// A ROM turned into C++ by rom_recompiler
+struct RecompiledRom {
+    const char* name;
+    const uint8_t* rom;             // Bytes the code was compiled from, loaded at 0x200
+    size_t size;
+    const uint16_t* blocks;         // Start and end of every compiled block
+    size_t blockCount;
+    void (*run)(RecompiledChip8& core); // Runs compiled code from the program counter until the frame ends
+                                        // or control reaches code that was not compiled
+};
+
+// Chip8 that runs the blocks of a recompiled ROM and interprets everything else
+// The blocks drive the same registers, stack, display, input and timers as the interpreter, one instruction
+// at a time, so frames, input replay and instruction counts match Chip8::runFrames exactly
+// Compiled code is dropped until the next load as soon as the ROM it came from is not in RAM any more,
+// a write by FX33, FX55 or writeMemory to compiled code falls back to the interpreter for good
+// Runs that go through Chip8 do not report their stores, so the compiled code is compared with the ROM after them
+class RecompiledChip8 : public Chip8 {
+private:
+    const RecompiledRom& compiled;
+    std::bitset<RAM_SIZE> compiledCode; // Every byte of every compiled block
+    bool isCompiled;                    // RAM still holds the compiled ROM
+
+    // Frame in progress
+    int frameInstruction;
+    uint64_t inputWindowStart;
+    bool isFrameOver;
+    bool isDecodeFailed;
+
+    void checkCompiledCode();
+    void checkCompiledBlocks();
+    bool interpretInstruction();
+
+public:
+    RecompiledChip8(SimpleDisplay& display, InputHandler& inputHandler, const Quirks& quirks, const RecompiledRom& compiled);
+
+    [[nodiscard]] bool isRunningCompiledCode() const {
+        return isCompiled;
+    }
+
+    bool loadRom(const uint8_t* data, size_t size) override;
+    bool loadState(const std::string& path) override;
+    void reset(const RomImage& image, uint32_t seed) override;
+    void loadSnapshot(const Chip8Snapshot& snapshot) override;
+    void writeMemory(uint16_t address, uint8_t value) override;
+
+    // Profiled, traced and debugged runs go through the interpreter, and so do paced runs and single instructions
+    bool runFrames(int frameCount) override;
+    bool runInstruction() override;
+    void resume(RunControl& control) override;
+
+    // Used by generated code
+    uint8_t* getRegisterFile() {
+        return registers.data();
+    }
+
+    uint16_t& getIndexRegister() {
+        return index_register;
+    }
+
+    uint8_t& getDelayTimer() {
+        return delay_timer;
+    }
+
+    uint8_t& getSoundTimer() {
+        return sound_timer;
+    }
+
+    [[nodiscard]] uint16_t getPC() const {
+        return program_counter;
+    }
+
+    void setPC(uint16_t address) {
+        program_counter = address;
+    }
+
+    // Starts the instruction at address, or leaves the program counter on it if the frame is over
+    bool begin(uint16_t address) {
+        if (frameInstruction >= instructionsPerFrame || isFrameOver || !isCompiled) {
+            program_counter = address;
+            return false;
+        }
+        inputHandler.applyEvents(inputWindowStart + frameInstruction * FRAME_DURATION_NS / instructionsPerFrame);
+        frameInstruction++;
+        program_counter = address + 2;
+        return true;
+    }
+
+    void call() {
+        stack[stack_pointer & (STACK_SIZE - 1)] = program_counter;
+        stack_pointer++;
+    }
+
+    void returnFromSubroutine() {
+        stack_pointer--;
+        program_counter = stack[stack_pointer & (STACK_SIZE - 1)];
+    }
+
+    bool isKeyPressed(uint8_t key) {
+        return inputHandler.isKeyPressed(key);
+    }
+
+    // Runs ins on the interpreter, false if the compiled code has to dispatch again on the program counter
+    bool interpret(uint16_t ins);
+
+    // After ins at address moved the program counter back, skips idle passes the way the release loop does
+    void skipIdleLoop(uint16_t address, uint16_t ins);
+};
+
+#endif
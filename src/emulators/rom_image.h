@@ -0,0 +1,14 @@
+#ifndef CHIP8_EMULATOR_ROM_IMAGE_H
+#define CHIP8_EMULATOR_ROM_IMAGE_H
+
+#include "../extras/paged_memory.h"
+#include "fusion.h"
+
+// RAM of a core right after loadRom, fonts and ROM, with its fusions, built once by the core's buildRomImage
+// A reset shares the image pages until the ROM writes to them, so it copies page pointers and the fusion table only
+struct RomImage {
+    PagedMemory memory;
+    FusionTable fusions;
+};
+
+#endif
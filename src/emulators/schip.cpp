@@ -1,26 +1,163 @@
+#include <algorithm>
 #include <cstdio>
-#include <iostream>
 #include <thread>
+#include <type_traits>
+#include <typeinfo>
+#include <cstring>
 #include <fstream>
+#include <iterator>
 #include <chrono>
- #include "schip.h"
+#include <sstream>
+#include "schip.h"
 #include "../constants.h"
-
-#ifdef DEBUG
-#define DEBUG_MSG(str) do { std::cout << str << std::endl; } while( false )
-#else
-#define DEBUG_MSG(str) do { } while ( false )
-#endif
+#include "../extras/save_state.h"
+#include "idle_loop.h"
 
 // Main
-void SChip::run(std::string& filename, bool& stopSignal) {
+void SChip::run(std::string& filename, RunControl& control) {
     if (!fetch(filename)) {
         return;
     }
 
-    while (!stopSignal) {
-        auto start {std::chrono::high_resolution_clock::now()};
+    resume(control);
+}
+
+void SChip::resume(RunControl& control) {
+    // Every quirk combination is a separate instantiation, and so is the loop without profiler, tracer and debugger,
+    // so the normal loop carries none of their checks. A debugger on its own keeps the normal loop with block checks
+    dispatchQuirks(getRunFlags(), [&](auto flags) {
+        constexpr uint8_t quirkFlags{ decltype(flags)::value };
+        if (profiler == nullptr && tracer == nullptr && debugger == nullptr) {
+            NullProfiler nullProfiler{};
+            NullTracer nullTracer{};
+            NullDebugger nullDebugger{};
+            runLoop<quirkFlags>(control, nullProfiler, nullTracer, nullDebugger);
+        } else if (profiler == nullptr && tracer == nullptr) {
+            NullProfiler nullProfiler{};
+            NullTracer nullTracer{};
+            BlockDebugger blockDebugger{ *debugger };
+            runLoop<quirkFlags>(control, nullProfiler, nullTracer, blockDebugger);
+        } else {
+            OptionalProfiler optionalProfiler{ profiler };
+            OptionalTracer optionalTracer{ tracer };
+            OptionalDebugger optionalDebugger{ debugger };
+            runLoop<quirkFlags & QuirkFlags::DIAGNOSTIC_FLAGS>(control, optionalProfiler, optionalTracer, optionalDebugger);
+        }
+    });
+
+    if (profiler != nullptr) {
+        profiler->writeReports();
+    }
+}
+
+template<uint8_t Flags, typename Profiler, typename Tracer, typename Debug>
+void SChip::runLoop(RunControl& control, Profiler& activeProfiler, Tracer& activeTracer, Debug& activeDebugger) {
+    using namespace std::chrono_literals;
+
+    uint64_t previousFrameStart{};
+    for (RunCommand command{ control.next() }; command != RunCommand::STOP; command = control.next()) {
+        auto start {std::chrono::steady_clock::now()};
+
+        // Paused by the debugger, the machine is left as it is until it is resumed or the run stops
+        if (activeDebugger.isStopped()) {
+            activeDebugger.waitWhileStopped(control);
+            continue;
+        }
+
+        if (command == RunCommand::INSTRUCTION) {
+            if (!runInstruction<Flags>()) {
+                return;
+            }
+            display.updateWindowSurface();
+            updateAudio();
+            continue;
+        }
+
+        // Input that arrived since the previous frame started is replayed at the instruction boundaries it fell on,
+        // so taps shorter than a frame are still seen by the ROM
+        // Keeping their spacing costs up to one frame of latency but never more: the window reaches back at most
+        // one frame period, and anything older, left by a pause or a late wake up, is applied at the first instruction
+        std::chrono::nanoseconds period{ control.getFramePeriod() };
+        uint64_t inputWindow{ command == RunCommand::RUN ? (uint64_t) period.count() : FRAME_DURATION_NS };
+        uint64_t frameStart{ InputHandler::now() };
+        uint64_t inputWindowStart{ std::max(previousFrameStart, frameStart - inputWindow) };
+        previousFrameStart = frameStart;
+
+        if (!runFrame<Flags>(activeProfiler, activeTracer, activeDebugger, inputWindowStart, frameStart - inputWindowStart)) {
+            return;
+        }
+
+        // The frames run ahead are shown and heard in place of the real one, which is restored right after
+        bool isRunningAhead{};
+        if constexpr (std::is_same_v<Debug, NullDebugger>) {
+            isRunningAhead = command == RunCommand::RUN && runAheadFrames > 0;
+            if (isRunningAhead) {
+                runAhead<Flags>();
+            }
+        }
+
+        // Side effects are batched to the frame boundary so the instruction loop makes no library calls
+        display.updateWindowSurface();
+
+        updateAudio();
+
+        if (isRunningAhead) {
+            loadSnapshot(*runAheadSnapshot);
+        }
 
+        // Sleep 1.2ms less to account for thread waking up later, an unlimited speed does not sleep at all
+        if (command == RunCommand::RUN && period > 1200us) {
+            std::this_thread::sleep_until(start + period - 1200us);
+        }
+    }
+}
+
+// One instruction on the diagnostic loop, stopped after it by a Debugger of its own
+template<uint8_t Flags>
+bool SChip::runInstruction() {
+    Debugger stepper{};
+    stepper.step(1);
+    OptionalProfiler optionalProfiler{ profiler };
+    OptionalTracer optionalTracer{ tracer };
+    OptionalDebugger optionalDebugger{ &stepper };
+    return runFrame<Flags & QuirkFlags::DIAGNOSTIC_FLAGS>(optionalProfiler, optionalTracer, optionalDebugger, InputHandler::now(), FRAME_DURATION_NS);
+}
+
+// Saves the machine to roll back to, then runs on with the keys held as they are
+// A window start of zero lies before every queued event, so the events are left for the real frames
+template<uint8_t Flags>
+void SChip::runAhead() {
+    saveSnapshot(*runAheadSnapshot);
+
+    NullProfiler nullProfiler{};
+    NullTracer nullTracer{};
+    NullDebugger nullDebugger{};
+    for (int i{}; i < runAheadFrames; i++) {
+        if (!runFrame<Flags>(nullProfiler, nullTracer, nullDebugger, 0, FRAME_DURATION_NS)) {
+            return;
+        }
+    }
+}
+
+template<uint8_t Flags, typename Profiler, typename Tracer, typename Debug>
+bool SChip::runFrame(Profiler& activeProfiler, Tracer& activeTracer, Debug& activeDebugger, uint64_t inputWindowStart,
+                    uint64_t inputWindow) {
+    // Steps and register conditions look at every instruction, so their frames run on the diagnostic loop
+    if constexpr (std::is_same_v<Debug, BlockDebugger>) {
+        if (!activeDebugger.beginFrame()) {
+            OptionalProfiler optionalProfiler{ profiler };
+            OptionalTracer optionalTracer{ tracer };
+            OptionalDebugger optionalDebugger{ debugger };
+            return runFrame<Flags & QuirkFlags::DIAGNOSTIC_FLAGS>(optionalProfiler, optionalTracer, optionalDebugger, inputWindowStart, inputWindow);
+        }
+    }
+
+    // A frame the debugger stopped in carries on where it left off, its timers have already ticked
+    int count{};
+    if (resumeInstruction >= 0) {
+        count = resumeInstruction;
+        resumeInstruction = -1;
+    } else {
         if (delay_timer > 0) {
             delay_timer--;
         }
@@ -28,45 +165,175 @@ void SChip::run(std::string& filename, bool& stopSignal) {
         if (sound_timer > 0) {
             sound_timer--;
         }
+    }
+    int firstInstruction{ count };
 
-        // Limited by 60 sprite per second
-        int count{};
-        while (true) {
-            uint16_t ins = (memory[program_counter] << 8) + memory[program_counter + 1];
-            // std::cout << "Instruction: " << std::hex << ins << "   ";
-            program_counter += 2;
+    // Limited by 60 sprite per second
+    for (; count < instructionsPerFrame; count++) {
+        inputHandler.applyEvents(inputWindowStart + count * inputWindow / instructionsPerFrame);
 
-            if (!decode(ins)) {
-                printf("Instruction: %d. Program Counter: %d.\n", ins, program_counter - 2);
-                return;
+        uint16_t ins = (memory[program_counter] << 8) + memory[program_counter + 1];
+        if (activeDebugger.beforeInstruction(program_counter, ins, index_register, 32)) {
+            resumeInstruction = count;
+            instructionCount += count - firstInstruction;
+            return true;
+        }
+
+        activeProfiler.beginInstruction(program_counter, ins);
+        activeTracer.beginInstruction(program_counter, ins, registers.data());
+        uint16_t address{ program_counter };
+        program_counter += 2;
+
+        // Fused pairs are release only and never straddle the end of a frame or hide an instruction from the debugger
+        Fusion fusion{ Fusion::NONE };
+        if constexpr (!IS_DIAGNOSTIC_LOOP<Debug>) {
+            if (count + 1 < instructionsPerFrame) {
+                fusion = fusions[address];
+            }
+            if (fusion != Fusion::NONE && !activeDebugger.canFuse(address + 2, (memory[address + 2] << 8) + memory[address + 3], 32)) {
+                fusion = Fusion::NONE;
             }
+        }
 
-            // Comment these out before running tests
-            if (sound_timer > 0) {
-                SDL_PauseAudio(0);
-            } else {
-                SDL_PauseAudio(1);
+        bool isDecoded{ true };
+        if (fusion == Fusion::NONE) {
+            isDecoded = decode<Flags & QuirkFlags::DECODE_FLAGS>(ins);
+        } else if (runFused<Flags & QuirkFlags::DECODE_FLAGS>(fusion, ins, (memory[address + 2] << 8) + memory[address + 3])) {
+            // The second instruction is the one that ran last for the checks below
+            address += 2;
+            ins = (memory[address] << 8) + memory[address + 1];
+            count++;
+            fusedCount++;
+        }
+        activeProfiler.endInstruction();
+        activeTracer.endInstruction(index_register, registers.data(), delay_timer, sound_timer, stack_pointer);
+        if (!isDecoded) {
+            printf("Instruction: %d. Program Counter: %d.\n", ins, program_counter - 2);
+            instructionCount += count - firstInstruction;
+            return false;
+        }
+
+        // Idle loops are skipped in whole passes, only a backwards jump or a repeating FX0A can close one
+        // The diagnostic loop runs every pass so traces, profiles and debugger stops stay exact
+        if constexpr (!IS_DIAGNOSTIC_LOOP<Debug>) {
+            // A cooperative step hands the thread back when FX0A starts waiting, before its passes are skipped
+            if (isYieldingOnKeyWait && program_counter == address && (ins & 0xF0FF) == 0xF00A && count + 1 < instructionsPerFrame) {
+                isYieldingOnKeyWait = false;
+                resumeInstruction = count + 1;
+                instructionCount += count + 1 - firstInstruction;
+                return true;
             }
 
-            // DXYN waits for the next vertical interrupt
-            if (count > 16.66 / 1000.0 * INSTRUCTION_PER_SECOND) {
-                break;
+            if (program_counter <= address && activeDebugger.canSkipPasses(program_counter, address)) {
+                IdleLoop loop{ findIdleLoop(memory, address, ins, program_counter, registers, delay_timer, inputHandler) };
+                int skipped{ loop.length > 0 ? idleInstructionsToSkip(loop, count + 1, instructionsPerFrame, inputWindowStart, inputWindow, inputHandler) : 0 };
+
+                // The timer may have ticked since this pass loaded it, the skipped passes leave the new value
+                if (skipped > 0 && loop.delayRegister >= 0) {
+                    registers[loop.delayRegister] = delay_timer;
+                }
+                count += skipped;
             }
+        }
+
+        // DXYN waits for the next vertical interrupt
+        bool isFrameEnd{};
+        if constexpr ((Flags & QuirkFlags::VBLANK_WAIT) != 0) {
+            isFrameEnd = ins >> 12 == 0xD;
+        }
 
+        // Stopping mid frame leaves the rest of it for when the debugger resumes
+        if (activeDebugger.afterInstruction(program_counter, registers.data())) {
             count++;
+            if (!isFrameEnd && count < instructionsPerFrame) {
+                resumeInstruction = count;
+                instructionCount += count - firstInstruction;
+                return true;
+            }
+            break;
         }
 
-        display.updateWindowSurface();
+        if (isFrameEnd) {
+            count++;
+            break;
+        }
+    }
+
+    instructionCount += count - firstInstruction;
+    framesCompleted++;
+    return true;
+}
+
+bool SChip::runFrames(int frameCount) {
+    return dispatchQuirks(getRunFlags(), [&](auto flags) {
+        constexpr uint8_t quirkFlags{ decltype(flags)::value };
+        if (profiler == nullptr && tracer == nullptr && debugger == nullptr) {
+            NullProfiler nullProfiler{};
+            NullTracer nullTracer{};
+            NullDebugger nullDebugger{};
+            return runFrames<quirkFlags>(frameCount, nullProfiler, nullTracer, nullDebugger);
+        }
+        if (profiler == nullptr && tracer == nullptr) {
+            NullProfiler nullProfiler{};
+            NullTracer nullTracer{};
+            BlockDebugger blockDebugger{ *debugger };
+            return runFrames<quirkFlags>(frameCount, nullProfiler, nullTracer, blockDebugger);
+        }
+
+        OptionalProfiler optionalProfiler{ profiler };
+        OptionalTracer optionalTracer{ tracer };
+        OptionalDebugger optionalDebugger{ debugger };
+        return runFrames<quirkFlags & QuirkFlags::DIAGNOSTIC_FLAGS>(frameCount, optionalProfiler, optionalTracer, optionalDebugger);
+    });
+}
 
-        using namespace std::chrono_literals;
+StepResult SChip::step() {
+    isYieldingOnKeyWait = resumeInstruction < 0;
+    uint64_t frames{ framesCompleted };
+    bool isRunning{ runFrames(1) };
+    isYieldingOnKeyWait = false;
 
-        // Sleep 1.2ms less to account for thread waking up later
-        std::this_thread::sleep_until(start + 15.6ms);
+    if (!isRunning) {
+        return StepResult::EXITED;
     }
+    if (framesCompleted != frames) {
+        return StepResult::FRAME;
+    }
+    return debugger != nullptr && debugger->isStopped() ? StepResult::STOPPED : StepResult::KEY_WAIT;
+}
+
+bool SChip::runInstruction() {
+    return dispatchQuirks(getRunFlags(), [&](auto flags) {
+        constexpr uint8_t quirkFlags{ decltype(flags)::value };
+        return runInstruction<quirkFlags>();
+    });
+}
+
+template<uint8_t Flags, typename Profiler, typename Tracer, typename Debug>
+bool SChip::runFrames(int frameCount, Profiler& activeProfiler, Tracer& activeTracer, Debug& activeDebugger) {
+    for (int i{}; i < frameCount && !activeDebugger.isStopped(); i++) {
+        if (!runFrame<Flags>(activeProfiler, activeTracer, activeDebugger, InputHandler::now(), FRAME_DURATION_NS)) {
+            return false;
+        }
+        display.updateWindowSurface();
+    }
+    return true;
+}
+
+void SChip::updateAudio() {
+    bool shouldPlay{ sound_timer > 0 };
+    if (audio != nullptr && shouldPlay != isSoundPlaying) {
+        audio->setPlaying(shouldPlay);
+        isSoundPlaying = shouldPlay;
+    }
+}
+
+bool SChip::load(std::string& filename) {
+    return fetch(filename);
 }
 
 
-bool SChip::fetch(std::string& filename) const {
+bool SChip::fetch(std::string& filename) {
     std::ifstream input;
     input.open(filename, std::fstream::binary);
 
@@ -75,26 +342,272 @@ bool SChip::fetch(std::string& filename) const {
         return false;
     }
 
-    int i{0x200};
-    while (!input.eof()) {
-        uint8_t byte;
-        input >> std::noskipws >> byte;
-        memory[i] = byte;
-        i++;
+    std::vector<uint8_t> rom{ std::istreambuf_iterator<char>(input), std::istreambuf_iterator<char>() };
+    return loadRom(rom.data(), rom.size());
+}
+
+bool SChip::loadRom(const uint8_t* data, size_t size) {
+    if (size > RAM_SIZE - 0x200) {
+        printf("Error: ROM is larger than the available memory\n");
+        return false;
     }
 
+    memory.write(0x200, data, size);
+    fusions.build(memory);
     return true;
 }
 
+bool SChip::buildRomImage(const uint8_t* data, size_t size, RomImage& image) {
+    if (size > RAM_SIZE - 0x200) {
+        printf("Error: ROM is larger than the available memory\n");
+        return false;
+    }
+
+    image.memory = PagedMemory{};
+    image.memory.write(0x50, FONT, sizeof(FONT));
+    image.memory.write(0xA0, SCHIP_FONT, sizeof(SCHIP_FONT));
+    image.memory.write(0x200, data, size);
+    image.fusions.build(image.memory);
+    return true;
+}
+
+void SChip::reset(const RomImage& image, uint32_t seed) {
+    memory = image.memory;
+    fusions = image.fusions;
+
+    program_counter = 0x200;
+    index_register = 0;
+    stack.fill(0);
+    stack_pointer = 0;
+    std::fill(registers.begin(), registers.end(), 0);
+    std::fill(flags.begin(), flags.end(), 0);
+    delay_timer = 0;
+    sound_timer = 0;
+    pendingKey = -1;
+    resumeInstruction = -1;
+    instructionCount = 0;
+    framesCompleted = 0;
+    fusedCount = 0;
+    engine.seed(seed);
+    dist.reset();
+
+    display.switchOperationalMode(false);
+    if (isFramebufferDisplay) {
+        display.clearFramebuffer();
+    } else {
+        display.clearScreen();
+    }
+    display.updateWindowSurface();
+    updateAudio();
+}
+
+
+// Save States
+bool SChip::saveState(const std::string& path) const {
+    StateWriter writer{ SCHIP_STATE_ID };
+
+    uint8_t ram[RAM_SIZE];
+    memory.copyTo(ram);
+    writer.write(ram, sizeof(ram));
+    writer.write(registers.data(), registers.size());
+    writer.write(flags.data(), flags.size());
+    writer.write(program_counter);
+    writer.write(index_register);
+
+    // Bottom of the stack first, one entry per call so loading replays a stack that wrapped around exactly
+    writer.write((uint32_t) stack_pointer);
+    for (int i{}; i < stack_pointer; i++) {
+        writer.write(stack[i & (STACK_SIZE - 1)]);
+    }
+
+    writer.write(delay_timer);
+    writer.write(sound_timer);
+    writer.write((int32_t) pendingKey);
+
+    std::ostringstream random;
+    random << engine;
+    writer.writeString(random.str());
+
+    writer.write(display.isHiresMode());
+    writer.write(display.getPixels(), AdvancedDisplay::BUFFER_SIZE);
+
+    return writer.saveTo(path);
+}
+
+bool SChip::loadState(const std::string& path) {
+    StateReader reader{};
+    if (!reader.loadFrom(path, SCHIP_STATE_ID)) {
+        return false;
+    }
+
+    // Everything is read before anything is applied, so a bad file leaves the machine as it was
+    uint8_t ram[RAM_SIZE];
+    std::vector<uint8_t> savedRegisters(registers.size());
+    std::vector<uint8_t> savedFlags(flags.size());
+    uint16_t savedProgramCounter{};
+    uint16_t savedIndexRegister{};
+    reader.read(ram, sizeof(ram));
+    reader.read(savedRegisters.data(), savedRegisters.size());
+    reader.read(savedFlags.data(), savedFlags.size());
+    reader.read(savedProgramCounter);
+    reader.read(savedIndexRegister);
+
+    uint32_t depth{};
+    std::array<uint16_t, STACK_SIZE> savedStack{};
+    uint8_t savedStackPointer{};
+    reader.read(depth);
+    for (uint32_t i{}; i < depth; i++) {
+        uint16_t frame{};
+        if (!reader.read(frame)) {
+            break;
+        }
+        savedStack[savedStackPointer & (STACK_SIZE - 1)] = frame;
+        savedStackPointer++;
+    }
+
+    uint8_t savedDelayTimer{};
+    uint8_t savedSoundTimer{};
+    int32_t savedPendingKey{};
+    std::string random;
+    reader.read(savedDelayTimer);
+    reader.read(savedSoundTimer);
+    reader.read(savedPendingKey);
+    reader.readString(random);
+
+    std::mt19937 savedEngine;
+    std::istringstream randomInput{ random };
+    randomInput >> savedEngine;
+
+    bool isHires{};
+    uint8_t pixels[AdvancedDisplay::BUFFER_SIZE];
+    reader.read(isHires);
+    reader.read(pixels, sizeof(pixels));
+
+    if (!reader.isComplete() || randomInput.fail()) {
+        printf("Error: Save state %s is corrupted\n", path.c_str());
+        return false;
+    }
+
+    memory.write(0, ram, sizeof(ram));
+    fusions.build(memory);
+    registers = savedRegisters;
+    flags = savedFlags;
+    program_counter = savedProgramCounter;
+    index_register = savedIndexRegister;
+    stack = savedStack;
+    stack_pointer = savedStackPointer;
+    delay_timer = savedDelayTimer;
+    sound_timer = savedSoundTimer;
+    pendingKey = savedPendingKey;
+    engine = savedEngine;
+
+    // Drawn pixel by pixel so windowed displays repaint
+    display.switchOperationalMode(isHires);
+    for (int y{}; y < display.getHeight(); y++) {
+        for (int x{}; x < display.getWidth(); x++) {
+            display.drawPixel(x, y, pixels[y * HIRES_WIDTH + x] != 0);
+        }
+    }
+
+    display.updateWindowSurface();
+    return true;
+}
+
+void SChip::saveSnapshot(SChipSnapshot& snapshot) const {
+    memory.copyTo(snapshot.ram.data());
+    snapshot.fusions = fusions;
+    std::copy(registers.begin(), registers.end(), snapshot.registers.begin());
+    std::copy(flags.begin(), flags.end(), snapshot.flags.begin());
+    snapshot.programCounter = program_counter;
+    snapshot.indexRegister = index_register;
+    snapshot.stack = stack;
+    snapshot.stackPointer = stack_pointer;
+    snapshot.delayTimer = delay_timer;
+    snapshot.soundTimer = sound_timer;
+    snapshot.pendingKey = pendingKey;
+    snapshot.resumeInstruction = resumeInstruction;
+    snapshot.engine = engine;
+    snapshot.instructionCount = instructionCount;
+    snapshot.framesCompleted = framesCompleted;
+    snapshot.fusedCount = fusedCount;
+    snapshot.isHires = display.isHiresMode();
+    memcpy(snapshot.pixels.data(), display.getPixels(), AdvancedDisplay::BUFFER_SIZE);
+}
+
+void SChip::loadSnapshot(const SChipSnapshot& snapshot) {
+    memory.write(0, snapshot.ram.data(), RAM_SIZE);
+    fusions = snapshot.fusions;
+    std::copy(snapshot.registers.begin(), snapshot.registers.end(), registers.begin());
+    std::copy(snapshot.flags.begin(), snapshot.flags.end(), flags.begin());
+    program_counter = snapshot.programCounter;
+    index_register = snapshot.indexRegister;
+    stack = snapshot.stack;
+    stack_pointer = snapshot.stackPointer;
+    delay_timer = snapshot.delayTimer;
+    sound_timer = snapshot.soundTimer;
+    pendingKey = snapshot.pendingKey;
+    resumeInstruction = snapshot.resumeInstruction;
+    engine = snapshot.engine;
+    instructionCount = snapshot.instructionCount;
+    framesCompleted = snapshot.framesCompleted;
+    fusedCount = snapshot.fusedCount;
+
+    // Windowed displays only repaint the pixels that differ
+    display.switchOperationalMode(snapshot.isHires);
+    uint8_t* pixels{ display.getPixels() };
+    if (isFramebufferDisplay) {
+        memcpy(pixels, snapshot.pixels.data(), AdvancedDisplay::BUFFER_SIZE);
+        return;
+    }
+    for (int y{}; y < display.getHeight(); y++) {
+        for (int x{}; x < display.getWidth(); x++) {
+            int i{ y * HIRES_WIDTH + x };
+            if (pixels[i] != snapshot.pixels[i]) {
+                display.drawPixel(x, y, snapshot.pixels[i] != 0);
+            }
+        }
+    }
+}
+
+void SChip::setRunAheadFrames(int count) {
+    runAheadFrames = std::clamp(count, 0, MAX_RUN_AHEAD_FRAMES);
+    if (runAheadFrames > 0 && runAheadSnapshot == nullptr) {
+        runAheadSnapshot = std::make_unique<SChipSnapshot>();
+    }
+}
+
+
+// Debugging
+DebugRegisters SChip::getDebugRegisters() const {
+    DebugRegisters debugRegisters{};
+    std::copy(registers.begin(), registers.end(), debugRegisters.v);
+    debugRegisters.i = index_register;
+    debugRegisters.pc = program_counter;
+    debugRegisters.sp = stack_pointer;
+    debugRegisters.delayTimer = delay_timer;
+    debugRegisters.soundTimer = sound_timer;
+    return debugRegisters;
+}
+
+void SChip::setDebugRegisters(const DebugRegisters& debugRegisters) {
+    std::copy(debugRegisters.v, debugRegisters.v + 16, registers.begin());
+    index_register = debugRegisters.i;
+    program_counter = debugRegisters.pc % RAM_SIZE;
+    delay_timer = debugRegisters.delayTimer;
+    sound_timer = debugRegisters.soundTimer;
+}
+
+
 
 // Memory
 // SCHIP flags size is limited to 8 since only registers 0 to 7 will be addressed
-SChip::SChip(AdvancedDisplay& display, InputHandler& inputHandler)
-        : program_counter{0x200}, index_register{}, stack{}, registers(16, 0), flags(8, 0),
-          display{display}, inputHandler{inputHandler}, sound_timer{}, delay_timer{}
+SChip::SChip(AdvancedDisplay& display, InputHandler& inputHandler, const Quirks& quirks)
+        : program_counter{0x200}, index_register{}, stack{}, stack_pointer{}, registers(16, 0), flags(8, 0), delay_timer{}, sound_timer{},
+          display{display}, isFramebufferDisplay{ typeid(display) == typeid(AdvancedDisplay) }, quirks{quirks},
+          instructionsPerFrame{INSTRUCTIONS_PER_FRAME}, runAheadFrames{}, instructionCount{}, framesCompleted{}, fusedCount{},
+          inputHandler{inputHandler}, pendingKey{-1}, profiler{}, tracer{}, audio{}, isSoundPlaying{}, debugger{}, resumeInstruction{-1},
+          isYieldingOnKeyWait{}
 {
-    memory = new uint8_t[RAM_SIZE]();
-
     // Loading up random number generator
     std::random_device r;
     std::seed_seq seed{ r(), r(), r(), r(), r(), r(), r() };
@@ -103,22 +616,86 @@ SChip::SChip(AdvancedDisplay& display, InputHandler& inputHandler)
     loadFont();
 }
 
-SChip::~SChip() {
-    delete[] memory;
+SChip::SChip(const SChip& other, AdvancedDisplay& display, InputHandler& inputHandler)
+        : memory{other.memory}, program_counter{other.program_counter}, index_register{other.index_register},
+          stack{other.stack}, stack_pointer{other.stack_pointer}, registers{other.registers}, flags{other.flags}, delay_timer{other.delay_timer},
+          sound_timer{other.sound_timer}, display{display}, isFramebufferDisplay{ typeid(display) == typeid(AdvancedDisplay) }, engine{other.engine}, dist{other.dist},
+          quirks{other.quirks}, instructionsPerFrame{other.instructionsPerFrame}, runAheadFrames{}, instructionCount{other.instructionCount},
+          framesCompleted{other.framesCompleted}, fusedCount{other.fusedCount}, fusions{other.fusions}, inputHandler{inputHandler},
+          pendingKey{other.pendingKey}, profiler{}, tracer{}, audio{}, isSoundPlaying{}, debugger{}, resumeInstruction{other.resumeInstruction},
+          isYieldingOnKeyWait{}
+{
+    display.copyFrom(other.display);
 }
 
-void SChip::loadFont() const {
-    for (int i{0x50}; i <= 0x9F; i++) {
-        memory[i] = FONT[i - 0x50];
-    }
+SChip::~SChip() = default;
 
-    for (int i{0xA0}; i < 0x140; i++) {
-        memory[i] = SCHIP_FONT[i - 0xA0];
-    }
+std::unique_ptr<SChip> SChip::fork(AdvancedDisplay& forkDisplay, InputHandler& forkInputHandler) const {
+    return std::unique_ptr<SChip>(new SChip(*this, forkDisplay, forkInputHandler));
+}
+
+void SChip::loadFont() {
+    memory.write(0x50, FONT, sizeof(FONT));
+
+    memory.write(0xA0, SCHIP_FONT, sizeof(SCHIP_FONT));
 }
 
 
 // Processor Logic
+bool SChip::decode(uint16_t ins) {
+    return dispatchQuirks(getRunFlags(), [&](auto flags) {
+        return decode<decltype(flags)::value & QuirkFlags::DECODE_FLAGS>(ins);
+    });
+}
+
+// Same effects as decode on first and then on second, including the skip that leaves second unrun
+template<uint8_t Flags>
+bool SChip::runFused(Fusion fusion, uint16_t first, uint16_t second) {
+    uint8_t x{ (uint8_t) ((first >> 8) & 0xF) };
+    switch (fusion) {
+        case Fusion::SET_SET:
+            registers[x] = first & 0xFF;
+            registers[(second >> 8) & 0xF] = second & 0xFF;
+            program_counter += 2;
+            return true;
+        case Fusion::ADD_ADD:
+            registers[x] += first & 0xFF;
+            registers[(second >> 8) & 0xF] += second & 0xFF;
+            program_counter += 2;
+            return true;
+        case Fusion::ADD_SKIP: {
+            registers[x] += first & 0xFF;
+            bool isEqual{ registers[(second >> 8) & 0xF] == (second & 0xFF) };
+            program_counter += isEqual == (second >> 12 == 0x3) ? 4 : 2;
+            return true;
+        }
+        case Fusion::SKIP_JUMP: {
+            bool isSkipping;
+            switch (first >> 12) {
+                case 0x3: isSkipping = registers[x] == (first & 0xFF); break;
+                case 0x4: isSkipping = registers[x] != (first & 0xFF); break;
+                case 0x5: isSkipping = registers[x] == registers[(first >> 4) & 0xF]; break;
+                default: isSkipping = registers[x] != registers[(first >> 4) & 0xF]; break;
+            }
+            if (isSkipping) {
+                program_counter += 2;
+                return false;
+            }
+            program_counter = second & 0xFFF;
+            return true;
+        }
+        case Fusion::INDEX_DRAW:
+        case Fusion::INDEX_ADD:
+        case Fusion::INDEX_LOAD:
+            index_register = first & 0xFFF;
+            program_counter += 2;
+            return decode<Flags>(second);
+        default:
+            return false;
+    }
+}
+
+template<uint8_t Flags>
 bool SChip::decode(uint16_t ins) {
     switch (ins >> 12) {
         case 0x0:
@@ -130,13 +707,11 @@ bool SChip::decode(uint16_t ins) {
 
             switch (ins) {
                 case 0x00E0:
-                    DEBUG_MSG("Clear Screen");
-                    display.clearScreen();
+                    clearScreen<Flags>();
                     break;
                 case 0x00EE:
-                    program_counter = stack.top();
-                    stack.pop();
-                    DEBUG_MSG("Return from function. Program Counter: " << std::hex << program_counter);
+                    stack_pointer--;
+                    program_counter = stack[stack_pointer & (STACK_SIZE - 1)];
                     break;
                 case 0x00FB:
                     display.scrollRight(4);
@@ -147,11 +722,9 @@ bool SChip::decode(uint16_t ins) {
                 case 0x00FD:
                     return false;
                 case 0x00FE:
-                    DEBUG_MSG("Lores Mode");
                     display.switchOperationalMode(false);
                     break;
                 case 0x00FF:
-                    DEBUG_MSG("Hires Mode");
                     display.switchOperationalMode(true);
                     break;
                 default:
@@ -160,37 +733,31 @@ bool SChip::decode(uint16_t ins) {
             break;
         case 0x1:
             program_counter = ins % 0x1000;
-            DEBUG_MSG("Jump to " << std::hex << program_counter);
             break;
         case 0x2:
-            stack.push(program_counter);
+            stack[stack_pointer & (STACK_SIZE - 1)] = program_counter;
+            stack_pointer++;
             program_counter = ins % 0x2000;
-            DEBUG_MSG("Begin Function. Program Counter: " << std::hex << program_counter);
             break;
         case 0x3:
-            DEBUG_MSG("CHECK if Register[" << ((ins % 0x3000) >> 8) << "]: " << +registers[(ins % 0x3000) >> 8] << " == " << ins % 0x100);
             if (registers[(ins % 0x3000) >> 8] == ins % 0x100) {
                 program_counter += 2;
             }
             break;
         case 0x4:
-            DEBUG_MSG("CHECK if Register[" << ((ins % 0x4000) >> 8) << "]: " << +registers[(ins % 0x4000) >> 8] << " != " << ins % 0x100);
             if (registers[(ins % 0x4000) >> 8] != ins % 0x100) {
                 program_counter += 2;
             }
             break;
         case 0x5:
-            DEBUG_MSG("Check if Register[" << ((ins % 0x5000) >> 8) << "]: " << +registers[(ins % 0x5000) >> 8] << "== Register[" << ((ins % 0x0100) >> 4) << "]: " << +registers[(ins % 0x0100) >> 4]);
             if (registers[(ins % 0x5000) >> 8] == registers[(ins % 0x0100) >> 4]) {
                 program_counter += 2;
             }
             break;
         case 0x6:
-            DEBUG_MSG("Set Register[" << ((ins % 0x6000) >> 8) << "] to " << std::hex << ins % 0x100);
             registers[(ins % 0x6000) >> 8] = ins % 0x100;
             break;
         case 0x7:
-            DEBUG_MSG("Add to Register[" << ((ins % 0x7000) >> 8) << "] value " << std::hex << ins % 0x100);
             registers[(ins % 0x7000) >> 8] += (ins % 0x100);
             break;
         case 0x8: {
@@ -199,44 +766,49 @@ bool SChip::decode(uint16_t ins) {
 
             switch (ins % 0x10) {
                 case 0:
-                    DEBUG_MSG("Set Register[" << x << "]: " << +registers[x] << " to Register[" << y << "]: " << +registers[y]);
                     registers[x] = registers[y];
                     break;
                 case 1:
-                    DEBUG_MSG("OR Register[" << x << "]: " << +registers[x] << " with Register[" << y << "]: " << +registers[y]);
                     registers[x] |= registers[y];
+                    if constexpr ((Flags & QuirkFlags::LOGIC_RESETS_VF) != 0) {
+                        registers[15] = 0;
+                    }
                     break;
                 case 2:
-                    DEBUG_MSG("AND Register[" << x << "]: " << +registers[x] << " with Register[" << y << "]: " << +registers[y]);
                     registers[x] &= registers[y];
+                    if constexpr ((Flags & QuirkFlags::LOGIC_RESETS_VF) != 0) {
+                        registers[15] = 0;
+                    }
                     break;
                 case 3:
-                    DEBUG_MSG("XOR Register[" << x << "]: " << +registers[x] << " with Register[" << y << "]: " << +registers[y]);
                     registers[x] ^= registers[y];
+                    if constexpr ((Flags & QuirkFlags::LOGIC_RESETS_VF) != 0) {
+                        registers[15] = 0;
+                    }
                     break;
                 case 4: {
-                    DEBUG_MSG("ADD Register[" << x << "]: " << +registers[x] << " with Register[" << y << "]: " << +registers[y]);
                     uint8_t flag = (registers[x] + registers[y]) > 255 ? 1 : 0;
                     registers[x] += registers[y];
                     registers[15] = flag;
                     break;
                 }
                 case 5: {
-                    DEBUG_MSG("SUBTRACT Register[" << x << "]: " << +registers[x] << " with Register[" << y << "]: " << +registers[y]);
                     uint8_t flag = registers[x] >= registers[y] ? 1 : 0;
                     registers[x] -= registers[y];
                     registers[15] = flag;
                     break;
                 }
                 case 7: {
-                    DEBUG_MSG("SUBTRACT REVERSE Register[" << x << "]: " << +registers[x] << " with Register[" << y << "]: " << +registers[y]);
                     uint8_t flag = registers[y] >= registers[x] ? 1 : 0;
                     registers[x] = registers[y] - registers[x];
                     registers[15] = flag;
                     break;
                 }
                 case 6: {
-                    DEBUG_MSG("SHIFT RIGHT Register[" << x << "]: " << +registers[x] << " with Register[" << y << "]: " << +registers[y]);
+                    if constexpr ((Flags & QuirkFlags::SHIFT_USES_VY) != 0) {
+                        registers[x] = registers[y];
+                    }
+
                     uint8_t flag = registers[x] % 2 ? 1 : 0;
                     registers[x] >>= 1;
                     registers[15] = flag;
@@ -244,7 +816,10 @@ bool SChip::decode(uint16_t ins) {
                     break;
                 }
                 case 0xE: {
-                    DEBUG_MSG("SHIFT LEFT Register[" << x << "]: " << +registers[x] << " with Register[" << y << "]: " << +registers[y]);
+                    if constexpr ((Flags & QuirkFlags::SHIFT_USES_VY) != 0) {
+                        registers[x] = registers[y];
+                    }
+
                     uint8_t flag = registers[x] >= 0x80 ? 1 : 0; // Is leftmost bit 1
                     registers[x] <<= 1;
                     registers[15] = flag;
@@ -257,28 +832,21 @@ bool SChip::decode(uint16_t ins) {
             break;
         }
         case 0x9:
-            DEBUG_MSG("Check if Register[" << ((ins % 0x9000) >> 8) << "]: " << +registers[(ins % 0x9000) >> 8] << "!= Register[" << ((ins % 0x0100) >> 4) << "]: " << +registers[(ins % 0x0100) >> 4]);
             if (registers[(ins % 0x9000) >> 8] != registers[(ins % 0x0100) >> 4]) {
                 program_counter += 2;
             }
             break;
         case 0xA:
-            DEBUG_MSG("Set Index Register to " << std::hex << ins % 0xA000);
             index_register = ins % 0xA000;
             break;
         case 0xB:
-            // TODO: Make a toggle for the other behaviour
-            DEBUG_MSG("Jump with offset " << std::hex << (ins % 0xB000) + registers[(ins % 0xB000) >> 8]);
-//            DEBUG_MSG("Register [" << ((ins % 0xB000) >> 8) << "]: " << +registers[(ins % 0xB000) >> 8]);
-//            if (ins == 0xBEA9) {
-//                program_counter = (ins % 0xB000) + 0;
-//                break;
-//            }
-//            program_counter = (ins % 0xB000) + registers[(ins % 0xB000) >> 8];
-            program_counter = (ins % 0xB000) + registers[0];
+            if constexpr ((Flags & QuirkFlags::JUMP_USES_VX) != 0) {
+                program_counter = (ins % 0xB000) + registers[(ins % 0xB000) >> 8];
+            } else {
+                program_counter = (ins % 0xB000) + registers[0];
+            }
             break;
         case 0xC:
-            DEBUG_MSG("Random Register[" << ((ins % 0xC000) >> 8) << "]: " << +registers[(ins % 0xC000) >> 8]);
             registers[(ins % 0xC000) >> 8] = dist(engine) & (ins % 0x100);
             break;
         case 0xD: {
@@ -288,6 +856,9 @@ bool SChip::decode(uint16_t ins) {
             // If no pixel are flipped, this value will remain to be 0
             registers[15] = 0;
 
+            // The origin always wraps, the rest of the sprite is either cut off or wrapped too
+            constexpr bool isClipping{ (Flags & QuirkFlags::CLIP_SPRITES) != 0 };
+
             // DXY0 Instruction
             if (ins % 0x10 == 0) {
                 for (uint8_t line{}; line < 16; line++) {
@@ -295,23 +866,21 @@ bool SChip::decode(uint16_t ins) {
                     uint8_t y = (origin_y + line) % display.getHeight();
                     uint8_t x = origin_x % display.getWidth();
 
-                    std::vector<bool> v(16);
-                    decodeBigSprite(index_register + line * 2, v);
-
-                    DEBUG_MSG("Display At X: " << +x << " , Y: " << +y << " " << spriteToString(v));
+                    uint16_t sprite{ static_cast<uint16_t>(memory[index_register + line * 2] << 8 | memory[index_register + line * 2 + 1]) };
 
                     int i{};
-                    while (i < 16) {
-                        if (v[i])
-                            if (display.flipPixel(x, y))
+                    while (i < 16 && (!isClipping || x < display.getWidth())) {
+                        if (sprite & (0x8000 >> i))
+                            if (flipPixel<Flags>(x, y))
                                 registers[15] = 1;
 
                         x++;
                         i++;
-                        x = x % display.getWidth();
+                        if constexpr (!isClipping)
+                            x = x % display.getWidth();
                     }
 
-                    if (y >= display.getHeight() - 1)
+                    if (isClipping && y >= display.getHeight() - 1)
                         break;
                 }
             } else { // DXYN Instruction
@@ -320,22 +889,21 @@ bool SChip::decode(uint16_t ins) {
                     uint8_t y = (origin_y + line) % display.getHeight();
                     uint8_t x = origin_x % display.getWidth();
 
-                    std::vector<bool> v(8);
-                    decodeSmallSprite(index_register + line, v);
-
-                    DEBUG_MSG("Display At X: " << +x << " , Y: " << +y << " " << spriteToString(v));
+                    uint8_t sprite{ memory[index_register + line] };
 
                     int i{};
-                    while (i < 8 && x < display.getWidth()) {
-                        if (v[i])
-                            if (display.flipPixel(x, y))
+                    while (i < 8 && (!isClipping || x < display.getWidth())) {
+                        if (sprite & (0x80 >> i))
+                            if (flipPixel<Flags>(x, y))
                                 registers[15] = 1;
 
                         x++;
                         i++;
+                        if constexpr (!isClipping)
+                            x = x % display.getWidth();
                     }
 
-                    if (y >= display.getHeight() - 1)
+                    if (isClipping && y >= display.getHeight() - 1)
                         break;
                 }
             }
@@ -358,20 +926,16 @@ bool SChip::decode(uint16_t ins) {
             uint8_t x = (ins % 0xF000) >> 8;
             switch ((ins % 0x100)) {
                 case 0x07:
-                    DEBUG_MSG("Set Register[" << x << "] " << +registers[x] << " to Delay Timer: " << +delay_timer);
                     registers[x] = delay_timer;
                     break;
                 case 0x15:
-                    DEBUG_MSG("Set Delay Timer: " << +delay_timer << " to Register[" << x << "]: " << +registers[x]);
                     delay_timer = registers[x];
                     break;
                 case 0x18:
-                    DEBUG_MSG("Set Sound Timer: " << +sound_timer << " to Register[" << x << "]: " << +registers[x]);
                     sound_timer = registers[x];
                     break;
                 case 0x1E:
                     // Behaviour with carry bit when overflowed
-                    DEBUG_MSG("Increment Index Register by " << std::hex << +registers[x]);
                     index_register += registers[x];
                     if (index_register >= 4096) {
                         registers[15] = 1;
@@ -380,48 +944,55 @@ bool SChip::decode(uint16_t ins) {
                     break;
                 case 0x0A: {
                     // Key is registered on KEYDOWN instead of after KEYUP on original COSMAC VIP
-                    int key{ inputHandler.getKeyBeingPressed() };
-                    if (key == -1) {
+                    // The instruction repeats until the key is released rather than blocking the thread,
+                    // so headless drivers that only change input between frames can still get past it
+                    if (pendingKey == -1) {
+                        int key{ inputHandler.getKeyBeingPressed() };
+                        if (key != -1) {
+                            registers[x] = key;
+                            pendingKey = key;
+                        }
+                        program_counter -= 2;
+                    } else if (inputHandler.isKeyPressed(pendingKey)) {
                         program_counter -= 2;
                     } else {
-                        registers[x] = key;
-                        while (true)
-                            if (inputHandler.getKeyBeingPressed() != key)
-                                break;
+                        pendingKey = -1;
                     }
                     break;
                 }
                 case 0x29:
-                    DEBUG_MSG("Point Index Register to " << std::hex << registers[x] % 0x10);
                     index_register = (registers[x] % 0x10) * 5 + 0x50;
                     break;
                 case 0x30:
-                    DEBUG_MSG("Point Index Register to LARGE" << std::hex << registers[x] % 0x10);
                     index_register = (registers[x] % 0x10) * 10 + 0xA0;
                     break;
                 case 0x33:
-                    DEBUG_MSG("Decode To Decimal: " << +registers[x]);
-                    memory[index_register] = registers[x] / 100;
-                    memory[index_register + 1] = (registers[x] % 100) / 10;
-                    memory[index_register + 2] = registers[x] % 10;
+                    fusions.invalidate(index_register, 3);
+                    memory.write(index_register, registers[x] / 100);
+                    memory.write(index_register + 1, (registers[x] % 100) / 10);
+                    memory.write(index_register + 2, registers[x] % 10);
                     break;
                 case 0x55:
-                    DEBUG_MSG("Load Registers from 0 to " << +x);
+                    fusions.invalidate(index_register, x + 1);
                     for (uint8_t i{}; i <= x; i++) {
-                        memory[index_register + i] = registers[i];
+                        memory.write(index_register + i, registers[i]);
+                    }
+                    if constexpr ((Flags & QuirkFlags::LOAD_STORE_INCREMENTS_I) != 0) {
+                        index_register += x + 1;
                     }
                     break;
                 case 0x65:
-                    DEBUG_MSG("Store Registers from 0 to " << +x);
                     for (uint8_t i{}; i <= x; i++) {
                         registers[i] = memory[index_register + i];
                     }
+                    if constexpr ((Flags & QuirkFlags::LOAD_STORE_INCREMENTS_I) != 0) {
+                        index_register += x + 1;
+                    }
                     break;
                 case 0x75:
                     if (x > 7)
                         goto DEFAULT;
 
-                    DEBUG_MSG("Store Flags from 0 to " << +x);
                     for (uint8_t i{}; i <= x; i++) {
                         flags[i] = registers[i];
                     }
@@ -430,7 +1001,6 @@ bool SChip::decode(uint16_t ins) {
                     if (x > 7)
                         goto DEFAULT;
 
-                    DEBUG_MSG("Load Flags from 0 to " << +x);
                     for (uint8_t i{}; i <= x; i++)
                         registers[i] = flags[i];
 
@@ -442,36 +1012,7 @@ bool SChip::decode(uint16_t ins) {
         }
         DEFAULT:
         default:
-            DEBUG_MSG("Instruction set decode error");
             return false;
     }
-    fflush(stdout);
     return true;
 }
-
-
-// Helper
-void SChip::decodeSmallSprite(uint16_t position, std::vector<bool>& v) const {
-    uint8_t sprite{memory[position]};
-    for (int i{}; i < 8; i++) {
-        v[7 - i] = sprite % 2 == 1;
-        sprite /= 2;
-    }
-}
-
-void SChip::decodeBigSprite(uint16_t position, std::vector<bool>& v) const {
-    uint16_t sprite{ static_cast<uint16_t >(memory[position + 1] + memory[position] * 256) };
-    for (int i{}; i < 16; i++) {
-        v[15 - i] = sprite % 2 == 1;
-        sprite /= 2;
-    }
-}
-
-std::string SChip::spriteToString(std::vector<bool>& v) {
-    std::string s{ "[" };
-    for (bool b : v) {
-        b ? s.append(" 1") : s.append(" 0");
-    }
-    s.append("]");
-    return s;
-}
\ No newline at end of file
@@ -1,23 +1,55 @@
 #ifndef CHIP8_EMULATOR_SCHIP_H
 #define CHIP8_EMULATOR_SCHIP_H
 
+#include <array>
 #include <cstdint>
-#include <stack>
-#include "SDL.h"
+#include <memory>
 #include <vector>
 #include <random>
 #include <string>
 #include "../displays/advanced_display.h"
+#include "../extras/audio_output.h"
+#include "../extras/debugger.h"
 #include "../extras/input_handler.h"
+#include "../extras/paged_memory.h"
+#include "../extras/profiler.h"
+#include "../extras/tracer.h"
 #include "emulator.h"
+#include "fusion.h"
+#include "quirks.h"
+#include "rom_image.h"
 
-class SChip : Emulator {
+// Everything a frame can change, for rolling a core back without going through a file
+// Saving into the same snapshot again reuses its buffers, so taking one every frame allocates nothing
+struct SChipSnapshot {
+    std::array<uint8_t, RAM_SIZE> ram;
+    FusionTable fusions;
+    std::array<uint8_t, 16> registers;
+    std::array<uint8_t, 8> flags;
+    uint16_t programCounter;
+    uint16_t indexRegister;
+    std::array<uint16_t, STACK_SIZE> stack;
+    uint8_t stackPointer;
+    uint8_t delayTimer;
+    uint8_t soundTimer;
+    int pendingKey;
+    int resumeInstruction;
+    std::mt19937 engine;
+    uint64_t instructionCount;
+    uint64_t framesCompleted;
+    uint64_t fusedCount;
+    bool isHires;
+    std::array<uint8_t, AdvancedDisplay::BUFFER_SIZE> pixels;
+};
+
+class SChip : public Emulator {
 public:
     // Computer Parts
-    uint8_t* memory;
+    PagedMemory memory;
     uint16_t program_counter;
     uint16_t index_register;
-    std::stack<uint16_t> stack;
+    std::array<uint16_t, STACK_SIZE> stack;
+    uint8_t stack_pointer; // Counts calls minus returns, the stack is indexed with it masked so no ROM can overrun it
     std::vector<uint8_t> registers;
     std::vector<uint8_t> flags;
 
@@ -27,31 +59,194 @@ public:
 
     // Display
     AdvancedDisplay& display;
+    bool isFramebufferDisplay; // Exactly a AdvancedDisplay, drawn to without virtual calls by the release loop
+
+    // Quirk flags for dispatchQuirks, with FRAMEBUFFER_DISPLAY when the display allows it
+    [[nodiscard]] uint8_t getRunFlags() const {
+        return quirks.getFlags() | (isFramebufferDisplay ? QuirkFlags::FRAMEBUFFER_DISPLAY : 0);
+    }
+
+    template<uint8_t Flags>
+    bool flipPixel(int x, int y) {
+        if constexpr ((Flags & QuirkFlags::FRAMEBUFFER_DISPLAY) != 0) {
+            return display.flipFramebufferPixel(x, y);
+        } else {
+            return display.flipPixel(x, y);
+        }
+    }
+
+    template<uint8_t Flags>
+    void clearScreen() {
+        if constexpr ((Flags & QuirkFlags::FRAMEBUFFER_DISPLAY) != 0) {
+            display.clearFramebuffer();
+        } else {
+            display.clearScreen();
+        }
+    }
 
     // Random number generator
     std::mt19937 engine;
     std::uniform_int_distribution<> dist{ 0, 0xFF };
 
+    // Options
+    Quirks quirks;
+    int instructionsPerFrame;
+    int runAheadFrames;
+    std::unique_ptr<SChipSnapshot> runAheadSnapshot; // Real machine while the paced loop runs ahead of it
+
+    // Statistics
+    uint64_t instructionCount;
+    uint64_t framesCompleted;
+    uint64_t fusedCount;
+
     // Main Operations
-    bool fetch(std::string& filename) const;
+    bool fetch(std::string& filename);
+    bool decode(uint16_t ins); // Picks the instantiation for the current quirks on every call, meant for tests and tools
+    template<uint8_t Flags>
     bool decode(uint16_t ins);
 
+    // Instruction pairs run in one dispatch by the release loop
+    FusionTable fusions;
+    template<uint8_t Flags>
+    bool runFused(Fusion fusion, uint16_t first, uint16_t second); // Returns whether second ran
+
     // Memory
-    void loadFont() const;
+    void loadFont();
 
     // Input
     InputHandler& inputHandler;
+    int pendingKey; // Key FX0A is waiting to be released, -1 if none
+
+    // Profiling and Tracing
+    ExecutionProfiler* profiler;
+    InstructionTracer* tracer;
+    template<uint8_t Flags, typename Profiler, typename Tracer, typename Debug>
+    void runLoop(RunControl& control, Profiler& activeProfiler, Tracer& activeTracer, Debug& activeDebugger);
+    template<uint8_t Flags, typename Profiler, typename Tracer, typename Debug>
+    bool runFrame(Profiler& activeProfiler, Tracer& activeTracer, Debug& activeDebugger, uint64_t inputWindowStart,
+                  uint64_t inputWindow);
+    template<uint8_t Flags, typename Profiler, typename Tracer, typename Debug>
+    bool runFrames(int frameCount, Profiler& activeProfiler, Tracer& activeTracer, Debug& activeDebugger);
+    template<uint8_t Flags>
+    bool runInstruction();
+    template<uint8_t Flags>
+    void runAhead();
+
+    // Audio
+    AudioOutput* audio;
+    bool isSoundPlaying;
+    void updateAudio();
+
+    // Debugging
+    Debugger* debugger;
+    int resumeInstruction; // Instruction of the current frame to carry on from after a debugger stop or step, -1 if none
+    bool isYieldingOnKeyWait; // Set by step for the start of a frame, a frame yields on FX0A at most once
 
-    // Helper
-    void decodeSmallSprite(uint16_t position, std::vector<bool>& v) const;
-    void decodeBigSprite(uint16_t position, std::vector<bool>& v) const;
-    static std::string spriteToString(std::vector<bool>& v);
+    // Used by fork, shares RAM pages with other
+    SChip(const SChip& other, AdvancedDisplay& display, InputHandler& inputHandler);
 
 public:
-    SChip(AdvancedDisplay& display, InputHandler& inputHandler);
+    SChip(AdvancedDisplay& display, InputHandler& inputHandler, const Quirks& quirks = SCHIP_QUIRKS);
     ~SChip() override;
 
-    void run(std::string& filename, bool& stopSignal) override;
+    // Copy of the machine that draws to forkDisplay and reads forkInputHandler, without profiler, tracer or run ahead
+    // RAM pages stay shared with this core until either side writes to them
+    std::unique_ptr<SChip> fork(AdvancedDisplay& forkDisplay, InputHandler& forkInputHandler) const;
+
+    // Profile is written out when the ROM exits. Pass nullptr to disable
+    void setProfiler(ExecutionProfiler* executionProfiler) override {
+        profiler = executionProfiler;
+    }
+
+    // Pass nullptr to disable
+    void setTracer(InstructionTracer* instructionTracer) override {
+        tracer = instructionTracer;
+    }
+
+    // Breakpoints, watchpoints and register conditions, checked only while one is attached. Pass nullptr to disable
+    void setDebugger(Debugger* instructionDebugger) override {
+        debugger = instructionDebugger;
+    }
+
+    // Switched at frame boundaries by the paced loop. Pass nullptr for silence
+    void setAudioOutput(AudioOutput* audioOutput) override {
+        audio = audioOutput;
+    }
+
+    // Takes effect from the next frame
+    void setQuirks(const Quirks& profile) {
+        quirks = profile;
+    }
+
+    [[nodiscard]] const Quirks& getQuirks() const {
+        return quirks;
+    }
+
+    // Speed, 60 frames per second of this many instructions
+    void setInstructionsPerFrame(int count) override {
+        instructionsPerFrame = count > 0 ? count : 1;
+    }
+
+    // Frames the paced loop runs past the real machine with the input held, presents, and then rolls back
+    // Games that answer input a few frames late answer it on the next presented frame. 0 turns it off
+    // Only paced runs without a profiler, tracer or debugger run ahead
+    void setRunAheadFrames(int count) override;
+
+    // Replaces the random_device seed, for runs that have to be reproducible
+    void seedRandom(uint32_t seed) {
+        engine.seed(seed);
+    }
+
+    [[nodiscard]] uint64_t getInstructionCount() const override {
+        return instructionCount;
+    }
+
+    [[nodiscard]] uint64_t getFrameCount() const override {
+        return framesCompleted;
+    }
+
+    // Instructions the release loop ran as the second half of a fused pair, dispatches saved
+    [[nodiscard]] uint64_t getFusedCount() const {
+        return fusedCount;
+    }
+
+    // Fonts and ROM as loadRom lays them out, for reset. False if the ROM does not fit
+    static bool buildRomImage(const uint8_t* data, size_t size, RomImage& image);
+
+    // Back to the state of a new core with image loaded, reusing the memory it already has
+    // The random generator is seeded with seed, settings, the profiler, tracer, debugger and audio are kept
+    void reset(const RomImage& image, uint32_t seed);
+
+    // Headless execution without frame pacing, returns false once the ROM exits
+    bool load(std::string& filename);
+    bool loadRom(const uint8_t* data, size_t size) override;
+    bool runFrames(int frameCount) override;
+    StepResult step() override;
+    bool runInstruction() override;
+
+    // RAM, registers, stack, timers, random generator and screen. Quirks and speed are settings and are not saved
+    bool saveState(const std::string& path) const override;
+    bool loadState(const std::string& path) override;
+
+    // In memory save state of everything but the settings
+    using Snapshot = SChipSnapshot;
+    void saveSnapshot(SChipSnapshot& snapshot) const;
+    // The screen is redrawn but not presented, the caller updates the window surface when it shows a frame
+    void loadSnapshot(const SChipSnapshot& snapshot);
+
+    // The stack depth cannot be set, the rest of the registers can
+    [[nodiscard]] DebugRegisters getDebugRegisters() const override;
+    void setDebugRegisters(const DebugRegisters& debugRegisters) override;
+    [[nodiscard]] uint8_t readMemory(uint16_t address) const override {
+        return memory[address];
+    }
+    void writeMemory(uint16_t address, uint8_t value) override {
+        fusions.invalidate(address, 1);
+        memory.write(address, value);
+    }
+
+    void run(std::string& filename, RunControl& control) override;
+    void resume(RunControl& control) override;
 };
 
 #endif
@@ -0,0 +1,13 @@
+#ifndef CHIP8_EMULATOR_AUDIO_OUTPUT_H
+#define CHIP8_EMULATOR_AUDIO_OUTPUT_H
+
+// Beeper the cores switch on and off, implemented by frontends
+class AudioOutput {
+public:
+    virtual ~AudioOutput() = default;
+
+    // Called at a frame boundary when the sound timer starts or stops
+    virtual void setPlaying(bool isPlaying) = 0;
+};
+
+#endif
@@ -0,0 +1,163 @@
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include "command_line.h"
+
+// Whole argument has to be a number within [min, max]
+static bool parseInt(const char* text, int min, int max, int& value) {
+    char* end;
+    long number{ strtol(text, &end, 10) };
+    if (end == text || *end != '\0' || number < min || number > max) {
+        return false;
+    }
+
+    value = (int) number;
+    return true;
+}
+
+static bool isValueOption(const std::string& argument) {
+    constexpr const char* VALUE_OPTIONS[]{ "--core", "--quirks", "--ipf", "--scale", "--run-ahead", "--frames", "--trace",
+                                           "--profile", "--save-state", "--load-state", "--rom-db", "--gdb", "--netplay",
+                                           "--netplay-port" };
+    for (const char* option : VALUE_OPTIONS) {
+        if (argument == option) {
+            return true;
+        }
+    }
+    return false;
+}
+
+bool parseCommandLine(int argc, const char* const argv[], CommandLineOptions& options, std::string& error) {
+    for (int i{1}; i < argc; i++) {
+        std::string argument{ argv[i] };
+
+        // Flags
+        if (argument == "-h" || argument == "--help") {
+            options.isHelp = true;
+            continue;
+        }
+        if (argument == "--headless") {
+            options.isHeadless = true;
+            continue;
+        }
+        if (argument == "--bench") {
+            options.isBenchmark = true;
+            continue;
+        }
+
+        if (argument.rfind("--", 0) != 0) {
+            if (!options.romPath.empty()) {
+                error = "Only one ROM can be given, got " + options.romPath + " and " + argument;
+                return false;
+            }
+            options.romPath = argument;
+            continue;
+        }
+
+        // Options with a value
+        if (!isValueOption(argument)) {
+            error = "Unknown option " + argument;
+            return false;
+        }
+        if (i + 1 >= argc) {
+            error = argument + " needs a value";
+            return false;
+        }
+        const char* value{ argv[++i] };
+
+        if (argument == "--core") {
+            std::string core{ value };
+            if (core == "auto") {
+                options.core = CoreChoice::AUTO;
+            } else if (core == "chip8") {
+                options.core = CoreChoice::CHIP8;
+            } else if (core == "schip") {
+                options.core = CoreChoice::SCHIP;
+            } else {
+                error = "Unknown core " + core + ", expected auto, chip8 or schip";
+                return false;
+            }
+        } else if (argument == "--quirks") {
+            if (!findQuirksProfile(value, options.quirks)) {
+                error = std::string("Unknown quirks profile ") + value + ", expected vip, chip8, schip or xochip";
+                return false;
+            }
+            options.hasQuirks = true;
+        } else if (argument == "--ipf") {
+            if (!parseInt(value, 1, 1000000, options.instructionsPerFrame)) {
+                error = std::string("--ipf expects a positive number, got ") + value;
+                return false;
+            }
+        } else if (argument == "--scale") {
+            if (!parseInt(value, 1, 64, options.scale)) {
+                error = std::string("--scale expects a pixel size from 1 to 64, got ") + value;
+                return false;
+            }
+        } else if (argument == "--run-ahead") {
+            if (!parseInt(value, 0, MAX_RUN_AHEAD_FRAMES, options.runAheadFrames)) {
+                error = "--run-ahead expects a frame count from 0 to " + std::to_string(MAX_RUN_AHEAD_FRAMES) + ", got " + value;
+                return false;
+            }
+        } else if (argument == "--frames") {
+            if (!parseInt(value, 1, 1 << 30, options.frameCount)) {
+                error = std::string("--frames expects a positive number, got ") + value;
+                return false;
+            }
+        } else if (argument == "--trace") {
+            options.tracePath = value;
+        } else if (argument == "--profile") {
+            options.profilePrefix = value;
+        } else if (argument == "--save-state") {
+            options.saveStatePath = value;
+        } else if (argument == "--load-state") {
+            options.loadStatePath = value;
+        } else if (argument == "--rom-db") {
+            options.romDatabasePath = value;
+        } else if (argument == "--gdb") {
+            if (!parseInt(value, 1, 65535, options.gdbPort)) {
+                error = std::string("--gdb expects a port from 1 to 65535, got ") + value;
+                return false;
+            }
+        } else if (argument == "--netplay") {
+            options.netplayPeer = value;
+        } else if (argument == "--netplay-port") {
+            if (!parseInt(value, 1, 65535, options.netplayPort)) {
+                error = std::string("--netplay-port expects a port from 1 to 65535, got ") + value;
+                return false;
+            }
+        }
+    }
+
+    if (options.romPath.empty() && !options.isHelp) {
+        error = "No ROM given";
+        return false;
+    }
+    if (options.isHeadless && options.frameCount == 0) {
+        options.frameCount = HEADLESS_FRAME_COUNT;
+    }
+    return true;
+}
+
+void printUsage(const char* program) {
+    printf("Usage: %s <rom> [options]\n", program);
+    printf("  --core auto|chip8|schip   Core to run, auto picks it from the ROM database (default auto)\n");
+    printf("  --quirks vip|chip8|schip|xochip\n");
+    printf("                            Quirks profile, overrides the ROM database\n");
+    printf("  --ipf <n>                 Instructions per frame, overrides the ROM database\n");
+    printf("  --scale <n>               Size of a lores pixel in the window (default %d)\n", PIXEL_SIZE);
+    printf("  --run-ahead <n>           Frames to show ahead of the machine to hide input lag, 0 to %d (default 0)\n",
+           MAX_RUN_AHEAD_FRAMES);
+    printf("  --headless                Run without a window or audio, as fast as possible\n");
+    printf("  --frames <n>              Frames to run headless (default %d)\n", HEADLESS_FRAME_COUNT);
+    printf("  --bench                   Print instructions and frames per second when done\n");
+    printf("  --trace <file>            Write a binary instruction trace, see tools/trace_decoder\n");
+    printf("  --profile <prefix>        Write an execution profile to <prefix>.txt and <prefix>.folded\n");
+    printf("  --load-state <file>       Start from a save state instead of a fresh machine\n");
+    printf("  --save-state <file>       Save the machine state when the run ends\n");
+    printf("  --gdb <port>              Serve GDB on 127.0.0.1:<port>, the ROM starts halted\n");
+    printf("                            Headless runs last until GDB detaches\n");
+    printf("  --netplay <host:port>     Two player rollback netplay with the peer or relay at host:port\n");
+    printf("  --netplay-port <port>     Local UDP port for netplay (default %d)\n", DEFAULT_NETPLAY_PORT);
+    printf("  --rom-db <file>           ROM database index (default ../rom_database.idx)\n");
+    printf("  -h, --help                Show this help\n");
+}
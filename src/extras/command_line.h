@@ -0,0 +1,46 @@
+#ifndef CHIP8_EMULATOR_COMMAND_LINE_H
+#define CHIP8_EMULATOR_COMMAND_LINE_H
+
+#include <string>
+#include "../constants.h"
+#include "../emulators/quirks.h"
+
+enum class CoreChoice {
+    AUTO, // From the ROM database, SCHIP if the ROM is not in it
+    CHIP8,
+    SCHIP
+};
+
+constexpr int HEADLESS_FRAME_COUNT{600}; // Ten seconds of emulated time
+constexpr int DEFAULT_NETPLAY_PORT{7050};
+
+// Everything the front end can be told on the command line
+// Empty strings and zero counts mean the option was not given
+struct CommandLineOptions {
+    std::string romPath;
+    CoreChoice core{CoreChoice::AUTO};
+    bool hasQuirks{};
+    Quirks quirks{};
+    int instructionsPerFrame{};
+    int scale{PIXEL_SIZE};
+    int runAheadFrames{};
+    bool isHeadless{};
+    int frameCount{};
+    bool isBenchmark{};
+    std::string tracePath;
+    std::string profilePrefix;
+    std::string saveStatePath;
+    std::string loadStatePath;
+    std::string romDatabasePath{"../rom_database.idx"};
+    int gdbPort{};
+    std::string netplayPeer; // host:port of the other player or a relay, checked when connecting
+    int netplayPort{DEFAULT_NETPLAY_PORT};
+    bool isHelp{};
+};
+
+// On failure error says which argument was wrong
+bool parseCommandLine(int argc, const char* const argv[], CommandLineOptions& options, std::string& error);
+
+void printUsage(const char* program);
+
+#endif
@@ -0,0 +1,247 @@
+#include <algorithm>
+#include <chrono>
+#include "debugger.h"
+#include "run_control.h"
+
+Debugger::Debugger(): nextId{}, isResuming{}, hasPendingWatch{}, pendingAddress{}, pendingId{-1}, stepsRemaining{},
+    isStopRequested{}, stopped{}, stopInfo{ StopReason::NONE, 0, 0, -1 }
+{
+    rebuildBreakpointMap();
+}
+
+
+// Breakpoints
+// Going round RAM twice lets the addresses near its end see the breakpoints the program counter wraps around to
+void Debugger::rebuildBreakpointMap() {
+    uint16_t next[2]{ RAM_SIZE, RAM_SIZE };
+    for (int pass{}; pass < 2; pass++) {
+        for (int address{ RAM_SIZE - 1 }; address >= 0; address--) {
+            nextBreakpoints[address] = next[address % 2];
+            if (breakpoints.test(address)) {
+                next[address % 2] = address;
+            }
+        }
+    }
+}
+
+void Debugger::addBreakpoint(uint16_t address) {
+    breakpoints.set(address % RAM_SIZE);
+    rebuildBreakpointMap();
+}
+
+void Debugger::removeBreakpoint(uint16_t address) {
+    breakpoints.reset(address % RAM_SIZE);
+    rebuildBreakpointMap();
+}
+
+bool Debugger::hasBreakpoint(uint16_t address) const {
+    return breakpoints.test(address % RAM_SIZE);
+}
+
+
+// Watchpoints
+void Debugger::rebuildWatchMaps() {
+    readWatched.reset();
+    writeWatched.reset();
+    for (auto& watchpoint : watchpoints) {
+        for (int i{}; i < watchpoint.length; i++) {
+            int address{ (watchpoint.address + i) % RAM_SIZE };
+            if ((uint8_t) watchpoint.kind & (uint8_t) WatchKind::READ) {
+                readWatched.set(address);
+            }
+            if ((uint8_t) watchpoint.kind & (uint8_t) WatchKind::WRITE) {
+                writeWatched.set(address);
+            }
+        }
+    }
+}
+
+int Debugger::addWatchpoint(uint16_t address, uint16_t length, WatchKind kind) {
+    int id{ nextId++ };
+    watchpoints.push_back(Watchpoint{ id, (uint16_t) (address % RAM_SIZE), std::min<uint16_t>(length, RAM_SIZE), kind });
+    rebuildWatchMaps();
+    return id;
+}
+
+bool Debugger::removeWatchpoint(int id) {
+    auto it{ std::find_if(watchpoints.begin(), watchpoints.end(), [&](const Watchpoint& w) { return w.id == id; }) };
+    if (it == watchpoints.end()) {
+        return false;
+    }
+
+    watchpoints.erase(it);
+    rebuildWatchMaps();
+    return true;
+}
+
+// First watchpoint of the right kind covering address, the maps already said there is one
+int Debugger::findWatchpoint(uint16_t address, bool isWrite) const {
+    WatchKind kind{ isWrite ? WatchKind::WRITE : WatchKind::READ };
+    for (auto& watchpoint : watchpoints) {
+        if (((uint8_t) watchpoint.kind & (uint8_t) kind) == 0) {
+            continue;
+        }
+        if ((address - watchpoint.address + RAM_SIZE) % RAM_SIZE < watchpoint.length) {
+            return watchpoint.id;
+        }
+    }
+    return -1;
+}
+
+
+// Register Conditions
+int Debugger::addRegisterCondition(uint8_t reg, Comparison comparison, uint8_t value) {
+    int id{ nextId++ };
+    conditions.push_back(RegisterCondition{ id, (uint8_t) (reg & 0xF), comparison, value, false });
+    return id;
+}
+
+bool Debugger::removeRegisterCondition(int id) {
+    auto it{ std::find_if(conditions.begin(), conditions.end(), [&](const RegisterCondition& c) { return c.id == id; }) };
+    if (it == conditions.end()) {
+        return false;
+    }
+
+    conditions.erase(it);
+    return true;
+}
+
+void Debugger::clear() {
+    breakpoints.reset();
+    watchpoints.clear();
+    conditions.clear();
+    rebuildBreakpointMap();
+    rebuildWatchMaps();
+}
+
+
+// Control
+void Debugger::stop(StopReason reason, uint16_t pc, uint16_t address, int id) {
+    std::lock_guard<std::mutex> lock{ mutex };
+    stopInfo = StopInfo{ reason, pc, address, id };
+    stepsRemaining = 0;
+    stopped.store(true, std::memory_order_release);
+    stopChanged.notify_all();
+}
+
+void Debugger::requestStop() {
+    isStopRequested.store(true, std::memory_order_release);
+}
+
+void Debugger::resume() {
+    std::lock_guard<std::mutex> lock{ mutex };
+    isResuming = true;
+    stopInfo = StopInfo{ StopReason::NONE, 0, 0, -1 };
+    stopped.store(false, std::memory_order_release);
+    stopChanged.notify_all();
+}
+
+void Debugger::step(int count) {
+    {
+        std::lock_guard<std::mutex> lock{ mutex };
+        stepsRemaining = count > 0 ? count : 1;
+    }
+    resume();
+}
+
+StopInfo Debugger::getStopInfo() const {
+    std::lock_guard<std::mutex> lock{ mutex };
+    return stopInfo;
+}
+
+bool Debugger::waitForStop(int timeoutMs) {
+    std::unique_lock<std::mutex> lock{ mutex };
+    return stopChanged.wait_for(lock, std::chrono::milliseconds(timeoutMs), [this] {
+        return stopped.load(std::memory_order_acquire);
+    });
+}
+
+
+// Emulator thread
+void Debugger::waitWhileStopped(RunControl& control) {
+    // The listener takes the lock before notifying, so a stop between checking and waiting is not missed
+    control.setStopListener([this] {
+        std::lock_guard<std::mutex> lock{ mutex };
+        stopChanged.notify_all();
+    });
+    {
+        std::unique_lock<std::mutex> lock{ mutex };
+        stopChanged.wait(lock, [this, &control] {
+            return !stopped.load(std::memory_order_acquire) || control.isStopping();
+        });
+    }
+    control.setStopListener(nullptr);
+}
+
+bool Debugger::beforeInstruction(uint16_t pc, uint16_t ins, uint16_t index, int bigSpriteBytes) {
+    if (isStopRequested.exchange(false, std::memory_order_acq_rel)) {
+        stop(StopReason::REQUESTED, pc, 0, -1);
+        return true;
+    }
+
+    bool isSkippingBreakpoint{ isResuming };
+    isResuming = false;
+    if (!isSkippingBreakpoint && breakpoints.test(pc % RAM_SIZE)) {
+        stop(StopReason::BREAKPOINT, pc, pc, -1);
+        return true;
+    }
+
+    // The range is taken before the instruction runs, FX55 and FX65 may move I
+    if (watchpoints.empty()) {
+        return false;
+    }
+
+    MemoryAccess access{ memoryAccessOf(ins, index, bigSpriteBytes) };
+    const std::bitset<RAM_SIZE>& watched{ access.isWrite ? writeWatched : readWatched };
+    for (int i{}; i < access.length; i++) {
+        uint16_t address{ (uint16_t) ((access.address + i) % RAM_SIZE) };
+        if (watched.test(address)) {
+            hasPendingWatch = true;
+            pendingAddress = address;
+            pendingId = findWatchpoint(address, access.isWrite);
+            break;
+        }
+    }
+    return false;
+}
+
+bool Debugger::afterInstruction(uint16_t pc, const uint8_t* registers) {
+    bool isStopping{};
+    if (hasPendingWatch) {
+        hasPendingWatch = false;
+        stop(StopReason::WATCHPOINT, pc, pendingAddress, pendingId);
+        isStopping = true;
+    }
+
+    // Every condition is updated even after one fires, so none of them fires late
+    for (auto& condition : conditions) {
+        uint8_t value{ registers[condition.reg] };
+        bool isTrue;
+        switch (condition.comparison) {
+            case Comparison::EQUAL:
+                isTrue = value == condition.value;
+                break;
+            case Comparison::NOT_EQUAL:
+                isTrue = value != condition.value;
+                break;
+            case Comparison::LESS:
+                isTrue = value < condition.value;
+                break;
+            default:
+                isTrue = value > condition.value;
+                break;
+        }
+
+        if (isTrue && !condition.wasTrue && !isStopping) {
+            stop(StopReason::REGISTER_CONDITION, pc, 0, condition.id);
+            isStopping = true;
+        }
+        condition.wasTrue = isTrue;
+    }
+
+    if (!isStopping && stepsRemaining > 0 && --stepsRemaining == 0) {
+        stop(StopReason::STEP, pc, 0, -1);
+        isStopping = true;
+    }
+    return isStopping;
+}
@@ -0,0 +1,315 @@
+#ifndef CHIP8_EMULATOR_DEBUGGER_H
+#define CHIP8_EMULATOR_DEBUGGER_H
+
+#include <array>
+#include <atomic>
+#include <bitset>
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <type_traits>
+#include <vector>
+#include "../constants.h"
+#include "../emulators/opcodes.h"
+
+class RunControl;
+
+// Debugging policies for the run loop of Chip8 and SChip
+// Like the profiler and tracer, the release loop is instantiated with NullDebugger and carries no checks.
+// A core with only a Debugger attached runs the release loop with BlockDebugger, which consults it where blocks start.
+// Steps, register conditions, the profiler and the tracer need the diagnostic instantiation, which calls it around
+// every instruction
+
+enum class StopReason : uint8_t {
+    NONE,
+    BREAKPOINT,         // Before the instruction at pc
+    WATCHPOINT,         // After the instruction that touched address
+    REGISTER_CONDITION, // After the instruction that made the condition true
+    STEP,               // After the last requested step
+    REQUESTED           // requestStop, before the instruction at pc
+};
+
+enum class WatchKind : uint8_t {
+    READ = 1,
+    WRITE = 2,
+    ACCESS = 3
+};
+
+enum class Comparison : uint8_t {
+    EQUAL,
+    NOT_EQUAL,
+    LESS,
+    GREATER
+};
+
+struct StopInfo {
+    StopReason reason;
+    uint16_t pc;      // Next instruction to run
+    uint16_t address; // Watched byte that was accessed
+    int id;           // Watchpoint or register condition that fired, -1 otherwise
+};
+
+// Machine registers as a debugger sees them, sp is the depth of the call stack
+struct DebugRegisters {
+    uint8_t v[16];
+    uint16_t i;
+    uint16_t pc;
+    uint8_t sp;
+    uint8_t delayTimer;
+    uint8_t soundTimer;
+};
+
+// RAM an instruction reads or writes through I, other than the instruction fetch
+// bigSpriteBytes is how much DXY0 draws from, 0 on cores without big sprites
+struct MemoryAccess {
+    uint16_t address;
+    uint16_t length;
+    bool isWrite;
+};
+
+constexpr MemoryAccess memoryAccessOf(uint16_t ins, uint16_t index, int bigSpriteBytes) {
+    uint16_t x{ (uint16_t) ((ins >> 8) & 0xF) };
+    switch (classifyOpcode(ins)) {
+        case Opcode::DRAW:
+            return { index, (uint16_t) (ins % 0x10), false };
+        case Opcode::DRAW_BIG:
+            return { index, (uint16_t) bigSpriteBytes, false };
+        case Opcode::BCD:
+            return { index, 3, true };
+        case Opcode::STORE:
+            return { index, (uint16_t) (x + 1), true };
+        case Opcode::LOAD:
+            return { index, (uint16_t) (x + 1), false };
+        default:
+            return { index, 0, false };
+    }
+}
+
+// Breakpoints, watchpoints and register conditions for one core
+// Set them up while the core is stopped or not running; requestStop, resume and step can be called from any thread
+class Debugger {
+private:
+    struct Watchpoint {
+        int id;
+        uint16_t address;
+        uint16_t length;
+        WatchKind kind;
+    };
+
+    struct RegisterCondition {
+        int id;
+        uint8_t reg;
+        Comparison comparison;
+        uint8_t value;
+        bool wasTrue; // Conditions fire when they become true, not for as long as they stay true
+    };
+
+    std::bitset<RAM_SIZE> breakpoints;
+    std::array<uint16_t, RAM_SIZE> nextBreakpoints; // First breakpoint on the straight line after each address, RAM_SIZE if none
+    std::vector<Watchpoint> watchpoints;
+    std::bitset<RAM_SIZE> readWatched;  // Union of the read watchpoints, rebuilt when they change
+    std::bitset<RAM_SIZE> writeWatched;
+    std::vector<RegisterCondition> conditions;
+    int nextId;
+
+    // Emulator thread
+    bool isResuming; // The breakpoint at the resume address is stepped over once
+    bool hasPendingWatch;
+    uint16_t pendingAddress;
+    int pendingId;
+    int stepsRemaining;
+
+    // Shared with the controlling thread
+    mutable std::mutex mutex;
+    std::condition_variable stopChanged;
+    std::atomic<bool> isStopRequested;
+    std::atomic<bool> stopped;
+    StopInfo stopInfo;
+
+    void rebuildBreakpointMap();
+    void rebuildWatchMaps();
+    void stop(StopReason reason, uint16_t pc, uint16_t address, int id);
+    int findWatchpoint(uint16_t address, bool isWrite) const;
+
+public:
+    Debugger();
+
+    // Breakpoints
+    void addBreakpoint(uint16_t address);
+    void removeBreakpoint(uint16_t address);
+    [[nodiscard]] bool hasBreakpoint(uint16_t address) const;
+
+    // Watchpoints, the range wraps around the end of RAM like the cores' addressing. Returns an id for removal
+    int addWatchpoint(uint16_t address, uint16_t length, WatchKind kind);
+    bool removeWatchpoint(int id);
+
+    // Break when VX compared to value becomes true
+    int addRegisterCondition(uint8_t reg, Comparison comparison, uint8_t value);
+    bool removeRegisterCondition(int id);
+
+    void clear();
+
+    // Control
+    void requestStop();
+    void resume();
+    void step(int count = 1);
+
+    [[nodiscard]] bool isStopped() const {
+        return stopped.load(std::memory_order_acquire);
+    }
+
+    [[nodiscard]] StopInfo getStopInfo() const;
+
+    // Blocks until the core stops, returns false if it did not within timeoutMs
+    bool waitForStop(int timeoutMs);
+
+    // Emulator thread, blocks while stopped until resumed or the run stops
+    void waitWhileStopped(RunControl& control);
+
+    // Emulator thread, called by the diagnostic loop
+    // True means stop before running ins
+    bool beforeInstruction(uint16_t pc, uint16_t ins, uint16_t index, int bigSpriteBytes);
+    // True means stop after the instruction that just ran
+    bool afterInstruction(uint16_t pc, const uint8_t* registers);
+
+    // Emulator thread, used by BlockDebugger
+    [[nodiscard]] bool isCheckingEveryInstruction() const {
+        return stepsRemaining > 0 || !conditions.empty();
+    }
+
+    [[nodiscard]] bool hasWatchpoints() const {
+        return !watchpoints.empty();
+    }
+
+    [[nodiscard]] uint16_t getNextBreakpoint(uint16_t pc) const {
+        return nextBreakpoints[pc % RAM_SIZE];
+    }
+};
+
+struct NullDebugger {
+    [[nodiscard]] bool isStopped() const {
+        return false;
+    }
+
+    void waitWhileStopped(RunControl& control) {}
+
+    [[nodiscard]] bool canFuse(uint16_t secondPc, uint16_t secondIns, int bigSpriteBytes) const {
+        return true;
+    }
+
+    [[nodiscard]] bool canSkipPasses(uint16_t first, uint16_t last) const {
+        return true;
+    }
+
+    bool beforeInstruction(uint16_t pc, uint16_t ins, uint16_t index, int bigSpriteBytes) {
+        return false;
+    }
+
+    bool afterInstruction(uint16_t pc, const uint8_t* registers) {
+        return false;
+    }
+};
+
+// Consults a Debugger only where a block of straight line code starts, so the release loop keeps running with it
+// A block starts at the first instruction of a frame, wherever a jump, call, return or taken skip lands, and at the
+// next breakpoint on the straight line from the start of the last one. While there are watchpoints, instructions
+// that access memory through I are checked too
+class BlockDebugger {
+private:
+    static constexpr uint16_t NO_ADDRESS{0xFFFF};
+
+    Debugger& debugger;
+    uint16_t expectedPc; // Where the last instruction falls through to
+    uint16_t nextCheck;  // Next breakpoint on the straight line
+    bool isWatching;
+    bool isChecked;      // The debugger saw the instruction that is running
+
+public:
+    explicit BlockDebugger(Debugger& debugger): debugger{debugger}, expectedPc{NO_ADDRESS}, nextCheck{NO_ADDRESS},
+        isWatching{}, isChecked{} {}
+
+    [[nodiscard]] bool isStopped() const {
+        return debugger.isStopped();
+    }
+
+    void waitWhileStopped(RunControl& control) {
+        debugger.waitWhileStopped(control);
+    }
+
+    // False if the frame has to run on the diagnostic loop instead
+    bool beginFrame() {
+        expectedPc = NO_ADDRESS;
+        isWatching = debugger.hasWatchpoints();
+        return !debugger.isCheckingEveryInstruction();
+    }
+
+    // The second instruction of a fused pair runs without being checked, the pair falls through past it
+    bool canFuse(uint16_t secondPc, uint16_t secondIns, int bigSpriteBytes) {
+        if (debugger.hasBreakpoint(secondPc) || (isWatching && memoryAccessOf(secondIns, 0, bigSpriteBytes).length > 0)) {
+            return false;
+        }
+        expectedPc = secondPc + 2;
+        return true;
+    }
+
+    // Idle loops never access memory through I, only their breakpoints matter
+    [[nodiscard]] bool canSkipPasses(uint16_t first, uint16_t last) const {
+        for (uint16_t pc{ first }; pc <= last; pc += 2) {
+            if (debugger.hasBreakpoint(pc)) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    bool beforeInstruction(uint16_t pc, uint16_t ins, uint16_t index, int bigSpriteBytes) {
+        bool isBlockStart{ pc != expectedPc || pc % RAM_SIZE == nextCheck };
+        expectedPc = pc + 2;
+        isChecked = isBlockStart || (isWatching && memoryAccessOf(ins, index, bigSpriteBytes).length > 0);
+        if (!isChecked) {
+            return false;
+        }
+
+        if (isBlockStart) {
+            nextCheck = debugger.getNextBreakpoint(pc);
+        }
+        return debugger.beforeInstruction(pc, ins, index, bigSpriteBytes);
+    }
+
+    bool afterInstruction(uint16_t pc, const uint8_t* registers) {
+        return isChecked && debugger.afterInstruction(pc, registers);
+    }
+};
+
+// Forwards to a Debugger that may be null, shares the diagnostic instantiation with the profiler and tracer
+class OptionalDebugger {
+private:
+    Debugger* debugger;
+
+public:
+    explicit OptionalDebugger(Debugger* debugger): debugger{debugger} {}
+
+    [[nodiscard]] bool isStopped() const {
+        return debugger != nullptr && debugger->isStopped();
+    }
+
+    void waitWhileStopped(RunControl& control) {
+        if (debugger != nullptr) {
+            debugger->waitWhileStopped(control);
+        }
+    }
+
+    bool beforeInstruction(uint16_t pc, uint16_t ins, uint16_t index, int bigSpriteBytes) {
+        return debugger != nullptr && debugger->beforeInstruction(pc, ins, index, bigSpriteBytes);
+    }
+
+    bool afterInstruction(uint16_t pc, const uint8_t* registers) {
+        return debugger != nullptr && debugger->afterInstruction(pc, registers);
+    }
+};
+
+// Fused pairs and skipped idle passes are left out of the diagnostic loop, whose policies see every instruction
+template<typename Debug>
+constexpr bool IS_DIAGNOSTIC_LOOP{ std::is_same_v<Debug, OptionalDebugger> };
+
+#endif
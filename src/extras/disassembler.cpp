@@ -0,0 +1,305 @@
+#include <algorithm>
+#include <cstdio>
+#include <set>
+#include "disassembler.h"
+
+constexpr uint16_t ROM_START{0x200};
+constexpr int DATA_BYTES_PER_LINE{8};
+
+
+// Helper
+static Opcode classify(uint16_t ins, bool isSchip) {
+    return isSchip ? classifyOpcode(ins) : classifyChip8Opcode(ins);
+}
+
+static bool isInRom(uint32_t address, size_t size) {
+    return address >= ROM_START && address + 1 < ROM_START + size && address + 1 < RAM_SIZE;
+}
+
+static uint16_t fetch(const uint8_t* rom, uint16_t address) {
+    return (uint16_t) (rom[address - ROM_START] << 8 | rom[address - ROM_START + 1]);
+}
+
+static bool isSkip(Opcode op) {
+    switch (op) {
+        case Opcode::SKIP_EQ_IMM:
+        case Opcode::SKIP_NE_IMM:
+        case Opcode::SKIP_EQ_REG:
+        case Opcode::SKIP_NE_REG:
+        case Opcode::SKIP_KEY:
+        case Opcode::SKIP_NOT_KEY:
+            return true;
+        default:
+            return false;
+    }
+}
+
+// Control never falls through to the next instruction
+static bool isBlockEnd(Opcode op) {
+    switch (op) {
+        case Opcode::JUMP:
+        case Opcode::JUMP_OFFSET:
+        case Opcode::RETURN:
+        case Opcode::EXIT:
+        case Opcode::INVALID:
+            return true;
+        default:
+            return isSkip(op);
+    }
+}
+
+std::string disassembleInstruction(uint16_t ins, bool isSchip) {
+    int x{ (ins >> 8) & 0xF };
+    int y{ (ins >> 4) & 0xF };
+    int n{ ins & 0xF };
+    int nn{ ins & 0xFF };
+    int nnn{ ins & 0xFFF };
+
+    char text[32];
+    switch (classify(ins, isSchip)) {
+        case Opcode::SCROLL_DOWN: snprintf(text, sizeof(text), "SCD %d", n); break;
+        case Opcode::CLEAR: snprintf(text, sizeof(text), "CLS"); break;
+        case Opcode::RETURN: snprintf(text, sizeof(text), "RET"); break;
+        case Opcode::SCROLL_RIGHT: snprintf(text, sizeof(text), "SCR"); break;
+        case Opcode::SCROLL_LEFT: snprintf(text, sizeof(text), "SCL"); break;
+        case Opcode::EXIT: snprintf(text, sizeof(text), "EXIT"); break;
+        case Opcode::LORES: snprintf(text, sizeof(text), "LOW"); break;
+        case Opcode::HIRES: snprintf(text, sizeof(text), "HIGH"); break;
+        case Opcode::JUMP: snprintf(text, sizeof(text), "JP #%03X", nnn); break;
+        case Opcode::CALL: snprintf(text, sizeof(text), "CALL #%03X", nnn); break;
+        case Opcode::SKIP_EQ_IMM: snprintf(text, sizeof(text), "SE V%X, #%02X", x, nn); break;
+        case Opcode::SKIP_NE_IMM: snprintf(text, sizeof(text), "SNE V%X, #%02X", x, nn); break;
+        case Opcode::SKIP_EQ_REG: snprintf(text, sizeof(text), "SE V%X, V%X", x, y); break;
+        case Opcode::SET_IMM: snprintf(text, sizeof(text), "LD V%X, #%02X", x, nn); break;
+        case Opcode::ADD_IMM: snprintf(text, sizeof(text), "ADD V%X, #%02X", x, nn); break;
+        case Opcode::SET_REG: snprintf(text, sizeof(text), "LD V%X, V%X", x, y); break;
+        case Opcode::OR: snprintf(text, sizeof(text), "OR V%X, V%X", x, y); break;
+        case Opcode::AND: snprintf(text, sizeof(text), "AND V%X, V%X", x, y); break;
+        case Opcode::XOR: snprintf(text, sizeof(text), "XOR V%X, V%X", x, y); break;
+        case Opcode::ADD_REG: snprintf(text, sizeof(text), "ADD V%X, V%X", x, y); break;
+        case Opcode::SUB: snprintf(text, sizeof(text), "SUB V%X, V%X", x, y); break;
+        case Opcode::SHIFT_RIGHT: snprintf(text, sizeof(text), "SHR V%X, V%X", x, y); break;
+        case Opcode::SUB_REVERSE: snprintf(text, sizeof(text), "SUBN V%X, V%X", x, y); break;
+        case Opcode::SHIFT_LEFT: snprintf(text, sizeof(text), "SHL V%X, V%X", x, y); break;
+        case Opcode::SKIP_NE_REG: snprintf(text, sizeof(text), "SNE V%X, V%X", x, y); break;
+        case Opcode::SET_INDEX: snprintf(text, sizeof(text), "LD I, #%03X", nnn); break;
+        case Opcode::JUMP_OFFSET: snprintf(text, sizeof(text), "JP V0, #%03X", nnn); break;
+        case Opcode::RANDOM: snprintf(text, sizeof(text), "RND V%X, #%02X", x, nn); break;
+        case Opcode::DRAW:
+        case Opcode::DRAW_BIG: snprintf(text, sizeof(text), "DRW V%X, V%X, %d", x, y, n); break;
+        case Opcode::SKIP_KEY: snprintf(text, sizeof(text), "SKP V%X", x); break;
+        case Opcode::SKIP_NOT_KEY: snprintf(text, sizeof(text), "SKNP V%X", x); break;
+        case Opcode::GET_DELAY: snprintf(text, sizeof(text), "LD V%X, DT", x); break;
+        case Opcode::WAIT_KEY: snprintf(text, sizeof(text), "LD V%X, K", x); break;
+        case Opcode::SET_DELAY: snprintf(text, sizeof(text), "LD DT, V%X", x); break;
+        case Opcode::SET_SOUND: snprintf(text, sizeof(text), "LD ST, V%X", x); break;
+        case Opcode::ADD_INDEX: snprintf(text, sizeof(text), "ADD I, V%X", x); break;
+        case Opcode::FONT: snprintf(text, sizeof(text), "LD F, V%X", x); break;
+        case Opcode::BIG_FONT: snprintf(text, sizeof(text), "LD HF, V%X", x); break;
+        case Opcode::BCD: snprintf(text, sizeof(text), "LD B, V%X", x); break;
+        case Opcode::STORE: snprintf(text, sizeof(text), "LD [I], V%X", x); break;
+        case Opcode::LOAD: snprintf(text, sizeof(text), "LD V%X, [I]", x); break;
+        case Opcode::SAVE_FLAGS: snprintf(text, sizeof(text), "LD R, V%X", x); break;
+        case Opcode::LOAD_FLAGS: snprintf(text, sizeof(text), "LD V%X, R", x); break;
+        default: snprintf(text, sizeof(text), "DW #%04X", ins); break;
+    }
+    return text;
+}
+
+const BasicBlock* ControlFlowGraph::findBlock(uint16_t address) const {
+    auto it{ std::lower_bound(blocks.begin(), blocks.end(), address, [](const BasicBlock& block, uint16_t start) {
+        return block.start < start;
+    }) };
+    return it != blocks.end() && it->start == address ? &*it : nullptr;
+}
+
+
+// Analysis
+ControlFlowGraph analyseRom(const uint8_t* rom, size_t size, bool isSchip) {
+    ControlFlowGraph graph{};
+    graph.isSchip = isSchip;
+    if (!isInRom(ROM_START, size)) {
+        return graph;
+    }
+
+    // Reachable instructions, and the addresses control can arrive at other than by falling through
+    std::bitset<RAM_SIZE> leaders;
+    std::set<uint16_t> functions{ ROM_START };
+    std::vector<uint16_t> worklist{ ROM_START };
+    leaders.set(ROM_START);
+    auto addTarget{ [&](uint16_t target) {
+        leaders.set(target % RAM_SIZE);
+        worklist.push_back(target % RAM_SIZE);
+    } };
+
+    while (!worklist.empty()) {
+        uint16_t address{ worklist.back() };
+        worklist.pop_back();
+
+        uint16_t start{ address };
+        while (isInRom(address, size)) {
+            // Falling into code found from somewhere else joins two paths
+            if (graph.code.test(address)) {
+                if (address != start) {
+                    leaders.set(address);
+                }
+                break;
+            }
+
+            uint16_t ins{ fetch(rom, address) };
+            Opcode op{ classify(ins, isSchip) };
+            if (op == Opcode::INVALID) {
+                break;
+            }
+
+            graph.code.set(address);
+            uint16_t next{ (uint16_t) (address + 2) };
+            if (op == Opcode::JUMP) {
+                addTarget(ins & 0xFFF);
+            } else if (op == Opcode::CALL) {
+                functions.insert(ins & 0xFFF);
+                addTarget(ins & 0xFFF);
+            } else if (isSkip(op)) {
+                addTarget(next);
+                addTarget(next + 2);
+            }
+
+            if (isBlockEnd(op)) {
+                break;
+            }
+            address = next;
+        }
+    }
+
+    // Blocks run from a leader up to the next leader or the instruction that ends them
+    for (uint32_t start{ ROM_START }; start < RAM_SIZE; start++) {
+        if (!leaders.test(start) || !graph.code.test(start)) {
+            continue;
+        }
+
+        BasicBlock block{ (uint16_t) start, (uint16_t) start, {}, false };
+        Opcode last{};
+        uint16_t lastIns{};
+        do {
+            lastIns = fetch(rom, block.end);
+            last = classify(lastIns, isSchip);
+            block.end += 2;
+        } while (!isBlockEnd(last) && block.end < RAM_SIZE && graph.code.test(block.end) && !leaders.test(block.end));
+
+        if (last == Opcode::JUMP) {
+            block.successors.push_back(lastIns & 0xFFF);
+        } else if (isSkip(last)) {
+            block.successors.push_back(block.end);
+            block.successors.push_back(block.end + 2);
+        } else if (last == Opcode::JUMP_OFFSET) {
+            block.isIndirect = true;
+        } else if (!isBlockEnd(last) && block.end < RAM_SIZE && graph.code.test(block.end)) {
+            block.successors.push_back(block.end);
+        }
+        graph.blocks.push_back(block);
+    }
+
+    // Call graph, each function is the blocks reachable from its entry without going through a call
+    graph.functions.assign(functions.begin(), functions.end());
+    std::set<std::pair<uint16_t, uint16_t>> calls;
+    for (uint16_t function : graph.functions) {
+        std::bitset<RAM_SIZE> visited;
+        std::vector<uint16_t> pending{ function };
+        while (!pending.empty()) {
+            const BasicBlock* block{ graph.findBlock(pending.back()) };
+            pending.pop_back();
+            if (block == nullptr || visited.test(block->start)) {
+                continue;
+            }
+            visited.set(block->start);
+
+            for (uint16_t address{ block->start }; address < block->end; address += 2) {
+                uint16_t ins{ fetch(rom, address) };
+                if (classify(ins, isSchip) == Opcode::CALL) {
+                    calls.insert({ function, (uint16_t) (ins & 0xFFF) });
+                }
+            }
+            pending.insert(pending.end(), block->successors.begin(), block->successors.end());
+        }
+    }
+    graph.calls.assign(calls.begin(), calls.end());
+    return graph;
+}
+
+
+// Output
+void writeListing(const ControlFlowGraph& graph, const uint8_t* rom, size_t size, std::ostream& out) {
+    char line[96];
+    snprintf(line, sizeof(line), "; %s, %zu blocks, %zu functions, %zu calls\n", graph.isSchip ? "SCHIP" : "CHIP-8",
+             graph.blocks.size(), graph.functions.size(), graph.calls.size());
+    out << line;
+
+    uint32_t end{ std::min<uint32_t>(ROM_START + size, RAM_SIZE) };
+    uint32_t address{ ROM_START };
+    while (address < end) {
+        if (!graph.code.test(address)) {
+            // Data runs until the next instruction
+            snprintf(line, sizeof(line), "  %03X  DB", address);
+            out << line;
+            for (int i{}; i < DATA_BYTES_PER_LINE && address < end && !graph.code.test(address); i++, address++) {
+                snprintf(line, sizeof(line), "%s #%02X", i == 0 ? "" : ",", rom[address - ROM_START]);
+                out << line;
+            }
+            out << "\n";
+            continue;
+        }
+
+        if (std::binary_search(graph.functions.begin(), graph.functions.end(), address)) {
+            snprintf(line, sizeof(line), "\nsub_%03X:\n", address);
+            out << line;
+        }
+        if (graph.findBlock(address) != nullptr) {
+            snprintf(line, sizeof(line), "L_%03X:\n", address);
+            out << line;
+        }
+
+        uint16_t ins{ fetch(rom, address) };
+        snprintf(line, sizeof(line), "  %03X  %04X  %s", address, ins, disassembleInstruction(ins, graph.isSchip).c_str());
+        out << line;
+        if (classify(ins, graph.isSchip) == Opcode::JUMP_OFFSET) {
+            out << "  ; target unknown";
+        }
+        out << "\n";
+        address += 2;
+    }
+}
+
+void writeDot(const ControlFlowGraph& graph, const uint8_t* rom, std::ostream& out) {
+    char line[96];
+    out << "digraph rom {\n";
+    out << "    node [shape=box, fontname=\"monospace\"];\n";
+
+    for (const BasicBlock& block : graph.blocks) {
+        snprintf(line, sizeof(line), "    b%03X [label=\"", block.start);
+        out << line;
+        for (uint16_t address{ block.start }; address < block.end; address += 2) {
+            snprintf(line, sizeof(line), "%03X: %s\\l", address,
+                     disassembleInstruction(fetch(rom, address), graph.isSchip).c_str());
+            out << line;
+        }
+        out << "\"];\n";
+    }
+
+    for (const BasicBlock& block : graph.blocks) {
+        for (uint16_t successor : block.successors) {
+            if (graph.findBlock(successor) != nullptr) {
+                snprintf(line, sizeof(line), "    b%03X -> b%03X;\n", block.start, successor);
+                out << line;
+            }
+        }
+
+        for (uint16_t address{ block.start }; address < block.end; address += 2) {
+            uint16_t ins{ fetch(rom, address) };
+            if (classify(ins, graph.isSchip) == Opcode::CALL && graph.findBlock(ins & 0xFFF) != nullptr) {
+                snprintf(line, sizeof(line), "    b%03X -> b%03X [style=dashed];\n", block.start, ins & 0xFFF);
+                out << line;
+            }
+        }
+    }
+    out << "}\n";
+}
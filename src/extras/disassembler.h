@@ -0,0 +1,48 @@
+#ifndef CHIP8_EMULATOR_DISASSEMBLER_H
+#define CHIP8_EMULATOR_DISASSEMBLER_H
+
+#include <bitset>
+#include <cstddef>
+#include <cstdint>
+#include <ostream>
+#include <string>
+#include <utility>
+#include <vector>
+#include "../constants.h"
+#include "../emulators/opcodes.h"
+
+// Static disassembly of a ROM loaded at 0x200, with the decode tables of the cores from opcodes.h
+// Analysis is a pure function of the ROM bytes, so any number of ROMs can be analysed on separate threads
+
+// Text of one instruction in the usual CHIP-8 assembler syntax, DW for anything the core would not decode
+std::string disassembleInstruction(uint16_t ins, bool isSchip);
+
+struct BasicBlock {
+    uint16_t start;
+    uint16_t end;                     // Address after the last instruction
+    std::vector<uint16_t> successors; // Jump, skip and fall through targets, not calls
+    bool isIndirect;                  // Ends in BNNN, the targets are only known at run time
+};
+
+struct ControlFlowGraph {
+    bool isSchip;
+    std::vector<BasicBlock> blocks;                   // By start address
+    std::vector<uint16_t> functions;                  // 0x200 and every call target, by address
+    std::vector<std::pair<uint16_t, uint16_t>> calls; // Calling function to called function, each pair once
+    std::bitset<RAM_SIZE> code;                       // First byte of every reachable instruction
+
+    // Block starting at address, nullptr if no block does
+    [[nodiscard]] const BasicBlock* findBlock(uint16_t address) const;
+};
+
+// Recursive descent from 0x200 following jumps, calls, returns and skips
+// Targets of BNNN and code written at run time are not found, everything else in the ROM is listed as data
+ControlFlowGraph analyseRom(const uint8_t* rom, size_t size, bool isSchip);
+
+// Every byte of the ROM, instructions with their block and function labels and the rest as data
+void writeListing(const ControlFlowGraph& graph, const uint8_t* rom, size_t size, std::ostream& out);
+
+// Graphviz digraph of the blocks with their instructions, calls drawn dashed between functions
+void writeDot(const ControlFlowGraph& graph, const uint8_t* rom, std::ostream& out);
+
+#endif
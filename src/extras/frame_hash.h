@@ -0,0 +1,38 @@
+#ifndef CHIP8_EMULATOR_FRAME_HASH_H
+#define CHIP8_EMULATOR_FRAME_HASH_H
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+// 64 bit hash of a one byte per pixel framebuffer, for comparing whole screens cheaply
+// Pixels are packed to one bit each first, so a 128x64 screen is only 128 words to mix
+inline uint64_t hashFramebuffer(const uint8_t* pixels, size_t size) {
+    constexpr uint64_t PRIME_1{0x9E3779B185EBCA87};
+    constexpr uint64_t PRIME_2{0xC2B2AE3D27D4EB4F};
+
+    uint64_t hash{ PRIME_1 ^ size };
+    size_t i{};
+    while (i < size) {
+        // Packs 64 pixels into one word, eight at a time. The multiply gathers the low bit of each byte into the top byte
+        uint64_t packed{};
+        for (int group{}; group < 8 && i < size; group++, i += 8) {
+            uint64_t bytes{};
+            memcpy(&bytes, pixels + i, size - i < 8 ? size - i : 8);
+            packed |= (((bytes & 0x0101010101010101) * 0x0102040810204080) >> 56) << (group * 8);
+        }
+
+        hash ^= packed * PRIME_2;
+        hash = ((hash << 31) | (hash >> 33)) * PRIME_1;
+    }
+
+    // Final avalanche so single pixel changes flip about half the bits
+    hash ^= hash >> 33;
+    hash *= PRIME_2;
+    hash ^= hash >> 29;
+    hash *= PRIME_1;
+    hash ^= hash >> 32;
+    return hash;
+}
+
+#endif
@@ -0,0 +1,531 @@
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <iterator>
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#include "gdb_stub.h"
+
+#ifdef MSG_NOSIGNAL
+constexpr int SEND_FLAGS{ MSG_NOSIGNAL };
+#else
+constexpr int SEND_FLAGS{ 0 };
+#endif
+
+constexpr int POLL_INTERVAL_MS{ 50 };
+constexpr int REGISTER_BYTES{ 23 };
+constexpr int REGISTER_SIZES[]{ 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 2, 2, 1, 1, 1 };
+constexpr uint8_t INTERRUPT{ 0x03 };
+
+
+// Helper
+static const char HEX_DIGITS[]{ "0123456789abcdef" };
+
+static void appendHex(std::string& out, uint8_t value) {
+    out += HEX_DIGITS[value >> 4];
+    out += HEX_DIGITS[value & 0xF];
+}
+
+static int hexDigit(char c) {
+    if (c >= '0' && c <= '9') {
+        return c - '0';
+    }
+    if (c >= 'a' && c <= 'f') {
+        return c - 'a' + 10;
+    }
+    if (c >= 'A' && c <= 'F') {
+        return c - 'A' + 10;
+    }
+    return -1;
+}
+
+// Pairs of hex digits into bytes, false on an odd length or anything that is not hex
+static bool decodeHex(const std::string& hex, std::vector<uint8_t>& bytes) {
+    if (hex.size() % 2 != 0) {
+        return false;
+    }
+
+    bytes.clear();
+    for (size_t i{}; i < hex.size(); i += 2) {
+        int high{ hexDigit(hex[i]) };
+        int low{ hexDigit(hex[i + 1]) };
+        if (high < 0 || low < 0) {
+            return false;
+        }
+        bytes.push_back((uint8_t) (high << 4 | low));
+    }
+    return true;
+}
+
+// Whole text has to be a hex number, addresses and lengths are cut to 16 bits by the caller
+static bool parseHexNumber(const std::string& text, unsigned long& value) {
+    if (text.empty()) {
+        return false;
+    }
+
+    char* end;
+    value = strtoul(text.c_str(), &end, 16);
+    return *end == '\0';
+}
+
+// "addr,length" as in the m, M and Z packets
+static bool parseRange(const std::string& text, uint16_t& address, uint16_t& length) {
+    size_t comma{ text.find(',') };
+    unsigned long parsedAddress;
+    unsigned long parsedLength;
+    if (comma == std::string::npos || !parseHexNumber(text.substr(0, comma), parsedAddress) ||
+        !parseHexNumber(text.substr(comma + 1), parsedLength)) {
+        return false;
+    }
+
+    address = (uint16_t) (parsedAddress % RAM_SIZE);
+    length = (uint16_t) std::min<unsigned long>(parsedLength, RAM_SIZE);
+    return true;
+}
+
+static void encodeRegisters(const DebugRegisters& debugRegisters, uint8_t* bytes) {
+    std::copy(debugRegisters.v, debugRegisters.v + 16, bytes);
+    bytes[16] = debugRegisters.i & 0xFF;
+    bytes[17] = debugRegisters.i >> 8;
+    bytes[18] = debugRegisters.pc & 0xFF;
+    bytes[19] = debugRegisters.pc >> 8;
+    bytes[20] = debugRegisters.sp;
+    bytes[21] = debugRegisters.delayTimer;
+    bytes[22] = debugRegisters.soundTimer;
+}
+
+static void decodeRegisters(const uint8_t* bytes, DebugRegisters& debugRegisters) {
+    std::copy(bytes, bytes + 16, debugRegisters.v);
+    debugRegisters.i = (uint16_t) (bytes[16] | bytes[17] << 8);
+    debugRegisters.pc = (uint16_t) (bytes[18] | bytes[19] << 8);
+    debugRegisters.sp = bytes[20];
+    debugRegisters.delayTimer = bytes[21];
+    debugRegisters.soundTimer = bytes[22];
+}
+
+// Offset of register number in the g packet layout
+static int registerOffset(int number) {
+    int offset{};
+    for (int i{}; i < number; i++) {
+        offset += REGISTER_SIZES[i];
+    }
+    return offset;
+}
+
+
+GdbStub::GdbStub(Emulator& emulator, Debugger& debugger)
+    : emulator{emulator}, debugger{debugger}, listenSocket{-1}, clientSocket{-1}, port{}, lastStopReply{"S05"} {}
+
+GdbStub::~GdbStub() {
+    closeClient();
+    if (listenSocket >= 0) {
+        close(listenSocket);
+    }
+}
+
+bool GdbStub::listen(uint16_t listenPort) {
+    listenSocket = socket(AF_INET, SOCK_STREAM, 0);
+    if (listenSocket < 0) {
+        printf("Error: Could not create the GDB socket\n");
+        return false;
+    }
+
+    int reuse{1};
+    setsockopt(listenSocket, SOL_SOCKET, SO_REUSEADDR, &reuse, sizeof(reuse));
+
+    // Local connections only, the protocol has no authentication
+    sockaddr_in address{};
+    address.sin_family = AF_INET;
+    address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    address.sin_port = htons(listenPort);
+    socklen_t addressSize{ sizeof(address) };
+    if (bind(listenSocket, reinterpret_cast<sockaddr*>(&address), addressSize) < 0 ||
+        ::listen(listenSocket, 1) < 0 ||
+        getsockname(listenSocket, reinterpret_cast<sockaddr*>(&address), &addressSize) < 0) {
+        printf("Error: Could not listen for GDB on port %d\n", listenPort);
+        close(listenSocket);
+        listenSocket = -1;
+        return false;
+    }
+
+    port = ntohs(address.sin_port);
+    return true;
+}
+
+void GdbStub::serve(RunControl& control) {
+    if (listenSocket < 0) {
+        return;
+    }
+
+    // Polled so a stop is still seen while nobody connects
+    while (clientSocket < 0) {
+        if (control.isStopping()) {
+            return;
+        }
+
+        pollfd listenPoll{ listenSocket, POLLIN, 0 };
+        if (poll(&listenPoll, 1, POLL_INTERVAL_MS) > 0) {
+            clientSocket = accept(listenSocket, nullptr, nullptr);
+        }
+    }
+
+    // GDB expects the target halted when it attaches
+    if (!debugger.isStopped()) {
+        debugger.requestStop();
+    }
+    while (!debugger.waitForStop(POLL_INTERVAL_MS)) {
+        if (control.isStopping()) {
+            closeClient();
+            return;
+        }
+    }
+    lastStopReply = "S05";
+
+    bool isDone{};
+    std::string packet;
+    while (!isDone && readPacket(packet, control)) {
+        std::string reply{ handlePacket(packet, control, isDone) };
+        if (packet[0] != 'k') {
+            sendPacket(reply);
+        }
+    }
+
+    // A client that went away leaves the core running without its breakpoints
+    detach();
+    closeClient();
+}
+
+
+// Connection
+// Next byte from the client, -1 if none arrived within timeoutMs, -2 once the connection is closed
+int GdbStub::receiveByte(int timeoutMs) {
+    if (received.empty()) {
+        pollfd clientPoll{ clientSocket, POLLIN, 0 };
+        if (poll(&clientPoll, 1, timeoutMs) <= 0) {
+            return -1;
+        }
+
+        char buffer[1024];
+        ssize_t size{ recv(clientSocket, buffer, sizeof(buffer), 0) };
+        if (size <= 0) {
+            return -2;
+        }
+        received.append(buffer, size);
+    }
+
+    uint8_t c{ (uint8_t) received[0] };
+    received.erase(0, 1);
+    return c;
+}
+
+// $data#checksum, acknowledged with + or - for a bad checksum. Acks from the client and stray bytes are skipped
+bool GdbStub::readPacket(std::string& packet, RunControl& control) {
+    while (!control.isStopping()) {
+        int c{ receiveByte(POLL_INTERVAL_MS) };
+        if (c == -2) {
+            return false;
+        }
+        if (c != '$') {
+            continue;
+        }
+
+        packet.clear();
+        uint8_t checksum{};
+        while ((c = receiveByte(POLL_INTERVAL_MS)) != '#') {
+            if (c == -2 || control.isStopping()) {
+                return false;
+            }
+            if (c >= 0) {
+                packet += (char) c;
+                checksum += (uint8_t) c;
+            }
+        }
+
+        int high{ -1 };
+        int low{ -1 };
+        while (high < 0 || low < 0) {
+            c = receiveByte(POLL_INTERVAL_MS);
+            if (c == -2 || control.isStopping()) {
+                return false;
+            }
+            if (c >= 0) {
+                (high < 0 ? high : low) = hexDigit((char) c);
+            }
+        }
+
+        bool isValid{ (high << 4 | low) == checksum && !packet.empty() };
+        send(clientSocket, isValid ? "+" : "-", 1, SEND_FLAGS);
+        if (isValid) {
+            return true;
+        }
+    }
+    return false;
+}
+
+bool GdbStub::sendPacket(const std::string& data) {
+    uint8_t checksum{};
+    for (char c : data) {
+        checksum += (uint8_t) c;
+    }
+
+    std::string packet{ "$" + data + "#" };
+    appendHex(packet, checksum);
+    return send(clientSocket, packet.data(), packet.size(), SEND_FLAGS) == (ssize_t) packet.size();
+}
+
+void GdbStub::closeClient() {
+    if (clientSocket >= 0) {
+        close(clientSocket);
+        clientSocket = -1;
+    }
+    received.clear();
+}
+
+
+// Packets
+// Unsupported packets get the empty reply, as the protocol asks
+std::string GdbStub::handlePacket(const std::string& packet, RunControl& control, bool& isDone) {
+    std::string arguments{ packet.substr(1) };
+    switch (packet[0]) {
+        case '?':
+            return lastStopReply;
+        case 'g':
+            return readRegisters();
+        case 'G':
+            return writeRegisters(arguments) ? "OK" : "E01";
+        case 'p':
+            return readRegister(arguments);
+        case 'P':
+            return writeRegister(arguments) ? "OK" : "E01";
+        case 'm':
+            return readMemory(arguments);
+        case 'M':
+            return writeMemory(arguments) ? "OK" : "E01";
+        case 'Z':
+        case 'z':
+            return setPoint(arguments, packet[0] == 'Z') ? "OK" : "E01";
+        case 'H':
+            return "OK";
+        case 'c':
+        case 's': {
+            // Optional address to carry on from
+            unsigned long address;
+            if (!arguments.empty()) {
+                if (!parseHexNumber(arguments, address)) {
+                    return "E01";
+                }
+                DebugRegisters debugRegisters{ emulator.getDebugRegisters() };
+                debugRegisters.pc = (uint16_t) address;
+                emulator.setDebugRegisters(debugRegisters);
+            }
+
+            if (packet[0] == 's') {
+                debugger.step();
+            } else {
+                debugger.resume();
+            }
+            return runUntilStop(control, isDone);
+        }
+        case 'D':
+            isDone = true;
+            return "OK";
+        case 'k':
+            isDone = true;
+            control.stop();
+            return "";
+        case 'q':
+            if (packet.rfind("qSupported", 0) == 0) {
+                return "PacketSize=1000";
+            }
+            if (packet == "qAttached") {
+                return "1";
+            }
+            return "";
+        default:
+            return "";
+    }
+}
+
+// Waits for the core to stop while passing on interrupts from the client
+std::string GdbStub::runUntilStop(RunControl& control, bool& isDone) {
+    while (!debugger.waitForStop(POLL_INTERVAL_MS)) {
+        if (control.isStopping()) {
+            isDone = true;
+            return "W00";
+        }
+
+        int c{ receiveByte(0) };
+        if (c == INTERRUPT) {
+            debugger.requestStop();
+        } else if (c == -2) {
+            isDone = true;
+            return "";
+        }
+    }
+
+    lastStopReply = stopReply(debugger.getStopInfo());
+    return lastStopReply;
+}
+
+std::string GdbStub::stopReply(const StopInfo& stopInfo) const {
+    if (stopInfo.reason == StopReason::REQUESTED) {
+        return "S02";
+    }
+    if (stopInfo.reason != StopReason::WATCHPOINT) {
+        return "S05";
+    }
+
+    auto watch{ std::find_if(watches.begin(), watches.end(), [&](const Watch& w) { return w.id == stopInfo.id; }) };
+    const char* kind{ "awatch" };
+    if (watch != watches.end() && watch->type == '2') {
+        kind = "watch";
+    } else if (watch != watches.end() && watch->type == '3') {
+        kind = "rwatch";
+    }
+
+    char reply[32];
+    snprintf(reply, sizeof(reply), "T05%s:%x;", kind, stopInfo.address);
+    return reply;
+}
+
+std::string GdbStub::readRegisters() const {
+    uint8_t bytes[REGISTER_BYTES];
+    encodeRegisters(emulator.getDebugRegisters(), bytes);
+
+    std::string hex;
+    for (uint8_t byte : bytes) {
+        appendHex(hex, byte);
+    }
+    return hex;
+}
+
+bool GdbStub::writeRegisters(const std::string& hex) {
+    std::vector<uint8_t> bytes;
+    if (!decodeHex(hex, bytes) || bytes.size() != REGISTER_BYTES) {
+        return false;
+    }
+
+    DebugRegisters debugRegisters{};
+    decodeRegisters(bytes.data(), debugRegisters);
+    emulator.setDebugRegisters(debugRegisters);
+    return true;
+}
+
+std::string GdbStub::readRegister(const std::string& arguments) const {
+    unsigned long number;
+    if (!parseHexNumber(arguments, number) || number >= std::size(REGISTER_SIZES)) {
+        return "E01";
+    }
+
+    uint8_t bytes[REGISTER_BYTES];
+    encodeRegisters(emulator.getDebugRegisters(), bytes);
+
+    std::string hex;
+    int offset{ registerOffset((int) number) };
+    for (int i{}; i < REGISTER_SIZES[number]; i++) {
+        appendHex(hex, bytes[offset + i]);
+    }
+    return hex;
+}
+
+bool GdbStub::writeRegister(const std::string& arguments) {
+    size_t equals{ arguments.find('=') };
+    unsigned long number;
+    std::vector<uint8_t> value;
+    if (equals == std::string::npos || !parseHexNumber(arguments.substr(0, equals), number) ||
+        number >= std::size(REGISTER_SIZES) || !decodeHex(arguments.substr(equals + 1), value) ||
+        value.size() != (size_t) REGISTER_SIZES[number]) {
+        return false;
+    }
+
+    uint8_t bytes[REGISTER_BYTES];
+    DebugRegisters debugRegisters{ emulator.getDebugRegisters() };
+    encodeRegisters(debugRegisters, bytes);
+    std::copy(value.begin(), value.end(), bytes + registerOffset((int) number));
+    decodeRegisters(bytes, debugRegisters);
+    emulator.setDebugRegisters(debugRegisters);
+    return true;
+}
+
+std::string GdbStub::readMemory(const std::string& arguments) const {
+    uint16_t address;
+    uint16_t length;
+    if (!parseRange(arguments, address, length)) {
+        return "E01";
+    }
+
+    std::string hex;
+    for (int i{}; i < length; i++) {
+        appendHex(hex, emulator.readMemory((uint16_t) (address + i)));
+    }
+    return hex;
+}
+
+bool GdbStub::writeMemory(const std::string& arguments) {
+    size_t colon{ arguments.find(':') };
+    uint16_t address;
+    uint16_t length;
+    std::vector<uint8_t> bytes;
+    if (colon == std::string::npos || !parseRange(arguments.substr(0, colon), address, length) ||
+        !decodeHex(arguments.substr(colon + 1), bytes) || bytes.size() != length) {
+        return false;
+    }
+
+    for (int i{}; i < length; i++) {
+        emulator.writeMemory((uint16_t) (address + i), bytes[i]);
+    }
+    return true;
+}
+
+// Z0/Z1 breakpoints, Z2 write, Z3 read and Z4 access watchpoints. The kind of a breakpoint is ignored
+bool GdbStub::setPoint(const std::string& arguments, bool isInsert) {
+    if (arguments.size() < 2 || arguments[1] != ',') {
+        return false;
+    }
+
+    char type{ arguments[0] };
+    uint16_t address;
+    uint16_t length;
+    if (!parseRange(arguments.substr(2), address, length)) {
+        return false;
+    }
+
+    if (type == '0' || type == '1') {
+        if (isInsert) {
+            debugger.addBreakpoint(address);
+        } else {
+            debugger.removeBreakpoint(address);
+        }
+        return true;
+    }
+    if (type < '2' || type > '4') {
+        return false;
+    }
+
+    auto watch{ std::find_if(watches.begin(), watches.end(), [&](const Watch& w) {
+        return w.type == type && w.address == address && w.length == length;
+    }) };
+    if (!isInsert) {
+        if (watch == watches.end()) {
+            return false;
+        }
+        debugger.removeWatchpoint(watch->id);
+        watches.erase(watch);
+        return true;
+    }
+
+    WatchKind kind{ type == '2' ? WatchKind::WRITE : type == '3' ? WatchKind::READ : WatchKind::ACCESS };
+    watches.push_back(Watch{ type, address, length, debugger.addWatchpoint(address, length, kind) });
+    return true;
+}
+
+void GdbStub::detach() {
+    debugger.clear();
+    watches.clear();
+    if (debugger.isStopped()) {
+        debugger.resume();
+    }
+}
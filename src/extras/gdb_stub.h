@@ -0,0 +1,72 @@
+#ifndef CHIP8_EMULATOR_GDB_STUB_H
+#define CHIP8_EMULATOR_GDB_STUB_H
+
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "debugger.h"
+#include "run_control.h"
+#include "../emulators/emulator.h"
+
+// GDB remote serial protocol server for one core, listening on 127.0.0.1
+// The core keeps running its own loop on its own thread. Breakpoints and watchpoints are set in the core's Debugger,
+// so continuing runs whole frames between stops instead of GDB stepping through every instruction
+//
+// Registers, in the order of the g packet: V0-VF (1 byte each), I and PC (2 bytes, little endian), SP, DT and ST
+class GdbStub {
+private:
+    struct Watch {
+        char type; // '2' write, '3' read, '4' access, as in the Z packet
+        uint16_t address;
+        uint16_t length;
+        int id;
+    };
+
+    Emulator& emulator;
+    Debugger& debugger;
+    int listenSocket;
+    int clientSocket;
+    uint16_t port;
+    std::string received;
+    std::vector<Watch> watches;
+    std::string lastStopReply;
+
+    // Connection
+    int receiveByte(int timeoutMs);
+    bool readPacket(std::string& packet, RunControl& control);
+    bool sendPacket(const std::string& data);
+    void closeClient();
+
+    // Packets
+    std::string handlePacket(const std::string& packet, RunControl& control, bool& isDone);
+    std::string runUntilStop(RunControl& control, bool& isDone);
+    std::string stopReply(const StopInfo& stopInfo) const;
+    std::string readRegisters() const;
+    bool writeRegisters(const std::string& hex);
+    std::string readRegister(const std::string& arguments) const;
+    bool writeRegister(const std::string& arguments);
+    std::string readMemory(const std::string& arguments) const;
+    bool writeMemory(const std::string& arguments);
+    bool setPoint(const std::string& arguments, bool isInsert);
+    void detach();
+
+public:
+    GdbStub(Emulator& emulator, Debugger& debugger);
+    ~GdbStub();
+
+    GdbStub(const GdbStub&) = delete;
+    GdbStub& operator=(const GdbStub&) = delete;
+
+    // 0 picks a free port, see getPort
+    bool listen(uint16_t listenPort);
+
+    [[nodiscard]] uint16_t getPort() const {
+        return port;
+    }
+
+    // Waits for a client, halts the core and answers it until it detaches or disconnects
+    // A kill packet stops control, and the session ends when something else stops it
+    void serve(RunControl& control);
+};
+
+#endif
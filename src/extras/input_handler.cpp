@@ -1,63 +1,69 @@
-#include <cstdio>
+#include <chrono>
 #include "input_handler.h"
 
-InputHandler::InputHandler(): keys(16) {}
+InputHandler::InputHandler(): keys(16), overflow{} {}
 
-int InputHandler::mapKeyCode(SDL_Keycode& code) {
-    switch (code) {
-        case SDLK_1:
-            return 1;
-        case SDLK_2:
-            return 2;
-        case SDLK_3:
-            return 3;
-        case SDLK_4:
-            return 0xC;
-        case SDLK_q:
-            return 4;
-        case SDLK_w:
-            return 5;
-        case SDLK_e:
-            return 6;
-        case SDLK_r:
-            return 0xD;
-        case SDLK_a:
-            return 7;
-        case SDLK_s:
-            return 8;
-        case SDLK_d:
-            return 9;
-        case SDLK_f:
-            return 0xE;
-        case SDLK_z:
-            return 0xA;
-        case SDLK_x:
-            return 0;
-        case SDLK_c:
-            return 0xB;
-        case SDLK_v:
-            return 0xF;
-        default:
-            return -1;
-    }
+uint64_t InputHandler::now() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now().time_since_epoch()).count();
 }
 
-void InputHandler::handleInput(SDL_Event& e) {
-    int key{ mapKeyCode(e.key.keysym.sym) };
-    if (key == -1) {
-        printf("Invalid Key Pressed\n");
+
+// Event thread
+void InputHandler::pushEvent(const InputEvent& event) {
+    // If the emulator thread has stalled long enough to fill the queue, events lose their timing but not their state
+    // Once anything has overflowed, later events go the same way so they are never applied before it
+    uint32_t state{ overflow.load(std::memory_order_acquire) };
+    if (state == 0 && events.push(event)) {
         return;
     }
 
-    if (e.type == SDL_KEYDOWN) {
-        keys[key] = true;
-    } else {
-        keys[key] = false;
+    uint32_t key{ (uint32_t) (event.key & 0xF) };
+    uint32_t next;
+    do {
+        next = (state | 1u << key) & ~(1u << (key + 16));
+        if (event.isPressed) {
+            next |= 1u << (key + 16);
+        }
+    } while (!overflow.compare_exchange_weak(state, next, std::memory_order_acq_rel, std::memory_order_acquire));
+}
+
+
+// Emulator thread
+void InputHandler::applyQueuedEvents(uint64_t time) {
+    const InputEvent* event;
+    while ((event = events.front()) != nullptr && event->timestamp <= time) {
+        keys[event->key] = event->isPressed;
+        events.pop();
+    }
+
+    if (event == nullptr && overflow.load(std::memory_order_relaxed) != 0) {
+        uint32_t state{ overflow.exchange(0, std::memory_order_acq_rel) };
+        for (int i{}; i < 16; i++) {
+            if ((state >> i) & 1) {
+                keys[i] = (state >> (i + 16)) & 1;
+            }
+        }
+    }
+}
+
+void InputHandler::setKeyState(uint16_t mask) {
+    for (int i{}; i < 16; i++) {
+        keys[i] = (mask >> i) & 1;
     }
 }
 
+uint16_t InputHandler::getKeyState() const {
+    uint16_t mask{};
+    for (int i{}; i < 16; i++) {
+        mask |= keys[i] << i;
+    }
+    return mask;
+}
+
+// EX9E and EXA1 pass VX as it is, only its low nibble names a key
 bool InputHandler::isKeyPressed(uint8_t key) {
-    return keys[key];
+    return keys[key & 0xF];
 }
 
 int InputHandler::getKeyBeingPressed() {
@@ -67,4 +73,4 @@ int InputHandler::getKeyBeingPressed() {
         }
     }
     return -1;
-}
\ No newline at end of file
+}
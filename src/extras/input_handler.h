@@ -1,20 +1,59 @@
 #ifndef CHIP8_EMULATOR_INPUT_HANDLER_H
 #define CHIP8_EMULATOR_INPUT_HANDLER_H
 
+#include <atomic>
+#include <cstdint>
 #include <vector>
-#include "SDL_events.h"
+#include "spsc_queue.h"
+
+// Key event as seen by the emulator thread
+// Timestamp is in nanoseconds of std::chrono::steady_clock
+struct InputEvent {
+    uint64_t timestamp;
+    uint8_t key;
+    bool isPressed;
+};
 
 class InputHandler {
 protected:
     std::vector<bool> keys;
-    static int mapKeyCode(SDL_Keycode& code);
+
+    // Written by the frontend's event thread, drained by the emulator thread
+    SPSCQueue<InputEvent, 256> events;
+
+    // Latest state of the keys whose events did not fit in the queue, newer than everything queued
+    // Bit N is set if key N changed, bit N + 16 if it is now pressed. Applied once the queue is empty
+    std::atomic<uint32_t> overflow;
 
 public:
     InputHandler();
 
-    // Check input is a valid KeyboardEvent first before using
-    // Cannot cast union to one of its member type
-    void handleInput(SDL_Event& e);
+    static uint64_t now();
+
+    // Event thread, keyboards and other frontends map their keys to CHIP-8 keys and push them here
+    void pushEvent(const InputEvent& event);
+
+    // Emulator thread
+    // Applies every queued event that happened at or before the given time
+    void applyEvents(uint64_t time) {
+        if (events.empty() && overflow.load(std::memory_order_relaxed) == 0) {
+            return;
+        }
+        applyQueuedEvents(time);
+    }
+    void applyQueuedEvents(uint64_t time);
+
+    // Time of the oldest event not applied yet, UINT64_MAX if there is none and 0 for overflowed ones
+    [[nodiscard]] uint64_t getNextEventTime() const {
+        const InputEvent* event{ events.front() };
+        if (event != nullptr) {
+            return event->timestamp;
+        }
+        return overflow.load(std::memory_order_relaxed) != 0 ? 0 : UINT64_MAX;
+    }
+
+    void setKeyState(uint16_t mask); // Bit N is key N, for headless drivers that own the keypad
+    [[nodiscard]] uint16_t getKeyState() const;
     bool isKeyPressed(uint8_t key);
     int getKeyBeingPressed();
 };
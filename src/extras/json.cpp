@@ -0,0 +1,276 @@
+#include <cstdlib>
+#include "json.h"
+
+// Recursive descent over the whole text, nesting is limited so malformed input cannot overflow the stack
+class JsonParser {
+private:
+    static constexpr int MAX_DEPTH{64};
+
+    const std::string& text;
+    size_t position;
+    std::string& error;
+
+    bool fail(const char* message) {
+        error = std::string(message) + " at offset " + std::to_string(position);
+        return false;
+    }
+
+    void skipWhitespace() {
+        while (position < text.size()
+               && (text[position] == ' ' || text[position] == '\t' || text[position] == '\n' || text[position] == '\r')) {
+            position++;
+        }
+    }
+
+    bool consume(char c) {
+        skipWhitespace();
+        if (position < text.size() && text[position] == c) {
+            position++;
+            return true;
+        }
+        return false;
+    }
+
+    bool parseLiteral(const char* literal, JsonValue& value, JsonValue::Type type, bool boolean) {
+        std::string expected{ literal };
+        if (text.compare(position, expected.size(), expected) != 0) {
+            return fail("Unexpected token");
+        }
+        position += expected.size();
+        value.type = type;
+        value.boolean = boolean;
+        return true;
+    }
+
+    bool parseHex4(uint32_t& codePoint) {
+        if (position + 4 > text.size()) {
+            return fail("Truncated unicode escape");
+        }
+
+        codePoint = 0;
+        for (int i{}; i < 4; i++) {
+            char c{ text[position++] };
+            codePoint <<= 4;
+            if (c >= '0' && c <= '9') {
+                codePoint |= c - '0';
+            } else if (c >= 'a' && c <= 'f') {
+                codePoint |= c - 'a' + 10;
+            } else if (c >= 'A' && c <= 'F') {
+                codePoint |= c - 'A' + 10;
+            } else {
+                return fail("Invalid unicode escape");
+            }
+        }
+        return true;
+    }
+
+    static void appendUtf8(std::string& out, uint32_t codePoint) {
+        if (codePoint < 0x80) {
+            out += (char) codePoint;
+        } else if (codePoint < 0x800) {
+            out += (char) (0xC0 | codePoint >> 6);
+            out += (char) (0x80 | (codePoint & 0x3F));
+        } else if (codePoint < 0x10000) {
+            out += (char) (0xE0 | codePoint >> 12);
+            out += (char) (0x80 | (codePoint >> 6 & 0x3F));
+            out += (char) (0x80 | (codePoint & 0x3F));
+        } else {
+            out += (char) (0xF0 | codePoint >> 18);
+            out += (char) (0x80 | (codePoint >> 12 & 0x3F));
+            out += (char) (0x80 | (codePoint >> 6 & 0x3F));
+            out += (char) (0x80 | (codePoint & 0x3F));
+        }
+    }
+
+    bool parseString(std::string& out) {
+        if (!consume('"')) {
+            return fail("Expected string");
+        }
+
+        while (position < text.size()) {
+            char c{ text[position++] };
+            if (c == '"') {
+                return true;
+            }
+            if (c != '\\') {
+                out += c;
+                continue;
+            }
+
+            if (position >= text.size()) {
+                break;
+            }
+            switch (text[position++]) {
+                case '"':
+                    out += '"';
+                    break;
+                case '\\':
+                    out += '\\';
+                    break;
+                case '/':
+                    out += '/';
+                    break;
+                case 'b':
+                    out += '\b';
+                    break;
+                case 'f':
+                    out += '\f';
+                    break;
+                case 'n':
+                    out += '\n';
+                    break;
+                case 'r':
+                    out += '\r';
+                    break;
+                case 't':
+                    out += '\t';
+                    break;
+                case 'u': {
+                    uint32_t codePoint{};
+                    if (!parseHex4(codePoint)) {
+                        return false;
+                    }
+
+                    // Characters outside the BMP come as a surrogate pair, a lone half has no character to encode
+                    if (codePoint >= 0xDC00 && codePoint < 0xE000) {
+                        return fail("Unpaired surrogate");
+                    }
+                    if (codePoint >= 0xD800 && codePoint < 0xDC00) {
+                        if (text.compare(position, 2, "\\u") != 0) {
+                            return fail("Unpaired surrogate");
+                        }
+                        position += 2;
+                        uint32_t low{};
+                        if (!parseHex4(low)) {
+                            return false;
+                        }
+                        if (low < 0xDC00 || low >= 0xE000) {
+                            return fail("Unpaired surrogate");
+                        }
+                        codePoint = 0x10000 + ((codePoint - 0xD800) << 10) + (low - 0xDC00);
+                    }
+                    appendUtf8(out, codePoint);
+                    break;
+                }
+                default:
+                    return fail("Invalid escape");
+            }
+        }
+        return fail("Unterminated string");
+    }
+
+    bool parseNumber(JsonValue& value) {
+        const char* start{ text.c_str() + position };
+        char* end;
+        value.number = strtod(start, &end);
+        if (end == start) {
+            return fail("Unexpected token");
+        }
+
+        position += end - start;
+        value.type = JsonValue::Type::NUMBER;
+        return true;
+    }
+
+    bool parseArray(JsonValue& value, int depth) {
+        position++;
+        value.type = JsonValue::Type::ARRAY;
+        if (consume(']')) {
+            return true;
+        }
+
+        do {
+            value.items.emplace_back();
+            if (!parseValue(value.items.back(), depth + 1)) {
+                return false;
+            }
+        } while (consume(','));
+
+        return consume(']') || fail("Expected ']'");
+    }
+
+    bool parseObject(JsonValue& value, int depth) {
+        position++;
+        value.type = JsonValue::Type::OBJECT;
+        if (consume('}')) {
+            return true;
+        }
+
+        do {
+            value.keys.emplace_back();
+            if (!parseString(value.keys.back())) {
+                return false;
+            }
+            if (!consume(':')) {
+                return fail("Expected ':'");
+            }
+
+            value.items.emplace_back();
+            if (!parseValue(value.items.back(), depth + 1)) {
+                return false;
+            }
+        } while (consume(','));
+
+        return consume('}') || fail("Expected '}'");
+    }
+
+public:
+    JsonParser(const std::string& text, std::string& error): text{text}, position{}, error{error} {}
+
+    bool parseValue(JsonValue& value, int depth) {
+        if (depth > MAX_DEPTH) {
+            return fail("Nesting too deep");
+        }
+
+        skipWhitespace();
+        if (position >= text.size()) {
+            return fail("Unexpected end of input");
+        }
+
+        switch (text[position]) {
+            case '{':
+                return parseObject(value, depth);
+            case '[':
+                return parseArray(value, depth);
+            case '"':
+                value.type = JsonValue::Type::STRING;
+                return parseString(value.string);
+            case 't':
+                return parseLiteral("true", value, JsonValue::Type::BOOLEAN, true);
+            case 'f':
+                return parseLiteral("false", value, JsonValue::Type::BOOLEAN, false);
+            case 'n':
+                return parseLiteral("null", value, JsonValue::Type::NUL, false);
+            default:
+                return parseNumber(value);
+        }
+    }
+
+    bool parseDocument(JsonValue& value) {
+        if (!parseValue(value, 0)) {
+            return false;
+        }
+
+        skipWhitespace();
+        return position == text.size() || fail("Trailing characters");
+    }
+};
+
+bool JsonValue::parse(const std::string& text, JsonValue& value, std::string& error) {
+    value = JsonValue{};
+    JsonParser parser{ text, error };
+    return parser.parseDocument(value);
+}
+
+const JsonValue* JsonValue::find(const std::string& key) const {
+    if (type != Type::OBJECT) {
+        return nullptr;
+    }
+
+    for (size_t i{}; i < keys.size(); i++) {
+        if (keys[i] == key) {
+            return &items[i];
+        }
+    }
+    return nullptr;
+}
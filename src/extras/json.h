@@ -0,0 +1,77 @@
+#ifndef CHIP8_EMULATOR_JSON_H
+#define CHIP8_EMULATOR_JSON_H
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Small read only JSON document, enough for the chip-8-database files
+// Objects keep their members in file order; lookups are linear, which is fine for the handful of keys per object
+class JsonValue {
+public:
+    enum class Type : uint8_t {
+        NUL,
+        BOOLEAN,
+        NUMBER,
+        STRING,
+        ARRAY,
+        OBJECT
+    };
+
+private:
+    Type type;
+    bool boolean;
+    double number;
+    std::string string;
+    std::vector<JsonValue> items;   // Array elements, or object member values
+    std::vector<std::string> keys;  // Object member names, parallel to items
+
+    friend class JsonParser;
+
+public:
+    JsonValue(): type{Type::NUL}, boolean{}, number{} {}
+
+    // Parses a whole document. On failure error says what went wrong and where
+    static bool parse(const std::string& text, JsonValue& value, std::string& error);
+
+    [[nodiscard]] Type getType() const {
+        return type;
+    }
+
+    [[nodiscard]] bool isObject() const {
+        return type == Type::OBJECT;
+    }
+
+    [[nodiscard]] bool isArray() const {
+        return type == Type::ARRAY;
+    }
+
+    // The getters return fallback if the value has another type
+    [[nodiscard]] bool asBool(bool fallback = false) const {
+        return type == Type::BOOLEAN ? boolean : fallback;
+    }
+
+    [[nodiscard]] double asNumber(double fallback = 0) const {
+        return type == Type::NUMBER ? number : fallback;
+    }
+
+    [[nodiscard]] const std::string& asString() const {
+        static const std::string empty{};
+        return type == Type::STRING ? string : empty;
+    }
+
+    // Array elements or object values
+    [[nodiscard]] const std::vector<JsonValue>& getItems() const {
+        return items;
+    }
+
+    // Object member names, in the same order as getItems
+    [[nodiscard]] const std::vector<std::string>& getKeys() const {
+        return keys;
+    }
+
+    // Member of an object, nullptr if missing or not an object
+    [[nodiscard]] const JsonValue* find(const std::string& key) const;
+};
+
+#endif
@@ -0,0 +1,85 @@
+#ifndef CHIP8_EMULATOR_PAGED_MEMORY_H
+#define CHIP8_EMULATOR_PAGED_MEMORY_H
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include "../constants.h"
+
+// RAM split into fixed size pages that are shared between copies until one side writes
+// Copying a PagedMemory only copies the page pointers, so forking an emulator stays cheap
+class PagedMemory {
+public:
+    static constexpr int PAGE_SIZE{256};
+    static constexpr int PAGE_COUNT{RAM_SIZE / PAGE_SIZE};
+    static_assert(RAM_SIZE % PAGE_SIZE == 0, "RAM_SIZE must be a multiple of PAGE_SIZE");
+    static_assert((PAGE_COUNT & (PAGE_COUNT - 1)) == 0, "PAGE_COUNT must be a power of two");
+
+private:
+    struct Page {
+        uint8_t bytes[PAGE_SIZE];
+    };
+
+    std::array<std::shared_ptr<Page>, PAGE_COUNT> pages;
+
+    // Page that is safe to write to, splitting it off first if another copy still shares it
+    uint8_t* writablePage(int page) {
+        if (pages[page].use_count() != 1) {
+            pages[page] = std::make_shared<Page>(*pages[page]);
+        } else {
+            // Pairs with the release of the last other owner so its reads happen before our writes
+            std::atomic_thread_fence(std::memory_order_acquire);
+        }
+        return pages[page]->bytes;
+    }
+
+public:
+    // Every page starts out as the same zeroed page
+    PagedMemory() {
+        auto zeroPage{ std::make_shared<Page>() };
+        pages.fill(zeroPage);
+    }
+
+    // Addresses wrap around the end of RAM like the 12 bit address bus
+    uint8_t operator[](uint16_t address) const {
+        return pages[(address / PAGE_SIZE) & (PAGE_COUNT - 1)]->bytes[address % PAGE_SIZE];
+    }
+
+    void write(uint16_t address, uint8_t value) {
+        writablePage((address / PAGE_SIZE) & (PAGE_COUNT - 1))[address % PAGE_SIZE] = value;
+    }
+
+    void write(uint16_t address, const uint8_t* data, size_t size) {
+        while (size > 0) {
+            size_t offset{ (size_t) address % PAGE_SIZE };
+            size_t chunk{ std::min(size, PAGE_SIZE - offset) };
+            memcpy(writablePage((address / PAGE_SIZE) & (PAGE_COUNT - 1)) + offset, data, chunk);
+
+            address += chunk;
+            data += chunk;
+            size -= chunk;
+        }
+    }
+
+    // Flat copy of all RAM_SIZE bytes
+    void copyTo(uint8_t* out) const {
+        for (int i{}; i < PAGE_COUNT; i++) {
+            memcpy(out + i * PAGE_SIZE, pages[i]->bytes, PAGE_SIZE);
+        }
+    }
+
+    // Number of pages not yet split off, shared with another copy or still the initial zero page
+    [[nodiscard]] int getSharedPageCount() const {
+        int count{};
+        for (auto& page : pages) {
+            count += page.use_count() > 1;
+        }
+        return count;
+    }
+};
+
+#endif
@@ -0,0 +1,153 @@
+#include <algorithm>
+#include <cstdio>
+#include <fstream>
+#include <ostream>
+#include <utility>
+#include "profiler.h"
+
+ExecutionProfiler::ExecutionProfiler(std::string outputPrefix)
+    : pcCounts(RAM_SIZE), opcodeCounts{}, opcodePairCounts(OPCODE_COUNT * OPCODE_COUNT), previousOpcode{OPCODE_COUNT},
+    displayCounts{}, displayNanoseconds{},
+    pendingDisplayOperation{DISPLAY_OPERATION_COUNT}, stackNodes{{-1, 0x200, 0}}, currentNode{0},
+    outputPrefix{std::move(outputPrefix)} {}
+
+ExecutionProfiler::DisplayOperation ExecutionProfiler::displayOperationOf(Opcode op) {
+    switch (op) {
+        case Opcode::DRAW:
+        case Opcode::DRAW_BIG:
+            return SPRITE;
+        case Opcode::SCROLL_DOWN:
+        case Opcode::SCROLL_LEFT:
+        case Opcode::SCROLL_RIGHT:
+            return SCROLL;
+        case Opcode::CLEAR:
+            return CLEAR;
+        default:
+            return DISPLAY_OPERATION_COUNT;
+    }
+}
+
+void ExecutionProfiler::enterSubroutine(uint16_t address) {
+    uint64_t key{ (uint64_t) currentNode << 16 | address };
+    auto it{ stackChildren.find(key) };
+    if (it != stackChildren.end()) {
+        currentNode = it->second;
+        return;
+    }
+
+    stackNodes.push_back(StackNode{ currentNode, address, 0 });
+    int node{ (int) stackNodes.size() - 1 };
+    stackChildren.emplace(key, node);
+    currentNode = node;
+}
+
+std::string ExecutionProfiler::stackName(int node) const {
+    std::vector<uint16_t> frames;
+    for (int i{node}; i != -1; i = stackNodes[i].parent) {
+        frames.push_back(stackNodes[i].address);
+    }
+
+    std::string s;
+    char buffer[8];
+    for (auto it{ frames.rbegin() }; it != frames.rend(); it++) {
+        snprintf(buffer, sizeof(buffer), "0x%03X", *it);
+        if (!s.empty()) {
+            s.append(";");
+        }
+        s.append(buffer);
+    }
+    return s;
+}
+
+
+// Output
+void ExecutionProfiler::writeHotSpotReport(std::ostream& out, int limit) const {
+    uint64_t total{};
+    for (uint64_t count : pcCounts) {
+        total += count;
+    }
+
+    char line[96];
+    snprintf(line, sizeof(line), "Instructions executed: %llu\n\n", (unsigned long long) total);
+    out << line;
+
+    // Program counters
+    std::vector<uint16_t> pcs;
+    for (int i{}; i < RAM_SIZE; i++) {
+        if (pcCounts[i] > 0) {
+            pcs.push_back(i);
+        }
+    }
+    std::sort(pcs.begin(), pcs.end(), [this](uint16_t a, uint16_t b) { return pcCounts[a] > pcCounts[b]; });
+
+    out << "Hot program counters\n";
+    for (int i{}; i < (int) pcs.size() && i < limit; i++) {
+        snprintf(line, sizeof(line), "  0x%03X  %12llu  %6.2f%%\n", pcs[i],
+                 (unsigned long long) pcCounts[pcs[i]], total ? 100.0 * pcCounts[pcs[i]] / total : 0.0);
+        out << line;
+    }
+
+    // Opcode classes
+    std::vector<int> ops;
+    for (int i{}; i < OPCODE_COUNT; i++) {
+        if (opcodeCounts[i] > 0) {
+            ops.push_back(i);
+        }
+    }
+    std::sort(ops.begin(), ops.end(), [this](int a, int b) { return opcodeCounts[a] > opcodeCounts[b]; });
+
+    out << "\nOpcode classes\n";
+    for (int op : ops) {
+        snprintf(line, sizeof(line), "  %s  %12llu  %6.2f%%\n", OPCODE_PATTERNS[op],
+                 (unsigned long long) opcodeCounts[op], total ? 100.0 * opcodeCounts[op] / total : 0.0);
+        out << line;
+    }
+
+    // Opcode pairs
+    std::vector<int> pairs;
+    for (int i{}; i < OPCODE_COUNT * OPCODE_COUNT; i++) {
+        if (opcodePairCounts[i] > 0) {
+            pairs.push_back(i);
+        }
+    }
+    std::sort(pairs.begin(), pairs.end(), [this](int a, int b) { return opcodePairCounts[a] > opcodePairCounts[b]; });
+
+    out << "\nOpcode pairs\n";
+    for (int i{}; i < (int) pairs.size() && i < limit; i++) {
+        snprintf(line, sizeof(line), "  %s %s  %12llu  %6.2f%%\n", OPCODE_PATTERNS[pairs[i] / OPCODE_COUNT],
+                 OPCODE_PATTERNS[pairs[i] % OPCODE_COUNT], (unsigned long long) opcodePairCounts[pairs[i]],
+                 total ? 100.0 * opcodePairCounts[pairs[i]] / total : 0.0);
+        out << line;
+    }
+
+    // Display operations
+    const char* names[DISPLAY_OPERATION_COUNT]{ "Sprite", "Scroll", "Clear" };
+    out << "\nDisplay operations\n";
+    for (int i{}; i < DISPLAY_OPERATION_COUNT; i++) {
+        double average{ displayCounts[i] ? (double) displayNanoseconds[i] / displayCounts[i] : 0.0 };
+        snprintf(line, sizeof(line), "  %-6s  %12llu calls  %10.3f ms total  %8.0f ns avg\n", names[i],
+                 (unsigned long long) displayCounts[i], displayNanoseconds[i] / 1e6, average);
+        out << line;
+    }
+}
+
+void ExecutionProfiler::writeFoldedStacks(std::ostream& out) const {
+    for (int i{}; i < (int) stackNodes.size(); i++) {
+        if (stackNodes[i].count > 0) {
+            out << stackName(i) << " " << stackNodes[i].count << "\n";
+        }
+    }
+}
+
+bool ExecutionProfiler::writeReports() const {
+    std::ofstream report{ outputPrefix + ".txt" };
+    std::ofstream folded{ outputPrefix + ".folded" };
+    if (!report.is_open() || !folded.is_open()) {
+        printf("Error: Could not write profile to %s\n", outputPrefix.c_str());
+        return false;
+    }
+
+    writeHotSpotReport(report);
+    writeFoldedStacks(folded);
+    return true;
+}
@@ -0,0 +1,139 @@
+#ifndef CHIP8_EMULATOR_PROFILER_H
+#define CHIP8_EMULATOR_PROFILER_H
+
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "../constants.h"
+#include "../emulators/opcodes.h"
+
+// Profiling policies for the run loop of Chip8 and SChip
+// The loop is instantiated once per policy, so NullProfiler leaves no trace in the release loop
+
+struct NullProfiler {
+    void beginInstruction(uint16_t pc, uint16_t ins) {}
+    void endInstruction() {}
+};
+
+class ExecutionProfiler {
+public:
+    enum DisplayOperation { SPRITE, SCROLL, CLEAR, DISPLAY_OPERATION_COUNT };
+
+private:
+    // Hot spots
+    std::vector<uint64_t> pcCounts;
+    std::array<uint64_t, OPCODE_COUNT> opcodeCounts;
+    std::vector<uint64_t> opcodePairCounts; // previous * OPCODE_COUNT + next, candidates for fused handlers
+    int previousOpcode;                     // OPCODE_COUNT before the first instruction
+
+    // Display operation timings
+    std::array<uint64_t, DISPLAY_OPERATION_COUNT> displayCounts;
+    std::array<uint64_t, DISPLAY_OPERATION_COUNT> displayNanoseconds;
+    int pendingDisplayOperation;
+    std::chrono::steady_clock::time_point displayStart;
+
+    // Shadow call stack for the folded stack output
+    // Each node is one subroutine entry point under its caller, node 0 is the ROM entry
+    struct StackNode {
+        int parent;
+        uint16_t address;
+        uint64_t count;
+    };
+    std::vector<StackNode> stackNodes;
+    std::unordered_map<uint64_t, int> stackChildren; // (parent << 16 | address) -> node
+    int currentNode;
+
+    std::string outputPrefix;
+
+    static DisplayOperation displayOperationOf(Opcode op);
+    std::string stackName(int node) const;
+
+public:
+    // Reports are written to <outputPrefix>.txt and <outputPrefix>.folded
+    explicit ExecutionProfiler(std::string outputPrefix);
+
+    void beginInstruction(uint16_t pc, uint16_t ins) {
+        pcCounts[pc % RAM_SIZE]++;
+        stackNodes[currentNode].count++;
+
+        Opcode op{ classifyOpcode(ins) };
+        opcodeCounts[static_cast<int>(op)]++;
+        if (previousOpcode != OPCODE_COUNT) {
+            opcodePairCounts[previousOpcode * OPCODE_COUNT + static_cast<int>(op)]++;
+        }
+        previousOpcode = static_cast<int>(op);
+
+        if (op == Opcode::CALL) {
+            enterSubroutine(ins % 0x1000);
+        } else if (op == Opcode::RETURN && currentNode != 0) {
+            currentNode = stackNodes[currentNode].parent;
+        }
+
+        pendingDisplayOperation = displayOperationOf(op);
+        if (pendingDisplayOperation != DISPLAY_OPERATION_COUNT) {
+            displayStart = std::chrono::steady_clock::now();
+        }
+    }
+
+    void endInstruction() {
+        if (pendingDisplayOperation == DISPLAY_OPERATION_COUNT) {
+            return;
+        }
+
+        auto elapsed{ std::chrono::steady_clock::now() - displayStart };
+        displayCounts[pendingDisplayOperation]++;
+        displayNanoseconds[pendingDisplayOperation] += std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count();
+    }
+
+    void enterSubroutine(uint16_t address);
+
+    // Output
+    void writeHotSpotReport(std::ostream& out, int limit = 32) const;
+    void writeFoldedStacks(std::ostream& out) const;
+    bool writeReports() const;
+
+    // Getter
+    [[nodiscard]] uint64_t getPCCount(uint16_t pc) const {
+        return pcCounts[pc % RAM_SIZE];
+    }
+
+    [[nodiscard]] uint64_t getOpcodeCount(Opcode op) const {
+        return opcodeCounts[static_cast<int>(op)];
+    }
+
+    // Times second ran straight after first
+    [[nodiscard]] uint64_t getOpcodePairCount(Opcode first, Opcode second) const {
+        return opcodePairCounts[static_cast<int>(first) * OPCODE_COUNT + static_cast<int>(second)];
+    }
+
+    [[nodiscard]] uint64_t getDisplayCount(DisplayOperation op) const {
+        return displayCounts[op];
+    }
+};
+
+// Forwards to an ExecutionProfiler that may be null
+// Diagnostic runs share one instantiation through this instead of one per profiler and tracer combination
+class OptionalProfiler {
+private:
+    ExecutionProfiler* profiler;
+
+public:
+    explicit OptionalProfiler(ExecutionProfiler* profiler): profiler{profiler} {}
+
+    void beginInstruction(uint16_t pc, uint16_t ins) {
+        if (profiler != nullptr) {
+            profiler->beginInstruction(pc, ins);
+        }
+    }
+
+    void endInstruction() {
+        if (profiler != nullptr) {
+            profiler->endInstruction();
+        }
+    }
+};
+
+#endif
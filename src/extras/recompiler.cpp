@@ -0,0 +1,229 @@
+#include <bitset>
+#include <cstdio>
+#include "disassembler.h"
+#include "recompiler.h"
+
+constexpr uint16_t ROM_START{0x200};
+constexpr int ROM_BYTES_PER_LINE{16};
+
+
+// Helper
+// Goto when the target was compiled, otherwise the interpreter carries on from it
+static std::string jumpTo(const std::bitset<RAM_SIZE>& labels, uint32_t target) {
+    char text[48];
+    if (target < RAM_SIZE && labels.test(target)) {
+        snprintf(text, sizeof(text), "goto a%03X;", target);
+    } else {
+        snprintf(text, sizeof(text), "{ c.setPC(0x%03X); return; }", target % 0x10000);
+    }
+    return text;
+}
+
+// Quirks, the display, the random generator, FX0A and stores that may hit compiled code
+static bool isInterpreted(Opcode op) {
+    switch (op) {
+        case Opcode::RETURN:
+        case Opcode::JUMP:
+        case Opcode::CALL:
+        case Opcode::SKIP_EQ_IMM:
+        case Opcode::SKIP_NE_IMM:
+        case Opcode::SKIP_EQ_REG:
+        case Opcode::SKIP_NE_REG:
+        case Opcode::SKIP_KEY:
+        case Opcode::SKIP_NOT_KEY:
+        case Opcode::SET_IMM:
+        case Opcode::ADD_IMM:
+        case Opcode::SET_REG:
+        case Opcode::ADD_REG:
+        case Opcode::SUB:
+        case Opcode::SUB_REVERSE:
+        case Opcode::SET_INDEX:
+        case Opcode::GET_DELAY:
+        case Opcode::SET_DELAY:
+        case Opcode::SET_SOUND:
+        case Opcode::ADD_INDEX:
+        case Opcode::FONT:
+            return false;
+        default:
+            return true;
+    }
+}
+
+// Statements of one instruction after its begin, mirroring Chip8::decode
+static std::string translate(uint16_t ins, uint16_t address, const std::bitset<RAM_SIZE>& labels) {
+    int x{ (ins >> 8) & 0xF };
+    int y{ (ins >> 4) & 0xF };
+    int nn{ ins & 0xFF };
+    int nnn{ ins & 0xFFF };
+
+    char text[160];
+    auto skip{ [&](const char* condition) {
+        snprintf(text, sizeof(text), "    if (%s) %s\n    %s\n", condition, jumpTo(labels, address + 4).c_str(),
+                 jumpTo(labels, address + 2).c_str());
+        return std::string{ text };
+    } };
+    char condition[48];
+
+    switch (classifyChip8Opcode(ins)) {
+        case Opcode::RETURN:
+            return "    c.returnFromSubroutine();\n    goto dispatch;\n";
+        case Opcode::JUMP:
+            if (nnn <= address) {
+                snprintf(text, sizeof(text), "    c.setPC(0x%03X);\n    c.skipIdleLoop(0x%03X, 0x%04X);\n", nnn, address, ins);
+                return text + jumpTo(labels, nnn) + "\n";
+            }
+            return "    " + jumpTo(labels, nnn) + "\n";
+        case Opcode::CALL:
+            return "    c.call();\n    " + jumpTo(labels, nnn) + "\n";
+        case Opcode::SKIP_EQ_IMM:
+            snprintf(condition, sizeof(condition), "v[0x%X] == 0x%02X", x, nn);
+            return skip(condition);
+        case Opcode::SKIP_NE_IMM:
+            snprintf(condition, sizeof(condition), "v[0x%X] != 0x%02X", x, nn);
+            return skip(condition);
+        case Opcode::SKIP_EQ_REG:
+            snprintf(condition, sizeof(condition), "v[0x%X] == v[0x%X]", x, y);
+            return skip(condition);
+        case Opcode::SKIP_NE_REG:
+            snprintf(condition, sizeof(condition), "v[0x%X] != v[0x%X]", x, y);
+            return skip(condition);
+        case Opcode::SKIP_KEY:
+            snprintf(condition, sizeof(condition), "c.isKeyPressed(v[0x%X])", x);
+            return skip(condition);
+        case Opcode::SKIP_NOT_KEY:
+            snprintf(condition, sizeof(condition), "!c.isKeyPressed(v[0x%X])", x);
+            return skip(condition);
+        case Opcode::SET_IMM:
+            snprintf(text, sizeof(text), "    v[0x%X] = 0x%02X;\n", x, nn);
+            return text;
+        case Opcode::ADD_IMM:
+            snprintf(text, sizeof(text), "    v[0x%X] += 0x%02X;\n", x, nn);
+            return text;
+        case Opcode::SET_REG:
+            snprintf(text, sizeof(text), "    v[0x%X] = v[0x%X];\n", x, y);
+            return text;
+        case Opcode::ADD_REG:
+            snprintf(text, sizeof(text), "    {\n        uint8_t flag = v[0x%X] + v[0x%X] > 255;\n        v[0x%X] += v[0x%X];\n        v[0xF] = flag;\n    }\n",
+                     x, y, x, y);
+            return text;
+        case Opcode::SUB:
+            snprintf(text, sizeof(text), "    {\n        uint8_t flag = v[0x%X] >= v[0x%X];\n        v[0x%X] -= v[0x%X];\n        v[0xF] = flag;\n    }\n",
+                     x, y, x, y);
+            return text;
+        case Opcode::SUB_REVERSE:
+            snprintf(text, sizeof(text), "    {\n        uint8_t flag = v[0x%X] >= v[0x%X];\n        v[0x%X] = v[0x%X] - v[0x%X];\n        v[0xF] = flag;\n    }\n",
+                     y, x, x, y, x);
+            return text;
+        case Opcode::SET_INDEX:
+            snprintf(text, sizeof(text), "    i = 0x%03X;\n", nnn);
+            return text;
+        case Opcode::GET_DELAY:
+            snprintf(text, sizeof(text), "    v[0x%X] = c.getDelayTimer();\n", x);
+            return text;
+        case Opcode::SET_DELAY:
+            snprintf(text, sizeof(text), "    c.getDelayTimer() = v[0x%X];\n", x);
+            return text;
+        case Opcode::SET_SOUND:
+            snprintf(text, sizeof(text), "    c.getSoundTimer() = v[0x%X];\n", x);
+            return text;
+        case Opcode::ADD_INDEX:
+            snprintf(text, sizeof(text), "    i += v[0x%X];\n    if (i >= 4096) {\n        v[0xF] = 1;\n        i -= 4096;\n    }\n", x);
+            return text;
+        case Opcode::FONT:
+            snprintf(text, sizeof(text), "    i = (v[0x%X] %% 0x10) * 5 + 0x50;\n", x);
+            return text;
+        default:
+            snprintf(text, sizeof(text), "    if (!c.interpret(0x%04X)) goto dispatch;\n", ins);
+            return text;
+    }
+}
+
+void writeRecompiledRom(const uint8_t* rom, size_t size, const std::string& romName, const std::string& symbol,
+                        const std::string& header, std::ostream& out) {
+    ControlFlowGraph graph{ analyseRom(rom, size, false) };
+
+    // Places control arrives at by a goto or the dispatch switch: block starts, return addresses, and interpreted
+    // instructions and the ones after them, where FX0A repeats and frames that end on a DXYN carry on
+    std::bitset<RAM_SIZE> labels;
+    for (const BasicBlock& block : graph.blocks) {
+        labels.set(block.start);
+        for (uint16_t address{ block.start }; address < block.end; address += 2) {
+            uint16_t ins{ (uint16_t) (rom[address - ROM_START] << 8 | rom[address - ROM_START + 1]) };
+            Opcode op{ classifyChip8Opcode(ins) };
+            if ((op == Opcode::CALL || isInterpreted(op)) && address + 2 < block.end) {
+                labels.set(address + 2);
+            }
+            if (isInterpreted(op)) {
+                labels.set(address);
+            }
+        }
+    }
+
+    char line[160];
+    out << "// Generated by rom_recompiler from " << romName << ", do not edit\n";
+    out << "#include \"" << header << "\"\n\n";
+    out << "namespace {\n\n";
+
+    out << "const uint8_t ROM[]{\n";
+    for (size_t i{}; i < size; i++) {
+        snprintf(line, sizeof(line), "%s0x%02X,%s", i % ROM_BYTES_PER_LINE == 0 ? "        " : " ", rom[i],
+                 i % ROM_BYTES_PER_LINE == ROM_BYTES_PER_LINE - 1 || i + 1 == size ? "\n" : "");
+        out << line;
+    }
+    out << "};\n\n";
+
+    out << "const uint16_t BLOCKS[]{\n";
+    for (const BasicBlock& block : graph.blocks) {
+        snprintf(line, sizeof(line), "        0x%03X, 0x%03X,\n", block.start, block.end);
+        out << line;
+    }
+    if (graph.blocks.empty()) {
+        out << "        0x200, 0x200,\n";
+    }
+    out << "};\n\n";
+
+    std::string body;
+    for (const BasicBlock& block : graph.blocks) {
+        Opcode last{};
+        for (uint16_t address{ block.start }; address < block.end; address += 2) {
+            uint16_t ins{ (uint16_t) (rom[address - ROM_START] << 8 | rom[address - ROM_START + 1]) };
+            if (labels.test(address)) {
+                snprintf(line, sizeof(line), "\na%03X:\n", address);
+                body += line;
+            }
+            snprintf(line, sizeof(line), "    if (!c.begin(0x%03X)) return; // %s\n", address,
+                     disassembleInstruction(ins, false).c_str());
+            body += line;
+            body += translate(ins, address, labels);
+            last = classifyChip8Opcode(ins);
+        }
+
+        // Jumps, returns and skips leave the block themselves, anything else falls through to the next address
+        if (last != Opcode::JUMP && last != Opcode::RETURN && block.successors.size() < 2) {
+            body += "    " + jumpTo(labels, block.end) + "\n";
+        }
+    }
+
+    out << "void run(RecompiledChip8& c) {\n";
+    out << "    [[maybe_unused]] uint8_t* v{ c.getRegisterFile() };\n";
+    out << "    [[maybe_unused]] uint16_t& i{ c.getIndexRegister() };\n\n";
+    if (body.find("goto dispatch;") != std::string::npos) {
+        out << "dispatch:\n";
+    }
+    out << "    switch (c.getPC()) {\n";
+    for (int address{}; address < RAM_SIZE; address++) {
+        if (labels.test(address)) {
+            snprintf(line, sizeof(line), "        case 0x%03X: goto a%03X;\n", address, address);
+            out << line;
+        }
+    }
+    out << "        default: return;\n";
+    out << "    }\n";
+    out << body;
+    out << "}\n\n";
+    out << "}\n\n";
+
+    snprintf(line, sizeof(line), "%zu", graph.blocks.size());
+    out << "extern const RecompiledRom " << symbol << ";\n";
+    out << "const RecompiledRom " << symbol << "{ \"" << romName << "\", ROM, sizeof(ROM), BLOCKS, " << line << ", run };\n";
+}
@@ -0,0 +1,16 @@
+#ifndef CHIP8_EMULATOR_RECOMPILER_H
+#define CHIP8_EMULATOR_RECOMPILER_H
+
+#include <cstddef>
+#include <cstdint>
+#include <ostream>
+#include <string>
+
+// Writes a C++ translation unit that defines the RecompiledRom symbol for a CHIP-8 ROM loaded at 0x200
+// Every block analyseRom finds becomes a label in one function, jumps and calls between blocks become gotos
+// and everything that depends on quirks, the display or the random generator is handed to the interpreter
+// one instruction at a time. header is the path the unit includes recompiled_chip8.h by
+void writeRecompiledRom(const uint8_t* rom, size_t size, const std::string& romName, const std::string& symbol,
+                        const std::string& header, std::ostream& out);
+
+#endif
@@ -0,0 +1,314 @@
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include "rom_database.h"
+
+// Helper
+static bool readFile(const std::string& path, std::string& contents) {
+    std::ifstream input{ path, std::ios::binary };
+    if (!input.is_open()) {
+        return false;
+    }
+
+    contents.assign(std::istreambuf_iterator<char>(input), std::istreambuf_iterator<char>());
+    return true;
+}
+
+// "#RRGGBB" to 0xFFRRGGBB
+static bool parseColor(const std::string& text, uint32_t& color) {
+    if (text.size() != 7 || text[0] != '#') {
+        return false;
+    }
+
+    char* end;
+    unsigned long rgb{ strtoul(text.c_str() + 1, &end, 16) };
+    if (end != text.c_str() + text.size()) {
+        return false;
+    }
+
+    color = 0xFF000000 | (uint32_t) rgb;
+    return true;
+}
+
+// Platform ids of the chip-8-database, with the quirks its platforms.json gives them
+static bool findPlatform(const std::string& id, Platform& platform, Quirks& quirks) {
+    if (id == "originalChip8" || id == "hybridVIP" || id == "chip8x") {
+        platform = Platform::CHIP8;
+        quirks = COSMAC_VIP_QUIRKS;
+    } else if (id == "modernChip8") {
+        platform = Platform::CHIP8;
+        quirks = { true, true, false, false, true, false };
+    } else if (id == "chip48") {
+        platform = Platform::CHIP8;
+        quirks = { false, true, true, false, true, false };
+    } else if (id == "superchip1" || id == "superchip") {
+        platform = Platform::SCHIP;
+        quirks = SCHIP_QUIRKS;
+    } else if (id == "xochip") {
+        platform = Platform::XO_CHIP;
+        quirks = XO_CHIP_QUIRKS;
+    } else {
+        return false;
+    }
+    return true;
+}
+
+// Only the keys that are present override the current value
+static void applyQuirks(const JsonValue& json, Quirks& quirks) {
+    if (const JsonValue* value{ json.find("shift") }) {
+        quirks.shiftUsesVY = !value->asBool();
+    }
+    if (const JsonValue* value{ json.find("memoryLeaveIUnchanged") }) {
+        quirks.loadStoreIncrementsI = !value->asBool();
+    }
+    // CHIP-48 increments I by X instead of X + 1, the closest supported behaviour is to increment
+    if (const JsonValue* value{ json.find("memoryIncrementByX") }; value != nullptr && value->asBool()) {
+        quirks.loadStoreIncrementsI = true;
+    }
+    if (const JsonValue* value{ json.find("wrap") }) {
+        quirks.clipSprites = !value->asBool();
+    }
+    if (const JsonValue* value{ json.find("jump") }) {
+        quirks.jumpUsesVX = value->asBool();
+    }
+    if (const JsonValue* value{ json.find("vblank") }) {
+        quirks.vblankWait = value->asBool();
+    }
+    if (const JsonValue* value{ json.find("logic") }) {
+        quirks.logicResetsVF = value->asBool();
+    }
+}
+
+static const JsonValue* findPlatformEntry(const JsonValue* platforms, const std::string& id) {
+    if (platforms == nullptr) {
+        return nullptr;
+    }
+
+    for (auto& entry : platforms->getItems()) {
+        const JsonValue* entryId{ entry.find("id") };
+        if (entryId != nullptr && entryId->asString() == id) {
+            return &entry;
+        }
+    }
+    return nullptr;
+}
+
+
+// Defaults
+RomInfo getDefaultRomInfo(Platform platform) {
+    switch (platform) {
+        case Platform::SCHIP:
+            return { "", platform, SCHIP_QUIRKS, 30, 0xFFFFFFFF, 0xFF000000 };
+        case Platform::XO_CHIP:
+            return { "", platform, XO_CHIP_QUIRKS, 100, 0xFFFFFFFF, 0xFF000000 };
+        default:
+            return { "", Platform::CHIP8, COSMAC_VIP_QUIRKS, INSTRUCTIONS_PER_FRAME, 0xFFFFFFFF, 0xFF000000 };
+    }
+}
+
+
+// Building from JSON
+bool RomDatabase::addProgram(const JsonValue& program, const JsonValue* platforms, std::string& error) {
+    const JsonValue* title{ program.find("title") };
+    const JsonValue* roms{ program.find("roms") };
+    if (roms == nullptr || !roms->isObject()) {
+        error = "Program without roms object";
+        return false;
+    }
+
+    for (size_t i{}; i < roms->getKeys().size(); i++) {
+        const std::string& hash{ roms->getKeys()[i] };
+        const JsonValue& rom{ roms->getItems()[i] };
+
+        IndexRecord record{};
+        if (!parseSha1(hash, record.digest)) {
+            error = "Invalid SHA-1 " + hash;
+            return false;
+        }
+
+        // The first listed platform this emulator has a core for wins, ROMs for other platforms are left out
+        const JsonValue* romPlatforms{ rom.find("platforms") };
+        if (romPlatforms == nullptr) {
+            continue;
+        }
+
+        std::string platformId;
+        Platform platform{};
+        Quirks quirks{};
+        for (auto& id : romPlatforms->getItems()) {
+            if (findPlatform(id.asString(), platform, quirks)) {
+                platformId = id.asString();
+                break;
+            }
+        }
+        if (platformId.empty()) {
+            continue;
+        }
+
+        RomInfo info{ getDefaultRomInfo(platform) };
+        const JsonValue* platformEntry{ findPlatformEntry(platforms, platformId) };
+        if (platformEntry != nullptr) {
+            if (const JsonValue* platformQuirks{ platformEntry->find("quirks") }) {
+                applyQuirks(*platformQuirks, quirks);
+            }
+            if (const JsonValue* tickrate{ platformEntry->find("defaultTickrate") }) {
+                info.instructionsPerFrame = (int) tickrate->asNumber(info.instructionsPerFrame);
+            }
+        }
+
+        if (const JsonValue* quirkyPlatforms{ rom.find("quirkyPlatforms") }) {
+            if (const JsonValue* romQuirks{ quirkyPlatforms->find(platformId) }) {
+                applyQuirks(*romQuirks, quirks);
+            }
+        }
+
+        if (const JsonValue* tickrate{ rom.find("tickrate") }) {
+            info.instructionsPerFrame = (int) tickrate->asNumber(info.instructionsPerFrame);
+        }
+
+        // pixels lists the background colour first, then the foreground
+        if (const JsonValue* colors{ rom.find("colors") }) {
+            if (const JsonValue* pixels{ colors->find("pixels") }; pixels != nullptr && pixels->getItems().size() >= 2) {
+                parseColor(pixels->getItems()[0].asString(), info.backgroundColor);
+                parseColor(pixels->getItems()[1].asString(), info.foregroundColor);
+            }
+        }
+
+        std::string name{ title != nullptr ? title->asString() : "" };
+        record.platform = (uint8_t) platform;
+        record.quirkFlags = quirks.getFlags();
+        record.instructionsPerFrame = (uint16_t) std::clamp(info.instructionsPerFrame, 1, 0xFFFF);
+        record.foregroundColor = info.foregroundColor;
+        record.backgroundColor = info.backgroundColor;
+        record.titleOffset = (uint32_t) titles.size();
+        record.titleLength = (uint32_t) name.size();
+        titles += name;
+        records.push_back(record);
+    }
+    return true;
+}
+
+bool RomDatabase::loadJson(const std::string& directory) {
+    records.clear();
+    titles.clear();
+
+    std::string text;
+    std::string error;
+    JsonValue programs;
+    if (!readFile(directory + "/programs.json", text)) {
+        printf("Error: %s/programs.json not found\n", directory.c_str());
+        return false;
+    }
+    if (!JsonValue::parse(text, programs, error) || !programs.isArray()) {
+        printf("Error: programs.json is not a list of programs. %s\n", error.c_str());
+        return false;
+    }
+
+    // platforms.json is optional, the built in platform quirks are used without it
+    JsonValue platforms;
+    bool hasPlatforms{ readFile(directory + "/platforms.json", text) };
+    if (hasPlatforms && (!JsonValue::parse(text, platforms, error) || !platforms.isArray())) {
+        printf("Error: platforms.json is not a list of platforms. %s\n", error.c_str());
+        return false;
+    }
+
+    for (auto& program : programs.getItems()) {
+        if (!addProgram(program, hasPlatforms ? &platforms : nullptr, error)) {
+            printf("Error: %s\n", error.c_str());
+            return false;
+        }
+    }
+
+    // Sorted for binary search, if a ROM is listed twice the first entry wins
+    std::stable_sort(records.begin(), records.end(), [](const IndexRecord& a, const IndexRecord& b) {
+        return a.digest < b.digest;
+    });
+    records.erase(std::unique(records.begin(), records.end(), [](const IndexRecord& a, const IndexRecord& b) {
+        return a.digest == b.digest;
+    }), records.end());
+    return true;
+}
+
+
+// Prebuilt index
+bool RomDatabase::writeIndex(const std::string& path) const {
+    std::ofstream output{ path, std::ios::binary | std::ios::trunc };
+    if (!output.is_open()) {
+        printf("Error: Could not open %s\n", path.c_str());
+        return false;
+    }
+
+    uint32_t recordCount{ (uint32_t) records.size() };
+    uint32_t titlesSize{ (uint32_t) titles.size() };
+    output.write(INDEX_MAGIC, sizeof(INDEX_MAGIC));
+    output.write(reinterpret_cast<const char*>(&recordCount), sizeof(recordCount));
+    output.write(reinterpret_cast<const char*>(&titlesSize), sizeof(titlesSize));
+    output.write(reinterpret_cast<const char*>(records.data()), (std::streamsize) (records.size() * sizeof(IndexRecord)));
+    output.write(titles.data(), (std::streamsize) titles.size());
+    return (bool) output;
+}
+
+bool RomDatabase::loadIndex(const std::string& path) {
+    records.clear();
+    titles.clear();
+
+    std::string contents;
+    if (!readFile(path, contents)) {
+        return false;
+    }
+
+    uint32_t recordCount;
+    uint32_t titlesSize;
+    size_t headerSize{ sizeof(INDEX_MAGIC) + sizeof(recordCount) + sizeof(titlesSize) };
+    if (contents.size() < headerSize || memcmp(contents.data(), INDEX_MAGIC, sizeof(INDEX_MAGIC)) != 0) {
+        printf("Error: %s is not a ROM database index\n", path.c_str());
+        return false;
+    }
+
+    memcpy(&recordCount, contents.data() + sizeof(INDEX_MAGIC), sizeof(recordCount));
+    memcpy(&titlesSize, contents.data() + sizeof(INDEX_MAGIC) + sizeof(recordCount), sizeof(titlesSize));
+    if (contents.size() != headerSize + (size_t) recordCount * sizeof(IndexRecord) + titlesSize) {
+        printf("Error: ROM database index %s is truncated\n", path.c_str());
+        return false;
+    }
+
+    records.resize(recordCount);
+    memcpy(records.data(), contents.data() + headerSize, (size_t) recordCount * sizeof(IndexRecord));
+    titles.assign(contents, headerSize + (size_t) recordCount * sizeof(IndexRecord), titlesSize);
+
+    for (auto& record : records) {
+        if ((size_t) record.titleOffset + record.titleLength > titles.size() || record.platform > (uint8_t) Platform::XO_CHIP) {
+            printf("Error: ROM database index %s is corrupted\n", path.c_str());
+            records.clear();
+            titles.clear();
+            return false;
+        }
+    }
+    return true;
+}
+
+
+// Lookup
+bool RomDatabase::find(const Sha1Digest& digest, RomInfo& info) const {
+    auto it{ std::lower_bound(records.begin(), records.end(), digest, [](const IndexRecord& record, const Sha1Digest& key) {
+        return record.digest < key;
+    }) };
+    if (it == records.end() || it->digest != digest) {
+        return false;
+    }
+
+    info.title = titles.substr(it->titleOffset, it->titleLength);
+    info.platform = (Platform) it->platform;
+    info.quirks = Quirks::fromFlags(it->quirkFlags);
+    info.instructionsPerFrame = it->instructionsPerFrame;
+    info.foregroundColor = it->foregroundColor;
+    info.backgroundColor = it->backgroundColor;
+    return true;
+}
+
+bool RomDatabase::find(const uint8_t* rom, size_t size, RomInfo& info) const {
+    return find(sha1(rom, size), info);
+}
@@ -0,0 +1,71 @@
+#ifndef CHIP8_EMULATOR_ROM_DATABASE_H
+#define CHIP8_EMULATOR_ROM_DATABASE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "../constants.h"
+#include "../emulators/quirks.h"
+#include "json.h"
+#include "sha1.h"
+
+enum class Platform : uint8_t {
+    CHIP8,
+    SCHIP,
+    XO_CHIP
+};
+
+// Everything needed to run a ROM the way it was meant to be run
+struct RomInfo {
+    std::string title;
+    Platform platform;
+    Quirks quirks;
+    int instructionsPerFrame;
+    uint32_t foregroundColor; // 0xAARRGGBB, like GRID_COLOR
+    uint32_t backgroundColor;
+};
+
+// Settings for ROMs the database does not know
+RomInfo getDefaultRomInfo(Platform platform);
+
+// ROM metadata keyed by SHA-1 of the ROM bytes
+// Built from the community chip-8-database JSON (programs.json, optionally platforms.json) by tools/rom_db_indexer,
+// then loaded at startup from a prebuilt index of fixed size records sorted by digest, so a lookup is one binary search
+class RomDatabase {
+private:
+    static constexpr char INDEX_MAGIC[8]{ 'C', '8', 'R', 'O', 'M', 'D', 'B', '1' };
+
+    struct IndexRecord {
+        Sha1Digest digest;
+        uint8_t platform;
+        uint8_t quirkFlags;
+        uint16_t instructionsPerFrame;
+        uint32_t foregroundColor;
+        uint32_t backgroundColor;
+        uint32_t titleOffset;
+        uint32_t titleLength;
+    };
+    static_assert(sizeof(IndexRecord) == 40, "Index records are read back as raw 40 byte blocks");
+
+    std::vector<IndexRecord> records;
+    std::string titles; // Every title back to back, records point into it
+
+    bool addProgram(const JsonValue& program, const JsonValue* platforms, std::string& error);
+
+public:
+    [[nodiscard]] size_t size() const {
+        return records.size();
+    }
+
+    // Reads programs.json and, if present, platforms.json from the database directory
+    bool loadJson(const std::string& directory);
+
+    bool loadIndex(const std::string& path);
+    bool writeIndex(const std::string& path) const;
+
+    bool find(const Sha1Digest& digest, RomInfo& info) const;
+    bool find(const uint8_t* rom, size_t size, RomInfo& info) const;
+};
+
+#endif
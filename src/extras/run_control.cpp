@@ -0,0 +1,98 @@
+#include <algorithm>
+#include <cmath>
+#include "run_control.h"
+#include "../constants.h"
+
+RunControl::RunControl()
+    : isStopRequested{}, isPauseRequested{}, speed{1.0}, instructionSteps{}, frameSteps{}
+{
+}
+
+void RunControl::stop() {
+    {
+        std::lock_guard<std::mutex> lock{mutex};
+        isStopRequested.store(true, std::memory_order_release);
+        instructionSteps = 0;
+        frameSteps = 0;
+        if (stopListener) {
+            stopListener();
+        }
+    }
+    changed.notify_all();
+}
+
+void RunControl::setStopListener(std::function<void()> listener) {
+    std::lock_guard<std::mutex> lock{mutex};
+    stopListener = std::move(listener);
+}
+
+void RunControl::pause() {
+    std::lock_guard<std::mutex> lock{mutex};
+    isPauseRequested.store(true, std::memory_order_release);
+}
+
+void RunControl::resume() {
+    {
+        std::lock_guard<std::mutex> lock{mutex};
+        isPauseRequested.store(false, std::memory_order_release);
+        instructionSteps = 0;
+        frameSteps = 0;
+    }
+    changed.notify_all();
+}
+
+void RunControl::stepInstruction(int count) {
+    {
+        std::lock_guard<std::mutex> lock{mutex};
+        if (!isPauseRequested.load(std::memory_order_relaxed) || count <= 0) {
+            return;
+        }
+        instructionSteps += count;
+    }
+    changed.notify_all();
+}
+
+void RunControl::stepFrame(int count) {
+    {
+        std::lock_guard<std::mutex> lock{mutex};
+        if (!isPauseRequested.load(std::memory_order_relaxed) || count <= 0) {
+            return;
+        }
+        frameSteps += count;
+    }
+    changed.notify_all();
+}
+
+void RunControl::setSpeed(double multiplier) {
+    speed.store(std::isnan(multiplier) ? 1.0 : std::max(multiplier, MIN_SPEED), std::memory_order_relaxed);
+}
+
+std::chrono::nanoseconds RunControl::getFramePeriod() const {
+    double multiplier{ getSpeed() };
+    if (multiplier == UNLIMITED_SPEED) {
+        return std::chrono::nanoseconds{0};
+    }
+    return std::chrono::nanoseconds{ (int64_t) (FRAME_DURATION_NS / multiplier) };
+}
+
+RunCommand RunControl::next() {
+    std::unique_lock<std::mutex> lock{mutex};
+    changed.wait(lock, [this]() {
+        return isStopRequested.load(std::memory_order_relaxed) || !isPauseRequested.load(std::memory_order_relaxed) ||
+               instructionSteps > 0 || frameSteps > 0;
+    });
+
+    // Instruction steps come first, a frame step then finishes the frame they are in
+    if (isStopRequested.load(std::memory_order_relaxed)) {
+        return RunCommand::STOP;
+    }
+    if (instructionSteps > 0) {
+        instructionSteps--;
+        return RunCommand::INSTRUCTION;
+    }
+    if (frameSteps > 0) {
+        frameSteps--;
+        return RunCommand::FRAME;
+    }
+    return RunCommand::RUN;
+}
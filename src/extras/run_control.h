@@ -0,0 +1,72 @@
+#ifndef CHIP8_EMULATOR_RUN_CONTROL_H
+#define CHIP8_EMULATOR_RUN_CONTROL_H
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <limits>
+#include <mutex>
+
+// What the paced loop does next
+enum class RunCommand : uint8_t {
+    RUN,         // A paced frame
+    INSTRUCTION, // One instruction while paused
+    FRAME,       // The rest of the current frame while paused
+    STOP
+};
+
+// Stop, pause, stepping and speed of a paced run, shared between the CPU thread and the threads controlling it
+// The CPU thread blocks in next while paused instead of polling
+class RunControl {
+private:
+    mutable std::mutex mutex;
+    std::condition_variable changed;
+    std::atomic<bool> isStopRequested;
+    std::atomic<bool> isPauseRequested;
+    std::atomic<double> speed;
+    int instructionSteps; // Requested while paused, taken by next
+    int frameSteps;
+    std::function<void()> stopListener;
+
+public:
+    static constexpr double MIN_SPEED{0.25};
+    static constexpr double UNLIMITED_SPEED{ std::numeric_limits<double>::infinity() };
+
+    RunControl();
+
+    // The loop returns at the next frame or instruction boundary, pending steps are dropped
+    void stop();
+    [[nodiscard]] bool isStopping() const {
+        return isStopRequested.load(std::memory_order_acquire);
+    }
+
+    // Called by stop while it holds the lock, so a CPU thread blocked outside next wakes up too. Null removes it
+    void setStopListener(std::function<void()> listener);
+
+    // Takes effect at the next frame boundary, resuming drops steps that have not run
+    void pause();
+    void resume();
+    [[nodiscard]] bool isPaused() const {
+        return isPauseRequested.load(std::memory_order_acquire);
+    }
+
+    // Only while paused, ignored otherwise
+    void stepInstruction(int count = 1);
+    void stepFrame(int count = 1);
+
+    // Multiple of 60 frames a second, clamped to MIN_SPEED. UNLIMITED_SPEED runs frames back to back
+    void setSpeed(double multiplier);
+    [[nodiscard]] double getSpeed() const {
+        return speed.load(std::memory_order_relaxed);
+    }
+
+    // Wall time one frame takes at the current speed, zero when unlimited
+    [[nodiscard]] std::chrono::nanoseconds getFramePeriod() const;
+
+    // CPU thread, blocks while paused until there is something to run or the run stops
+    RunCommand next();
+};
+
+#endif
@@ -0,0 +1,126 @@
+#ifndef CHIP8_EMULATOR_SAVE_STATE_H
+#define CHIP8_EMULATOR_SAVE_STATE_H
+
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <string>
+#include <type_traits>
+
+// Save states are the machine's fields back to back in host byte order, behind a magic and a core id
+// They are meant to be loaded by the same build on the same machine, not exchanged
+constexpr char SAVE_STATE_MAGIC[8]{ 'C', '8', 'S', 'T', 'A', 'T', 'E', '1' };
+
+// Core that wrote the state, states only load back into the same core
+constexpr uint8_t CHIP8_STATE_ID{0};
+constexpr uint8_t SCHIP_STATE_ID{1};
+
+class StateWriter {
+private:
+    std::string data;
+
+public:
+    explicit StateWriter(uint8_t coreId) {
+        data.append(SAVE_STATE_MAGIC, sizeof(SAVE_STATE_MAGIC));
+        data += (char) coreId;
+    }
+
+    template<typename T>
+    void write(const T& value) {
+        static_assert(std::is_trivially_copyable_v<T>, "Only plain values can be written directly");
+        data.append(reinterpret_cast<const char*>(&value), sizeof(T));
+    }
+
+    void write(const uint8_t* bytes, size_t size) {
+        data.append(reinterpret_cast<const char*>(bytes), size);
+    }
+
+    // Length prefixed
+    void writeString(const std::string& text) {
+        write((uint32_t) text.size());
+        data += text;
+    }
+
+    [[nodiscard]] bool saveTo(const std::string& path) const {
+        std::ofstream output{ path, std::ios::binary | std::ios::trunc };
+        if (!output.is_open()) {
+            printf("Error: Could not open %s\n", path.c_str());
+            return false;
+        }
+
+        output.write(data.data(), (std::streamsize) data.size());
+        return (bool) output;
+    }
+};
+
+// Reads fail softly: once anything is missing every later read fails too, so callers check once at the end
+class StateReader {
+private:
+    std::string data;
+    size_t position;
+    bool isValid;
+
+public:
+    StateReader(): position{}, isValid{} {}
+
+    // Checks the magic and that the state was saved by the core with coreId
+    bool loadFrom(const std::string& path, uint8_t coreId) {
+        std::ifstream input{ path, std::ios::binary };
+        if (!input.is_open()) {
+            printf("Error: Save state %s not found\n", path.c_str());
+            return false;
+        }
+
+        data.assign(std::istreambuf_iterator<char>(input), std::istreambuf_iterator<char>());
+        if (data.size() <= sizeof(SAVE_STATE_MAGIC) || memcmp(data.data(), SAVE_STATE_MAGIC, sizeof(SAVE_STATE_MAGIC)) != 0) {
+            printf("Error: %s is not a save state\n", path.c_str());
+            return false;
+        }
+        if ((uint8_t) data[sizeof(SAVE_STATE_MAGIC)] != coreId) {
+            printf("Error: %s was saved by another core\n", path.c_str());
+            return false;
+        }
+
+        position = sizeof(SAVE_STATE_MAGIC) + 1;
+        isValid = true;
+        return true;
+    }
+
+    template<typename T>
+    bool read(T& value) {
+        static_assert(std::is_trivially_copyable_v<T>, "Only plain values can be read directly");
+        return read(reinterpret_cast<uint8_t*>(&value), sizeof(T));
+    }
+
+    bool read(uint8_t* bytes, size_t size) {
+        if (!isValid || data.size() - position < size) {
+            isValid = false;
+            return false;
+        }
+
+        memcpy(bytes, data.data() + position, size);
+        position += size;
+        return true;
+    }
+
+    bool readString(std::string& text) {
+        uint32_t size{};
+        if (!read(size) || data.size() - position < size) {
+            isValid = false;
+            return false;
+        }
+
+        text.assign(data, position, size);
+        position += size;
+        return true;
+    }
+
+    // True if every read succeeded and nothing is left over
+    [[nodiscard]] bool isComplete() const {
+        return isValid && position == data.size();
+    }
+};
+
+#endif
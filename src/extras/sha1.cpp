@@ -0,0 +1,130 @@
+#include <cstring>
+#include "sha1.h"
+
+static uint32_t rotateLeft(uint32_t value, int bits) {
+    return (value << bits) | (value >> (32 - bits));
+}
+
+static void processBlock(uint32_t state[5], const uint8_t* block) {
+    uint32_t w[80];
+    for (int i{}; i < 16; i++) {
+        w[i] = (uint32_t) block[i * 4] << 24 | (uint32_t) block[i * 4 + 1] << 16
+            | (uint32_t) block[i * 4 + 2] << 8 | (uint32_t) block[i * 4 + 3];
+    }
+    for (int i{16}; i < 80; i++) {
+        w[i] = rotateLeft(w[i - 3] ^ w[i - 8] ^ w[i - 14] ^ w[i - 16], 1);
+    }
+
+    uint32_t a{ state[0] };
+    uint32_t b{ state[1] };
+    uint32_t c{ state[2] };
+    uint32_t d{ state[3] };
+    uint32_t e{ state[4] };
+    for (int i{}; i < 80; i++) {
+        uint32_t f;
+        uint32_t k;
+        if (i < 20) {
+            f = (b & c) | (~b & d);
+            k = 0x5A827999;
+        } else if (i < 40) {
+            f = b ^ c ^ d;
+            k = 0x6ED9EBA1;
+        } else if (i < 60) {
+            f = (b & c) | (b & d) | (c & d);
+            k = 0x8F1BBCDC;
+        } else {
+            f = b ^ c ^ d;
+            k = 0xCA62C1D6;
+        }
+
+        uint32_t temp{ rotateLeft(a, 5) + f + e + k + w[i] };
+        e = d;
+        d = c;
+        c = rotateLeft(b, 30);
+        b = a;
+        a = temp;
+    }
+
+    state[0] += a;
+    state[1] += b;
+    state[2] += c;
+    state[3] += d;
+    state[4] += e;
+}
+
+Sha1Digest sha1(const uint8_t* data, size_t size) {
+    uint32_t state[5]{ 0x67452301, 0xEFCDAB89, 0x98BADCFE, 0x10325476, 0xC3D2E1F0 };
+
+    size_t offset{};
+    for (; offset + 64 <= size; offset += 64) {
+        processBlock(state, data + offset);
+    }
+
+    // Padding: a single 1 bit, zeros, then the message length in bits as a big endian 64 bit number
+    uint8_t tail[128]{};
+    size_t remaining{ size - offset };
+    if (remaining > 0) {
+        memcpy(tail, data + offset, remaining);
+    }
+    tail[remaining] = 0x80;
+
+    size_t tailSize{ remaining < 56 ? (size_t) 64 : (size_t) 128 };
+    uint64_t bitCount{ (uint64_t) size * 8 };
+    for (int i{}; i < 8; i++) {
+        tail[tailSize - 1 - i] = (uint8_t) (bitCount >> (i * 8));
+    }
+
+    for (size_t i{}; i < tailSize; i += 64) {
+        processBlock(state, tail + i);
+    }
+
+    Sha1Digest digest{};
+    for (int i{}; i < 5; i++) {
+        digest[i * 4] = (uint8_t) (state[i] >> 24);
+        digest[i * 4 + 1] = (uint8_t) (state[i] >> 16);
+        digest[i * 4 + 2] = (uint8_t) (state[i] >> 8);
+        digest[i * 4 + 3] = (uint8_t) state[i];
+    }
+    return digest;
+}
+
+std::string toHex(const Sha1Digest& digest) {
+    constexpr char DIGITS[]{ "0123456789abcdef" };
+
+    std::string hex;
+    hex.reserve(digest.size() * 2);
+    for (uint8_t byte : digest) {
+        hex += DIGITS[byte >> 4];
+        hex += DIGITS[byte & 0xF];
+    }
+    return hex;
+}
+
+static int hexValue(char c) {
+    if (c >= '0' && c <= '9') {
+        return c - '0';
+    }
+    if (c >= 'a' && c <= 'f') {
+        return c - 'a' + 10;
+    }
+    if (c >= 'A' && c <= 'F') {
+        return c - 'A' + 10;
+    }
+    return -1;
+}
+
+bool parseSha1(const std::string& hex, Sha1Digest& digest) {
+    if (hex.size() != digest.size() * 2) {
+        return false;
+    }
+
+    for (size_t i{}; i < digest.size(); i++) {
+        int high{ hexValue(hex[i * 2]) };
+        int low{ hexValue(hex[i * 2 + 1]) };
+        if (high < 0 || low < 0) {
+            return false;
+        }
+        digest[i] = (uint8_t) (high << 4 | low);
+    }
+    return true;
+}
@@ -0,0 +1,20 @@
+#ifndef CHIP8_EMULATOR_SHA1_H
+#define CHIP8_EMULATOR_SHA1_H
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+// SHA-1 of a whole buffer, only used to identify ROMs so there is no streaming interface
+using Sha1Digest = std::array<uint8_t, 20>;
+
+Sha1Digest sha1(const uint8_t* data, size_t size);
+
+// Lower case hex, the form used as keys by the chip-8-database
+std::string toHex(const Sha1Digest& digest);
+
+// Returns false if hex is not 40 hex digits
+bool parseSha1(const std::string& hex, Sha1Digest& digest);
+
+#endif
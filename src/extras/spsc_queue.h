@@ -0,0 +1,53 @@
+#ifndef CHIP8_EMULATOR_SPSC_QUEUE_H
+#define CHIP8_EMULATOR_SPSC_QUEUE_H
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+
+// Lock-free single producer single consumer ring buffer
+// One slot is always kept empty to tell a full queue apart from an empty one
+template<typename T, size_t Capacity>
+class SPSCQueue {
+    static_assert((Capacity & (Capacity - 1)) == 0, "Capacity must be a power of two");
+
+private:
+    std::array<T, Capacity> buffer{};
+    alignas(64) std::atomic<size_t> head{}; // Written by consumer
+    alignas(64) std::atomic<size_t> tail{}; // Written by producer
+
+public:
+    // Producer side. Returns false if the queue is full
+    bool push(const T& item) {
+        size_t t{ tail.load(std::memory_order_relaxed) };
+        size_t next{ (t + 1) & (Capacity - 1) };
+        if (next == head.load(std::memory_order_acquire)) {
+            return false;
+        }
+
+        buffer[t] = item;
+        tail.store(next, std::memory_order_release);
+        return true;
+    }
+
+    // Consumer side. Returns nullptr if the queue is empty
+    const T* front() const {
+        size_t h{ head.load(std::memory_order_relaxed) };
+        if (h == tail.load(std::memory_order_acquire)) {
+            return nullptr;
+        }
+        return &buffer[h];
+    }
+
+    // Consumer side. Only call after front() returned an item
+    void pop() {
+        size_t h{ head.load(std::memory_order_relaxed) };
+        head.store((h + 1) & (Capacity - 1), std::memory_order_release);
+    }
+
+    [[nodiscard]] bool empty() const {
+        return head.load(std::memory_order_acquire) == tail.load(std::memory_order_acquire);
+    }
+};
+
+#endif
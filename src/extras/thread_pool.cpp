@@ -0,0 +1,74 @@
+#include "thread_pool.h"
+
+ThreadPool::ThreadPool(int threadCount): jobSize{}, generation{}, remaining{}, isStopping{} {
+    for (int i{1}; i < threadCount; i++) {
+        workers.emplace_back(&ThreadPool::work, this, i);
+    }
+}
+
+ThreadPool::~ThreadPool() {
+    {
+        std::lock_guard<std::mutex> lock{mutex};
+        isStopping = true;
+    }
+    startCondition.notify_all();
+
+    for (auto& worker : workers) {
+        worker.join();
+    }
+}
+
+void ThreadPool::runShare(int share, int begin, int size) {
+    int threadCount{ getThreadCount() };
+    int first{ begin + size * share / threadCount };
+    int last{ begin + size * (share + 1) / threadCount };
+    if (first < last) {
+        job(first, last);
+    }
+}
+
+void ThreadPool::work(int worker) {
+    uint64_t seen{};
+    while (true) {
+        int size;
+        {
+            std::unique_lock<std::mutex> lock{mutex};
+            startCondition.wait(lock, [&]() { return isStopping || generation != seen; });
+            if (isStopping) {
+                return;
+            }
+            seen = generation;
+            size = jobSize;
+        }
+
+        runShare(worker, 0, size);
+
+        std::lock_guard<std::mutex> lock{mutex};
+        if (--remaining == 0) {
+            doneCondition.notify_one();
+        }
+    }
+}
+
+void ThreadPool::parallelFor(int size, const std::function<void(int, int)>& fn) {
+    if (workers.empty() || size <= 1) {
+        if (size > 0) {
+            fn(0, size);
+        }
+        return;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock{mutex};
+        job = fn;
+        jobSize = size;
+        remaining = (int) workers.size();
+        generation++;
+    }
+    startCondition.notify_all();
+
+    runShare(0, 0, size);
+
+    std::unique_lock<std::mutex> lock{mutex};
+    doneCondition.wait(lock, [&]() { return remaining == 0; });
+}
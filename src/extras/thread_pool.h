@@ -0,0 +1,45 @@
+#ifndef CHIP8_EMULATOR_THREAD_POOL_H
+#define CHIP8_EMULATOR_THREAD_POOL_H
+
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Fixed set of worker threads that split an index range between them
+// The calling thread takes a share of the work too, so a pool of 1 runs everything inline
+class ThreadPool {
+private:
+    std::vector<std::thread> workers;
+    std::mutex mutex;
+    std::condition_variable startCondition;
+    std::condition_variable doneCondition;
+
+    // Current job, guarded by mutex
+    std::function<void(int, int)> job;
+    int jobSize;
+    uint64_t generation;
+    int remaining;
+    bool isStopping;
+
+    void work(int worker);
+    void runShare(int share, int begin, int size);
+
+public:
+    explicit ThreadPool(int threadCount);
+    ~ThreadPool();
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    [[nodiscard]] int getThreadCount() const {
+        return (int) workers.size() + 1;
+    }
+
+    // Calls fn(begin, end) on contiguous slices of [0, size) and returns once every slice is done
+    void parallelFor(int size, const std::function<void(int, int)>& fn);
+};
+
+#endif
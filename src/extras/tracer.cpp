@@ -0,0 +1,72 @@
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include "tracer.h"
+
+InstructionTracer::InstructionTracer(size_t capacity)
+    : writeIndex{}, readIndex{}, dropped{}, current{}, sequence{}, cachedReadIndex{}, isRunning{}
+{
+    size_t size{1};
+    while (size < capacity) {
+        size <<= 1;
+    }
+
+    buffer.resize(size);
+    mask = size - 1;
+}
+
+InstructionTracer::~InstructionTracer() {
+    close();
+}
+
+bool InstructionTracer::open(const std::string& path) {
+    close();
+
+    file.open(path, std::ios::binary | std::ios::trunc);
+    if (!file.is_open()) {
+        printf("Error: Could not open trace file %s\n", path.c_str());
+        return false;
+    }
+
+    uint32_t recordSize{ sizeof(TraceRecord) };
+    file.write(TRACE_MAGIC, sizeof(TRACE_MAGIC));
+    file.write(reinterpret_cast<const char*>(&recordSize), sizeof(recordSize));
+
+    readIndex.store(writeIndex.load(std::memory_order_acquire), std::memory_order_relaxed);
+    isRunning = true;
+    writer = std::thread([this]() {
+        using namespace std::chrono_literals;
+        while (isRunning.load(std::memory_order_relaxed)) {
+            drain();
+            std::this_thread::sleep_for(5ms);
+        }
+    });
+
+    return true;
+}
+
+void InstructionTracer::close() {
+    if (!isRunning) {
+        return;
+    }
+
+    isRunning = false;
+    writer.join();
+    drain();
+    file.close();
+}
+
+// Writer thread
+// The emulator thread leaves the slots up to the read index alone, so they are written straight from the buffer
+void InstructionTracer::drain() {
+    uint64_t r{ readIndex.load(std::memory_order_relaxed) };
+    uint64_t w{ writeIndex.load(std::memory_order_acquire) };
+
+    // At most two runs, split where the ring wraps
+    while (r < w) {
+        uint64_t count{ std::min<uint64_t>(w - r, buffer.size() - (r & mask)) };
+        file.write(reinterpret_cast<const char*>(&buffer[r & mask]), (std::streamsize) (count * sizeof(TraceRecord)));
+        r += count;
+    }
+    readIndex.store(w, std::memory_order_release);
+}
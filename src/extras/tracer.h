@@ -0,0 +1,137 @@
+#ifndef CHIP8_EMULATOR_TRACER_H
+#define CHIP8_EMULATOR_TRACER_H
+
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Binary instruction trace
+// Records are fixed size and written raw, use tools/trace_decoder to print a trace file
+
+constexpr char TRACE_MAGIC[8]{ 'C', '8', 'T', 'R', 'A', 'C', 'E', '1' };
+
+struct TraceRecord {
+    uint32_t sequence;         // Instruction number since the trace started
+    uint16_t pc;               // Address the instruction was fetched from
+    uint16_t opcode;
+    uint16_t index;            // Index register after the instruction
+    uint16_t changedRegisters; // Bit N is set if VN was changed by the instruction
+    uint8_t registers[16];     // V0 to VF after the instruction
+    uint8_t delayTimer;
+    uint8_t soundTimer;
+    uint8_t stackDepth;
+    uint8_t reserved;
+};
+
+static_assert(sizeof(TraceRecord) == 32, "Trace records are read back as raw 32 byte blocks");
+
+// Tracing policies for the run loop of Chip8 and SChip, see NullProfiler
+
+struct NullTracer {
+    void beginInstruction(uint16_t pc, uint16_t ins, const uint8_t* registers) {}
+    void endInstruction(uint16_t index, const uint8_t* registers, uint8_t delayTimer, uint8_t soundTimer, size_t stackDepth) {}
+};
+
+// Records go into a lock-free ring buffer owned by the emulator thread
+// A writer thread drains the buffer into the trace file, so the run loop itself never does I/O
+// Slots the writer thread has not saved yet are never overwritten, records that find the buffer full are dropped
+class InstructionTracer {
+private:
+    std::vector<TraceRecord> buffer;
+    size_t mask;
+    std::atomic<uint64_t> writeIndex;  // Only written by the emulator thread
+    std::atomic<uint64_t> readIndex;   // Only written by the writer thread
+    std::atomic<uint64_t> dropped;     // Only written by the emulator thread
+
+    // Emulator thread
+    TraceRecord current;
+    uint64_t sequence;
+    uint64_t cachedReadIndex; // Reloaded only when the buffer looks full
+
+    std::ofstream file;
+    std::thread writer;
+    std::atomic<bool> isRunning;
+
+    void drain();
+
+public:
+    // Capacity is rounded up to a power of two
+    explicit InstructionTracer(size_t capacity = 1 << 16);
+    ~InstructionTracer();
+
+    bool open(const std::string& path);
+    void close();
+
+    void beginInstruction(uint16_t pc, uint16_t ins, const uint8_t* registers) {
+        current.pc = pc;
+        current.opcode = ins;
+        memcpy(current.registers, registers, 16);
+    }
+
+    void endInstruction(uint16_t index, const uint8_t* registers, uint8_t delayTimer, uint8_t soundTimer, size_t stackDepth) {
+        uint16_t changed{};
+        for (int i{}; i < 16; i++) {
+            changed |= (uint16_t) (current.registers[i] != registers[i]) << i;
+        }
+
+        uint64_t w{ writeIndex.load(std::memory_order_relaxed) };
+        if (w - cachedReadIndex > mask) {
+            cachedReadIndex = readIndex.load(std::memory_order_acquire);
+            if (w - cachedReadIndex > mask) {
+                dropped.store(dropped.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+                sequence++;
+                return;
+            }
+        }
+
+        TraceRecord& record{ buffer[w & mask] };
+        record.sequence = (uint32_t) sequence++;
+        record.pc = current.pc;
+        record.opcode = current.opcode;
+        record.index = index;
+        record.changedRegisters = changed;
+        memcpy(record.registers, registers, 16);
+        record.delayTimer = delayTimer;
+        record.soundTimer = soundTimer;
+        record.stackDepth = (uint8_t) stackDepth;
+        record.reserved = 0;
+        writeIndex.store(w + 1, std::memory_order_release);
+    }
+
+    // Records that found the buffer full of ones the writer thread had not saved yet
+    [[nodiscard]] uint64_t getDroppedCount() const {
+        return dropped.load(std::memory_order_relaxed);
+    }
+
+    // Every traced instruction, dropped or not
+    [[nodiscard]] uint64_t getRecordCount() const {
+        return writeIndex.load(std::memory_order_relaxed) + dropped.load(std::memory_order_relaxed);
+    }
+};
+
+// Forwards to an InstructionTracer that may be null, see OptionalProfiler
+class OptionalTracer {
+private:
+    InstructionTracer* tracer;
+
+public:
+    explicit OptionalTracer(InstructionTracer* tracer): tracer{tracer} {}
+
+    void beginInstruction(uint16_t pc, uint16_t ins, const uint8_t* registers) {
+        if (tracer != nullptr) {
+            tracer->beginInstruction(pc, ins, registers);
+        }
+    }
+
+    void endInstruction(uint16_t index, const uint8_t* registers, uint8_t delayTimer, uint8_t soundTimer, size_t stackDepth) {
+        if (tracer != nullptr) {
+            tracer->endInstruction(index, registers, delayTimer, soundTimer, stackDepth);
+        }
+    }
+};
+
+#endif
@@ -0,0 +1,48 @@
+#include <cstdio>
+#include "sdl_audio.h"
+#include "oscillator.h"
+#include "../constants.h"
+
+SDLAudio::~SDLAudio() {
+    if (isOpen) {
+        SDL_CloseAudio();
+    }
+}
+
+bool SDLAudio::open() {
+    // Realised that SDL_OpenAudio creates its own thread so there was no need for a separate sound player thread
+    auto callback = [](void* userdata, uint8_t* stream, int len) -> void {
+        static Oscillator os{ 440.0f, 0.5f };
+
+        auto* floatStream = (float*) stream;
+        for (int i{}; i < 4096; i++) {
+            floatStream[i] = Oscillator::next(os);
+        }
+    };
+
+    SDL_AudioSpec spec{
+        AUDIO_SAMPLE_RATE,
+        AUDIO_F32,
+        1,
+        0,
+        4096,
+        0,
+        0,
+        callback,
+        nullptr
+    };
+
+    if (SDL_OpenAudio(&spec, nullptr) < 0) {
+        printf("Failed to open Audio Device: %s\n", SDL_GetError());
+        return false;
+    }
+
+    isOpen = true;
+    return true;
+}
+
+void SDLAudio::setPlaying(bool isPlaying) {
+    if (isOpen) {
+        SDL_PauseAudio(isPlaying ? 0 : 1);
+    }
+}
@@ -0,0 +1,22 @@
+#ifndef CHIP8_EMULATOR_SDL_AUDIO_H
+#define CHIP8_EMULATOR_SDL_AUDIO_H
+
+#include "SDL.h"
+#include "../extras/audio_output.h"
+
+// 440 Hz tone through SDL's audio thread
+class SDLAudio : public AudioOutput {
+private:
+    bool isOpen;
+
+public:
+    SDLAudio(): isOpen{} {}
+    ~SDLAudio() override;
+
+    // Starts paused
+    bool open();
+
+    void setPlaying(bool isPlaying) override;
+};
+
+#endif
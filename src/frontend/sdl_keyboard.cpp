@@ -0,0 +1,55 @@
+#include "sdl_keyboard.h"
+
+SDLKeyboard::SDLKeyboard(InputHandler& inputHandler): inputHandler{inputHandler}, keyMap{} {
+    setDefaultKeyMap();
+}
+
+
+// Key Mapping
+void SDLKeyboard::setDefaultKeyMap() {
+    keyMap.fill(-1);
+
+    // COSMAC VIP keypad laid out on the left side of a QWERTY keyboard
+    setKeyMapping(SDLK_1, 0x1);
+    setKeyMapping(SDLK_2, 0x2);
+    setKeyMapping(SDLK_3, 0x3);
+    setKeyMapping(SDLK_4, 0xC);
+    setKeyMapping(SDLK_q, 0x4);
+    setKeyMapping(SDLK_w, 0x5);
+    setKeyMapping(SDLK_e, 0x6);
+    setKeyMapping(SDLK_r, 0xD);
+    setKeyMapping(SDLK_a, 0x7);
+    setKeyMapping(SDLK_s, 0x8);
+    setKeyMapping(SDLK_d, 0x9);
+    setKeyMapping(SDLK_f, 0xE);
+    setKeyMapping(SDLK_z, 0xA);
+    setKeyMapping(SDLK_x, 0x0);
+    setKeyMapping(SDLK_c, 0xB);
+    setKeyMapping(SDLK_v, 0xF);
+}
+
+void SDLKeyboard::setKeyMapping(SDL_Keycode code, int key) {
+    if (code < 0 || code >= (SDL_Keycode) keyMap.size() || key < -1 || key > 0xF) {
+        return;
+    }
+    keyMap[code] = (int8_t) key;
+}
+
+int SDLKeyboard::mapKeyCode(SDL_Keycode code) const {
+    if (code < 0 || code >= (SDL_Keycode) keyMap.size()) {
+        return -1;
+    }
+    return keyMap[code];
+}
+
+
+// SDL event thread
+void SDLKeyboard::handleInput(SDL_Event& e) {
+    // Unmapped keys and auto repeat are dropped silently
+    int key{ mapKeyCode(e.key.keysym.sym) };
+    if (key == -1 || e.key.repeat) {
+        return;
+    }
+
+    inputHandler.pushEvent(InputEvent{ InputHandler::now(), (uint8_t) key, e.type == SDL_KEYDOWN });
+}
@@ -0,0 +1,32 @@
+#ifndef CHIP8_EMULATOR_SDL_KEYBOARD_H
+#define CHIP8_EMULATOR_SDL_KEYBOARD_H
+
+#include <array>
+#include <cstdint>
+#include "SDL_events.h"
+#include "../extras/input_handler.h"
+
+// Turns SDL key events into CHIP-8 key events for the emulator's InputHandler
+class SDLKeyboard {
+private:
+    InputHandler& inputHandler;
+
+    // SDL keycodes used by the default layout are all ASCII, so a flat table is enough
+    std::array<int8_t, 128> keyMap;
+
+    int mapKeyCode(SDL_Keycode code) const;
+
+public:
+    explicit SDLKeyboard(InputHandler& inputHandler);
+
+    // Key Mapping
+    void setDefaultKeyMap();
+    void setKeyMapping(SDL_Keycode code, int key); // key == -1 unmaps the keycode
+
+    // SDL event thread
+    // Check input is a valid KeyboardEvent first before using
+    // Cannot cast union to one of its member type
+    void handleInput(SDL_Event& e);
+};
+
+#endif
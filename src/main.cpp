@@ -1,133 +1,472 @@
+#include <algorithm>
+#include <chrono>
 #include <cstdio>
+#include <fstream>
+#include <iterator>
+#include <memory>
 #include <thread>
-#include "SDL.h"
-#include "SDL_events.h"
+#include <vector>
 #include "constants.h"
 #include "emulators/chip8.h"
 #include "displays/simple_display.h"
+#include "extras/command_line.h"
+#include "emulators/schip.h"
+#include "extras/gdb_stub.h"
+#include "extras/run_control.h"
+#include "extras/rom_database.h"
+
+// The headless build links only the core, without SDL there is no window, audio or netplay
+#ifndef CHIP8_EMULATOR_HEADLESS
+#include "SDL.h"
+#include "SDL_events.h"
 #include "displays/simple_sdl_display.h"
-#include "extras/oscillator.h"
 #include "displays/advanced_sdl_display.h"
-#include "emulators/schip.h"
+#include "extras/sha1.h"
+#include "frontend/sdl_audio.h"
+#include "frontend/sdl_keyboard.h"
+#include "netplay/netplay_peer.h"
+#include "netplay/rollback_session.h"
+#include "netplay/udp_socket.h"
+#else
+struct SDL_Window; // Never created, the window stays null
+#endif
+
+#ifndef CHIP8_EMULATOR_HEADLESS
+constexpr int NETPLAY_CONNECT_TIMEOUT_MS{60000};
+#endif
 
+// Either core behind the Emulator interface, with the display it draws to
+// The emulator is declared last so it is destroyed before its display
+struct Machine {
+    std::unique_ptr<SimpleDisplay> simpleDisplay;
+    std::unique_ptr<AdvancedDisplay> advancedDisplay;
+    std::unique_ptr<Emulator> emulator;
+};
 
-int main(int argv, char* args[]) {
-    // So that any line printed is displayed immediately
-    setbuf(stdout, nullptr);
 
+// Helper
+static bool readRom(const std::string& path, std::vector<uint8_t>& rom) {
+    std::ifstream input{ path, std::ios::binary };
+    if (!input.is_open()) {
+        printf("Error: Specified input file not found\n");
+        return false;
+    }
 
+    rom.assign(std::istreambuf_iterator<char>(input), std::istreambuf_iterator<char>());
+    return true;
+}
 
-    // Initialize SDL
-    if (SDL_Init(SDL_INIT_VIDEO | SDL_INIT_AUDIO | SDL_INIT_EVENTS) < 0) {
-        printf("SDL could not initialize! SDL_Error: %s\n", SDL_GetError());
-        return -1;
+// Platform, quirks, speed and colours come from the ROM database, SCHIP defaults otherwise
+// The command line overrides any of them
+static RomInfo resolveRomInfo(const CommandLineOptions& options, const std::vector<uint8_t>& rom) {
+    RomInfo romInfo{ getDefaultRomInfo(Platform::SCHIP) };
+    RomDatabase database{};
+    if (database.loadIndex(options.romDatabasePath) && database.find(rom.data(), rom.size(), romInfo)) {
+        printf("%s\n", romInfo.title.c_str());
     }
 
-    SDL_Window* window = SDL_CreateWindow("Chip8 Emulator", SDL_WINDOWPOS_UNDEFINED, SDL_WINDOWPOS_UNDEFINED, SCREEN_WIDTH, SCREEN_HEIGHT, SDL_WINDOW_SHOWN);
-    if (window == nullptr) {
-        printf("Window could not be created! SDL_Error: %s\n", SDL_GetError());
-        return -1;
+    // The database settings are kept when the core does not change, they are still right for the ROM
+    if (options.core == CoreChoice::CHIP8 && romInfo.platform != Platform::CHIP8) {
+        romInfo = getDefaultRomInfo(Platform::CHIP8);
+    } else if (options.core == CoreChoice::SCHIP && romInfo.platform == Platform::CHIP8) {
+        romInfo = getDefaultRomInfo(Platform::SCHIP);
     }
 
-    SDL_Surface* surface = SDL_GetWindowSurface(window);
-    bool quit{false};
-    SDL_Event e;
+    if (options.hasQuirks) {
+        romInfo.quirks = options.quirks;
+    }
+    if (options.instructionsPerFrame > 0) {
+        romInfo.instructionsPerFrame = options.instructionsPerFrame;
+    }
+    return romInfo;
+}
 
+// SDL displays when there is a window, plain framebuffers otherwise
+// XO-CHIP ROMs run on the SCHIP core with XO-CHIP quirks, which covers the ones that stay within SCHIP
+static Machine createMachine(const RomInfo& romInfo, InputHandler& inputHandler, SDL_Window* window, int scale) {
+    Machine machine{};
+    if (romInfo.platform == Platform::CHIP8) {
+#ifndef CHIP8_EMULATOR_HEADLESS
+        if (window != nullptr) {
+            auto display{ std::make_unique<SimpleSDLDisplay>(window, SDL_GetWindowSurface(window), scale) };
+            display->setColors(romInfo.foregroundColor, romInfo.backgroundColor);
+            machine.simpleDisplay = std::move(display);
+        }
+#endif
+        if (machine.simpleDisplay == nullptr) {
+            machine.simpleDisplay = std::make_unique<SimpleDisplay>();
+        }
+        machine.emulator = std::make_unique<Chip8>(*machine.simpleDisplay, inputHandler, romInfo.quirks);
+    } else {
+#ifndef CHIP8_EMULATOR_HEADLESS
+        if (window != nullptr) {
+            auto display{ std::make_unique<AdvancedSDLDisplay>(window, SDL_GetWindowSurface(window), scale) };
+            display->setColors(romInfo.foregroundColor, romInfo.backgroundColor);
+            machine.advancedDisplay = std::move(display);
+        }
+#endif
+        if (machine.advancedDisplay == nullptr) {
+            machine.advancedDisplay = std::make_unique<AdvancedDisplay>();
+        }
+        machine.emulator = std::make_unique<SChip>(*machine.advancedDisplay, inputHandler, romInfo.quirks);
+    }
 
+    machine.emulator->setInstructionsPerFrame(romInfo.instructionsPerFrame);
+    return machine;
+}
 
-    // Initialising the emulator
-    InputHandler inputHandler{};
-    std::string file{"../test_roms/DVN8.ch8"};
+#ifndef CHIP8_EMULATOR_HEADLESS
+// Run keys outside the keypad: P pauses and resumes, N and M step a frame and an instruction while paused,
+// minus and equals halve and double the speed, and Tab runs at unlimited speed while it is held
+static bool handleRunKey(const SDL_Event& e, RunControl& control, double& heldSpeed) {
+    bool isDown{ e.type == SDL_KEYDOWN };
+    if (e.key.keysym.sym == SDLK_TAB) {
+        if (isDown && !e.key.repeat) {
+            heldSpeed = control.getSpeed();
+            control.setSpeed(RunControl::UNLIMITED_SPEED);
+        } else if (!isDown) {
+            control.setSpeed(heldSpeed);
+        }
+        return true;
+    }
+    if (!isDown) {
+        return false;
+    }
 
-    // Chip 8
-    AdvancedSDLDisplay display{window, surface};
-    SChip emulator{display, inputHandler};
+    switch (e.key.keysym.sym) {
+        case SDLK_p:
+            if (e.key.repeat) {
+                return true;
+            }
+            if (control.isPaused()) {
+                control.resume();
+            } else {
+                control.pause();
+            }
+            return true;
+        case SDLK_n:
+            control.stepFrame();
+            return true;
+        case SDLK_m:
+            control.stepInstruction();
+            return true;
+        case SDLK_MINUS:
+            control.setSpeed(control.getSpeed() / 2);
+            return true;
+        case SDLK_EQUALS:
+            // Capped at 64x, past that the core cannot keep up anyway
+            control.setSpeed(std::min(control.getSpeed() * 2, 64.0));
+            return true;
+        default:
+            return false;
+    }
+}
+
+// Paced run on the CPU thread while this thread handles window events, until the window is closed
+// A GDB stub is served on a third thread
+static bool runWindowed(Emulator& emulator, InputHandler& inputHandler, GdbStub* gdbStub) {
+    SDLAudio audio{};
+    if (!audio.open()) {
+        return false;
+    }
+    emulator.setAudioOutput(&audio);
 
-    // SCHIP
-//    AdvancedSDLDisplay display{window, surface};
-//    SChip emulator{ display, inputHandler };
+    SDLKeyboard keyboard{ inputHandler };
+    RunControl control{};
+    double heldSpeed{1.0};
+    std::thread cpuThread(&Emulator::resume, &emulator, std::ref(control));
+    std::thread gdbThread;
+    if (gdbStub != nullptr) {
+        gdbThread = std::thread(&GdbStub::serve, gdbStub, std::ref(control));
+    }
+
+    // Main Program Loop
+    SDL_Event e;
+    while (!control.isStopping() && SDL_WaitEvent(&e) != 0) {
+        if (e.type == SDL_QUIT) {
+            control.stop();
+        }
 
-    std::thread cpuThread(&SChip::run, &emulator, std::ref(file), std::ref(quit));
+        if ((e.type == SDL_KEYDOWN || e.type == SDL_KEYUP) && !handleRunKey(e, control, heldSpeed)) {
+            keyboard.handleInput(e);
+        }
+    }
 
+    // Terminating Threads
+    control.stop();
+    cpuThread.join();
+    if (gdbThread.joinable()) {
+        gdbThread.join();
+    }
+    emulator.setAudioOutput(nullptr);
+    return true;
+}
+#endif
 
+// Paced run on the CPU thread while this thread serves GDB, until the session or the ROM ends
+static bool runWithGdb(Emulator& emulator, GdbStub& gdbStub) {
+    RunControl control{};
+    std::thread cpuThread([&]() {
+        emulator.resume(control);
+        control.stop();
+    });
 
-    // Initializing the audio
-    // Realised that SDL_OpenAudio creates its own thread so there was no need for a separate sound player thread
-    auto callback = [](void* userdata, uint8_t* stream, int len) -> void {
-        static Oscillator os{ 440.0f, 0.5f };
+    gdbStub.serve(control);
+    control.stop();
+    cpuThread.join();
+    return true;
+}
 
-        auto* floatStream = (float*) stream;
-        for (int i{}; i < 4096; i++) {
-            floatStream[i] = Oscillator::next(os);
+#ifndef CHIP8_EMULATOR_HEADLESS
+// Repaints the pixels of window that differ from frame, then shows it
+static void presentFrame(SimpleDisplay& window, const SimpleDisplay& frame) {
+    for (int y{}; y < HEIGHT; y++) {
+        for (int x{}; x < WIDTH; x++) {
+            if (window.getPixel(x, y) != frame.getPixel(x, y)) {
+                window.drawPixel(x, y, frame.getPixel(x, y));
+            }
         }
-    };
+    }
+    window.updateWindowSurface();
+}
 
-    SDL_AudioSpec spec{
-        AUDIO_SAMPLE_RATE,
-        AUDIO_F32,
-        1,
-        0,
-        4096,
-        0,
-        0,
-        callback,
-        nullptr
-    };
+static void presentFrame(AdvancedDisplay& window, const AdvancedDisplay& frame) {
+    window.switchOperationalMode(frame.isHiresMode());
+    for (int y{}; y < frame.getHeight(); y++) {
+        for (int x{}; x < frame.getWidth(); x++) {
+            if (window.getPixel(x, y) != frame.getPixel(x, y)) {
+                window.drawPixel(x, y, frame.getPixel(x, y));
+            }
+        }
+    }
+    window.updateWindowSurface();
+}
 
-    if (SDL_OpenAudio(&spec, nullptr) < 0) {
-        printf("Failed to open Audio Device: %s\n", SDL_GetError());
-        return -1;
+// Rollback netplay with the peer from the command line, until the window is closed, the peer goes quiet or the ROM exits
+// The core runs on this thread on keys sampled once a frame. It draws off screen, so frames a rollback runs again
+// are never shown, and the window is only given the frame each advance ends on
+template<typename Core, typename Display>
+static bool runNetplay(Display& window, const RomInfo& romInfo, const std::vector<uint8_t>& rom,
+                       const CommandLineOptions& options) {
+    UdpEndpoint remote{};
+    if (!parseEndpoint(options.netplayPeer, remote)) {
+        printf("Error: --netplay expects host:port, got %s\n", options.netplayPeer.c_str());
+        return false;
     }
 
+    NetplayPeer peer{};
+    if (!peer.open(options.netplayPort, remote, sha1(rom.data(), rom.size()))) {
+        return false;
+    }
+    printf("Waiting for the other player on port %d\n", peer.getPort());
+    if (!peer.connect(NETPLAY_CONNECT_TIMEOUT_MS)) {
+        return false;
+    }
 
+    Display frame{};
+    InputHandler sessionInput{};
+    Core core{ frame, sessionInput, romInfo.quirks };
+    core.setInstructionsPerFrame(romInfo.instructionsPerFrame);
+    core.seedRandom(peer.getSeed());
+    if (!core.loadRom(rom.data(), rom.size())) {
+        return false;
+    }
+    RollbackSession<Core> session{ core, sessionInput };
 
-    // Main Program Loop
-    while (!quit) {
-        while (SDL_WaitEvent(&e) != 0) {
-            if (e.type == SDL_QUIT) {
-                quit = true;
+    SDLAudio audio{};
+    if (!audio.open()) {
+        return false;
+    }
+    bool isSoundPlaying{};
 
-                // Terminating Threads
-                printf("Terminating threads");
-                cpuThread.join();
-                printf("thread terminated");
+    InputHandler keyboardInput{};
+    SDLKeyboard keyboard{ keyboardInput };
+    auto nextFrame{ std::chrono::steady_clock::now() };
+    while (true) {
+        SDL_Event e;
+        while (SDL_PollEvent(&e) != 0) {
+            if (e.type == SDL_QUIT) {
+                return true;
+            }
+            if (e.type == SDL_KEYDOWN || e.type == SDL_KEYUP) {
+                keyboard.handleInput(e);
+            }
+        }
+        keyboardInput.applyEvents(InputHandler::now());
 
-                // Destroy SDL Stuff
-                SDL_DestroyWindow(window);
-                window = nullptr;
-                SDL_Quit();
+        // Stalls while the other side is too far behind, as long as it still sends something
+        session.receiveInputs(peer);
+        if (session.canAdvance()) {
+            if (!session.advance(keyboardInput.getKeyState())) {
+                return true;
             }
+            presentFrame(window, frame);
 
-            if (e.type == SDL_KEYDOWN || e.type == SDL_KEYUP) {
-                inputHandler.handleInput(e);
+            bool shouldPlay{ core.getDebugRegisters().soundTimer > 0 };
+            if (shouldPlay != isSoundPlaying) {
+                audio.setPlaying(shouldPlay);
+                isSoundPlaying = shouldPlay;
             }
+        } else if (InputHandler::now() - peer.getLastReceiveTime() > (uint64_t) NETPLAY_TIMEOUT_MS * 1000000) {
+            printf("Error: The other player stopped responding\n");
+            return false;
         }
+        session.sendInputs(peer);
+
+        nextFrame += std::chrono::nanoseconds(FRAME_DURATION_NS);
+        std::this_thread::sleep_until(nextFrame);
     }
+}
+#endif
 
-//    AdvancedSDLDisplay advancedDisplay{ window, surface };
-//    InputHandler inputHandler{};
-//    SChip schip{ advancedDisplay, inputHandler };
-//    advancedDisplay.switchOperationalMode(true);
-//    for (int i{}; i < 32; i++) {
-//        schip.memory[i] = 0xFF;
-//    }
-//    schip.decode(0xD010);
-//    schip.decode(0xD010);
-//    schip.decode(0xD010);
-//    advancedDisplay.updateWindowSurface();
 
-    while (!quit) {
-        while (SDL_WaitEvent(&e) != 0) {
-            if (e.type == SDL_QUIT) {
-                quit = true;
+int main(int argc, char* argv[]) {
+    CommandLineOptions options{};
+    std::string error;
+    if (!parseCommandLine(argc, argv, options, error)) {
+        printf("Error: %s\n", error.c_str());
+        printUsage(argv[0]);
+        return 1;
+    }
+    if (options.isHelp) {
+        printUsage(argv[0]);
+        return 0;
+    }
 
-                // Destroy SDL Stuff
-                SDL_DestroyWindow(window);
-                window = nullptr;
-                SDL_Quit();
-            }
+    std::vector<uint8_t> rom;
+    if (!readRom(options.romPath, rom)) {
+        return 1;
+    }
+    RomInfo romInfo{ resolveRomInfo(options, rom) };
+
+#ifdef CHIP8_EMULATOR_HEADLESS
+    if (!options.isHeadless || !options.netplayPeer.empty()) {
+        printf("Error: This build has no window or netplay, run it with --headless\n");
+        return 1;
+    }
+#endif
+
+    // Initialize SDL, headless runs do not touch it
+    SDL_Window* window{};
+#ifndef CHIP8_EMULATOR_HEADLESS
+    if (!options.isHeadless) {
+        if (SDL_Init(SDL_INIT_VIDEO | SDL_INIT_AUDIO | SDL_INIT_EVENTS) < 0) {
+            printf("SDL could not initialize! SDL_Error: %s\n", SDL_GetError());
+            return -1;
+        }
+
+        // SCHIP starts in lores, the window is resized when the ROM switches to hires
+        int screenWidth{ options.scale * WIDTH + (WIDTH - 1) };
+        int screenHeight{ options.scale * HEIGHT + (HEIGHT - 1) };
+        window = SDL_CreateWindow("Chip8 Emulator", SDL_WINDOWPOS_UNDEFINED, SDL_WINDOWPOS_UNDEFINED, screenWidth, screenHeight, SDL_WINDOW_SHOWN);
+        if (window == nullptr) {
+            printf("Window could not be created! SDL_Error: %s\n", SDL_GetError());
+            return -1;
+        }
+    }
+
+    // Netplay runs a core of its own, the window only gets a display to present to
+    if (!options.netplayPeer.empty()) {
+        if (window == nullptr) {
+            printf("Error: Netplay needs a window\n");
+            return 1;
+        }
+
+        bool isNetplayOk;
+        if (romInfo.platform == Platform::CHIP8) {
+            SimpleSDLDisplay display{ window, SDL_GetWindowSurface(window), options.scale };
+            display.setColors(romInfo.foregroundColor, romInfo.backgroundColor);
+            isNetplayOk = runNetplay<Chip8, SimpleDisplay>(display, romInfo, rom, options);
+        } else {
+            AdvancedSDLDisplay display{ window, SDL_GetWindowSurface(window), options.scale };
+            display.setColors(romInfo.foregroundColor, romInfo.backgroundColor);
+            isNetplayOk = runNetplay<SChip, AdvancedDisplay>(display, romInfo, rom, options);
         }
+
+        SDL_DestroyWindow(window);
+        SDL_Quit();
+        return isNetplayOk ? 0 : 1;
+    }
+#endif
+
+    // Initialising the emulator
+    InputHandler inputHandler{};
+    Machine machine{ createMachine(romInfo, inputHandler, window, options.scale) };
+    Emulator& emulator{ *machine.emulator };
+    emulator.setRunAheadFrames(options.runAheadFrames);
+
+    if (!emulator.loadRom(rom.data(), rom.size())) {
+        return 1;
+    }
+    if (!options.loadStatePath.empty() && !emulator.loadState(options.loadStatePath)) {
+        return 1;
+    }
+
+    InstructionTracer tracer{};
+    if (!options.tracePath.empty()) {
+        if (!tracer.open(options.tracePath)) {
+            return 1;
+        }
+        emulator.setTracer(&tracer);
+    }
+
+    std::unique_ptr<ExecutionProfiler> profiler;
+    if (!options.profilePrefix.empty()) {
+        profiler = std::make_unique<ExecutionProfiler>(options.profilePrefix);
+        emulator.setProfiler(profiler.get());
+    }
+
+    // Halted before the first instruction until GDB attaches and continues
+    Debugger debugger{};
+    GdbStub gdbStub{ emulator, debugger };
+    if (options.gdbPort > 0) {
+        if (!gdbStub.listen(options.gdbPort)) {
+            return 1;
+        }
+        emulator.setDebugger(&debugger);
+        debugger.requestStop();
+        printf("Waiting for GDB on 127.0.0.1:%d\n", gdbStub.getPort());
+    }
+
+    // Running
+    auto start{ std::chrono::steady_clock::now() };
+    bool isRunOk{};
+    if (options.isHeadless && options.gdbPort > 0) {
+        isRunOk = runWithGdb(emulator, gdbStub);
+    } else if (options.isHeadless) {
+        isRunOk = emulator.runFrames(options.frameCount);
+
+        // The paced loop writes its own profile when it stops
+        if (profiler != nullptr) {
+            profiler->writeReports();
+        }
+    }
+#ifndef CHIP8_EMULATOR_HEADLESS
+    else {
+        isRunOk = runWindowed(emulator, inputHandler, options.gdbPort > 0 ? &gdbStub : nullptr);
+    }
+#endif
+    std::chrono::duration<double> elapsed{ std::chrono::steady_clock::now() - start };
+    tracer.close();
+
+    if (options.isBenchmark) {
+        double seconds{ elapsed.count() > 0 ? elapsed.count() : 1e-9 };
+        printf("frames=%llu instructions=%llu seconds=%.6f ips=%.0f fps=%.1f\n",
+               (unsigned long long) emulator.getFrameCount(), (unsigned long long) emulator.getInstructionCount(),
+               elapsed.count(), (double) emulator.getInstructionCount() / seconds, (double) emulator.getFrameCount() / seconds);
+    }
+
+    if (!options.saveStatePath.empty() && !emulator.saveState(options.saveStatePath)) {
+        return 1;
+    }
+
+    // Destroy SDL Stuff
+#ifndef CHIP8_EMULATOR_HEADLESS
+    if (window != nullptr) {
+        SDL_DestroyWindow(window);
+        SDL_Quit();
     }
+#endif
 
-    return 0;
-}
\ No newline at end of file
+    return isRunOk ? 0 : 1;
+}
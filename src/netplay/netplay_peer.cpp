@@ -0,0 +1,160 @@
+#include <cstdio>
+#include <cstring>
+#include <random>
+#include "netplay_peer.h"
+#include "../extras/input_handler.h"
+
+constexpr uint8_t NETPLAY_MAGIC[4]{ 'C', '8', 'N', 'P' };
+constexpr uint8_t HELLO_PACKET{0};
+constexpr uint8_t INPUT_PACKET{1};
+constexpr int HELLO_SIZE{ 4 + 1 + 2 + 1 + 4 + 20 };
+constexpr int INPUT_HEADER_SIZE{ 4 + 1 + 4 + 4 + 1 };
+constexpr int MAX_PACKET_SIZE{ INPUT_HEADER_SIZE + MAX_INPUTS_PER_PACKET * 2 };
+constexpr int HELLO_INTERVAL_MS{100};
+
+
+// Helper
+static void put16(uint8_t* out, uint16_t value) {
+    out[0] = value & 0xFF;
+    out[1] = value >> 8;
+}
+
+static void put32(uint8_t* out, uint32_t value) {
+    put16(out, value & 0xFFFF);
+    put16(out + 2, value >> 16);
+}
+
+static uint16_t get16(const uint8_t* in) {
+    return in[0] | (in[1] << 8);
+}
+
+static uint32_t get32(const uint8_t* in) {
+    return get16(in) | ((uint32_t) get16(in + 2) << 16);
+}
+
+
+NetplayPeer::NetplayPeer(): remote{}, romDigest{}, localNonce{}, remoteNonce{}, hasRemoteHello{}, isConnected{},
+    lastReceiveTime{} {
+    std::random_device r;
+    localNonce = r();
+}
+
+bool NetplayPeer::open(uint16_t localPort, const UdpEndpoint& remoteEndpoint, const Sha1Digest& digest) {
+    remote = remoteEndpoint;
+    romDigest = digest;
+    return socket.open(localPort);
+}
+
+
+// Handshake
+void NetplayPeer::sendHello() {
+    uint8_t packet[HELLO_SIZE]{};
+    memcpy(packet, NETPLAY_MAGIC, sizeof(NETPLAY_MAGIC));
+    packet[4] = HELLO_PACKET;
+    put16(packet + 5, NETPLAY_VERSION);
+    packet[7] = hasRemoteHello;
+    put32(packet + 8, localNonce);
+    memcpy(packet + 12, romDigest.data(), romDigest.size());
+    socket.sendTo(remote, packet, sizeof(packet));
+}
+
+bool NetplayPeer::handleHello(const uint8_t* packet, int size) {
+    if (size != HELLO_SIZE) {
+        return true;
+    }
+    if (get16(packet + 5) != NETPLAY_VERSION) {
+        printf("Error: The other side speaks netplay version %d, this one %d\n", get16(packet + 5), NETPLAY_VERSION);
+        return false;
+    }
+    if (memcmp(packet + 12, romDigest.data(), romDigest.size()) != 0) {
+        printf("Error: The other side is running another ROM\n");
+        return false;
+    }
+
+    remoteNonce = get32(packet + 8);
+    hasRemoteHello = true;
+    isConnected = isConnected || packet[7] != 0;
+    return true;
+}
+
+bool NetplayPeer::connect(int timeoutMs) {
+    uint64_t deadline{ InputHandler::now() + (uint64_t) timeoutMs * 1000000 };
+    uint8_t packet[MAX_PACKET_SIZE];
+    while (!isConnected) {
+        uint64_t now{ InputHandler::now() };
+        if (now >= deadline) {
+            printf("Error: Nobody answered the netplay handshake\n");
+            return false;
+        }
+
+        sendHello();
+        socket.waitForData(HELLO_INTERVAL_MS);
+
+        UdpEndpoint from{};
+        int size;
+        while (!isConnected && (size = socket.receiveFrom(packet, sizeof(packet), from)) >= 0) {
+            if (!(from == remote) || size < 5 || memcmp(packet, NETPLAY_MAGIC, sizeof(NETPLAY_MAGIC)) != 0) {
+                continue;
+            }
+            lastReceiveTime = InputHandler::now();
+
+            // Inputs only come from a side that is done, so it has seen a hello from this one
+            if (packet[4] == HELLO_PACKET && !handleHello(packet, size)) {
+                return false;
+            }
+            isConnected = isConnected || (packet[4] == INPUT_PACKET && hasRemoteHello);
+        }
+    }
+
+    // The other side may still be waiting to hear that its hello arrived
+    sendHello();
+    return true;
+}
+
+
+// Inputs
+void NetplayPeer::sendInputs(const NetplayInputs& inputs) {
+    uint8_t packet[MAX_PACKET_SIZE];
+    memcpy(packet, NETPLAY_MAGIC, sizeof(NETPLAY_MAGIC));
+    packet[4] = INPUT_PACKET;
+    put32(packet + 5, inputs.ack);
+    put32(packet + 9, inputs.firstFrame);
+    packet[13] = (uint8_t) inputs.count;
+    for (int i{}; i < inputs.count; i++) {
+        put16(packet + INPUT_HEADER_SIZE + i * 2, inputs.masks[i]);
+    }
+    socket.sendTo(remote, packet, INPUT_HEADER_SIZE + inputs.count * 2);
+}
+
+bool NetplayPeer::receiveInputs(NetplayInputs& inputs) {
+    uint8_t packet[MAX_PACKET_SIZE];
+    UdpEndpoint from{};
+    int size;
+    while ((size = socket.receiveFrom(packet, sizeof(packet), from)) >= 0) {
+        if (!(from == remote) || size < 5 || memcmp(packet, NETPLAY_MAGIC, sizeof(NETPLAY_MAGIC)) != 0) {
+            continue;
+        }
+        lastReceiveTime = InputHandler::now();
+
+        // Its hello with the flag set may have been lost, it keeps saying hello until it hears one
+        if (packet[4] == HELLO_PACKET) {
+            if (handleHello(packet, size) && packet[7] == 0) {
+                sendHello();
+            }
+            continue;
+        }
+
+        if (packet[4] != INPUT_PACKET || size < INPUT_HEADER_SIZE || packet[13] > MAX_INPUTS_PER_PACKET ||
+            size != INPUT_HEADER_SIZE + packet[13] * 2) {
+            continue;
+        }
+        inputs.ack = get32(packet + 5);
+        inputs.firstFrame = get32(packet + 9);
+        inputs.count = packet[13];
+        for (int i{}; i < inputs.count; i++) {
+            inputs.masks[i] = get16(packet + INPUT_HEADER_SIZE + i * 2);
+        }
+        return true;
+    }
+    return false;
+}
@@ -0,0 +1,67 @@
+#ifndef CHIP8_EMULATOR_NETPLAY_PEER_H
+#define CHIP8_EMULATOR_NETPLAY_PEER_H
+
+#include <array>
+#include <cstdint>
+#include "udp_socket.h"
+#include "../extras/sha1.h"
+
+constexpr uint16_t NETPLAY_VERSION{1};
+constexpr int MAX_INPUTS_PER_PACKET{32};
+constexpr int NETPLAY_TIMEOUT_MS{5000}; // Silence after which the other side is taken to be gone
+
+// Keypad masks of consecutive frames, and how far the sender has the receiver's own masks
+struct NetplayInputs {
+    uint32_t ack;        // The sender has every mask of the receiver before this frame
+    uint32_t firstFrame;
+    int count;
+    std::array<uint16_t, MAX_INPUTS_PER_PACKET> masks;
+};
+
+// One side of a two player session over UDP, the handshake and the packets but no emulation
+// Packets are little endian. Input packets repeat every mask the other side has not acknowledged yet,
+// so a lost packet is made up for by the next one instead of being resent
+class NetplayPeer {
+private:
+    UdpSocket socket;
+    UdpEndpoint remote;
+    Sha1Digest romDigest;
+    uint32_t localNonce;
+    uint32_t remoteNonce;
+    bool hasRemoteHello;
+    bool isConnected;
+    uint64_t lastReceiveTime;
+
+    void sendHello();
+    bool handleHello(const uint8_t* packet, int size); // False if the other side cannot play with this one
+
+public:
+    NetplayPeer();
+
+    // The remote may be the other peer or a relay that forwards to it
+    bool open(uint16_t localPort, const UdpEndpoint& remoteEndpoint, const Sha1Digest& digest);
+
+    [[nodiscard]] uint16_t getPort() const {
+        return socket.getPort();
+    }
+
+    // Exchanges hellos until both sides have heard of each other. False on a timeout, another ROM or protocol version
+    bool connect(int timeoutMs);
+
+    // Random generator seed, the same on both sides once connected
+    [[nodiscard]] uint32_t getSeed() const {
+        return localNonce ^ remoteNonce;
+    }
+
+    void sendInputs(const NetplayInputs& inputs);
+
+    // Next input packet that arrived, hellos in between are answered. False once none is waiting
+    bool receiveInputs(NetplayInputs& inputs);
+
+    // InputHandler::now of the last packet from the remote
+    [[nodiscard]] uint64_t getLastReceiveTime() const {
+        return lastReceiveTime;
+    }
+};
+
+#endif
@@ -0,0 +1,143 @@
+#ifndef CHIP8_EMULATOR_ROLLBACK_SESSION_H
+#define CHIP8_EMULATOR_ROLLBACK_SESSION_H
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <vector>
+#include "netplay_peer.h"
+#include "../extras/input_handler.h"
+
+constexpr int MAX_PREDICTION_FRAMES{8}; // Frames a peer runs past the last remote input it has, and so the deepest rollback
+constexpr int INPUT_HISTORY{MAX_INPUTS_PER_PACKET}; // Covers every local input the other side can still be missing
+static_assert(MAX_PREDICTION_FRAMES * 2 < INPUT_HISTORY, "Unacknowledged inputs must fit in one packet");
+
+// Two player rollback on one Chip8 or SChip core. Every frame runs on the local keys ORed with the remote ones,
+// remote keys that have not arrived yet are predicted to stay as they last were. When they arrive different,
+// the core is loaded from the snapshot before the first frame that guessed wrong and runs those frames again
+// The session owns the core's InputHandler and sets it once per frame, the core has to be seeded and loaded the same
+// way on both sides, and is meant to draw to a plain framebuffer that is presented after advance
+template<typename Core>
+class RollbackSession {
+private:
+    Core& core;
+    InputHandler& inputHandler;
+    std::vector<typename Core::Snapshot> snapshots; // Start of frame f at f % MAX_PREDICTION_FRAMES
+    std::array<uint16_t, INPUT_HISTORY> localInputs;
+    std::array<uint16_t, INPUT_HISTORY> remoteInputs; // Predicted until the frame is confirmed
+    uint32_t frame;          // Next frame to run
+    uint32_t confirmedFrame; // Remote inputs of every earlier frame have arrived
+    uint32_t remoteAck;      // The remote has every local input before this frame
+    uint32_t rollbackFrame;  // First frame that ran on a wrong prediction, frame if none did
+    uint64_t rollbackCount;
+    uint64_t resimulatedCount;
+
+    // Frames that ran confirmed are never rolled back to, so they are not snapshotted
+    bool runFrame(uint32_t index) {
+        if (index >= confirmedFrame) {
+            core.saveSnapshot(snapshots[index % MAX_PREDICTION_FRAMES]);
+            remoteInputs[index % INPUT_HISTORY] = confirmedFrame > 0 ? remoteInputs[(confirmedFrame - 1) % INPUT_HISTORY] : 0;
+        }
+        inputHandler.setKeyState(localInputs[index % INPUT_HISTORY] | remoteInputs[index % INPUT_HISTORY]);
+        return core.runFrames(1);
+    }
+
+public:
+    RollbackSession(Core& core, InputHandler& inputHandler): core{core}, inputHandler{inputHandler},
+        snapshots(MAX_PREDICTION_FRAMES), localInputs{}, remoteInputs{}, frame{}, confirmedFrame{}, remoteAck{},
+        rollbackFrame{}, rollbackCount{}, resimulatedCount{} {}
+
+    // Inputs have to arrive in frame order, anything after a gap is dropped until a later packet repeats the gap
+    void addRemoteInput(uint32_t index, uint16_t keys) {
+        // A remote more than a packet ahead is broken, its inputs would overwrite predictions still in use
+        if (index != confirmedFrame || index >= frame + INPUT_HISTORY - MAX_PREDICTION_FRAMES) {
+            return;
+        }
+
+        if (index < frame && remoteInputs[index % INPUT_HISTORY] != keys) {
+            rollbackFrame = std::min(rollbackFrame, index);
+        }
+        remoteInputs[index % INPUT_HISTORY] = keys;
+        confirmedFrame++;
+    }
+
+    // False while the remote is too far behind, rolling back further than MAX_PREDICTION_FRAMES is not possible
+    [[nodiscard]] bool canAdvance() const {
+        return frame < confirmedFrame + MAX_PREDICTION_FRAMES;
+    }
+
+    // Runs the frames that guessed the remote inputs wrong again, advance does this first. False once the ROM exits
+    bool rollBack() {
+        if (rollbackFrame >= frame) {
+            return true;
+        }
+
+        core.loadSnapshot(snapshots[rollbackFrame % MAX_PREDICTION_FRAMES]);
+        rollbackCount++;
+        resimulatedCount += frame - rollbackFrame;
+        for (uint32_t index{ rollbackFrame }; index < frame; index++) {
+            if (!runFrame(index)) {
+                return false;
+            }
+        }
+        rollbackFrame = frame;
+        return true;
+    }
+
+    // Runs the next frame on the local keys and the remote ones, predicted if need be. False once the ROM exits
+    bool advance(uint16_t localKeys) {
+        if (!rollBack()) {
+            return false;
+        }
+
+        localInputs[frame % INPUT_HISTORY] = localKeys;
+        if (!runFrame(frame)) {
+            return false;
+        }
+        frame++;
+        rollbackFrame = frame;
+        return true;
+    }
+
+    // Takes in every input packet that arrived
+    void receiveInputs(NetplayPeer& peer) {
+        NetplayInputs inputs{};
+        while (peer.receiveInputs(inputs)) {
+            for (int i{}; i < inputs.count; i++) {
+                addRemoteInput(inputs.firstFrame + i, inputs.masks[i]);
+            }
+            remoteAck = std::clamp(inputs.ack, remoteAck, frame);
+        }
+    }
+
+    // Sends every local input the remote has not acknowledged, an empty packet still carries the acknowledgement
+    void sendInputs(NetplayPeer& peer) const {
+        NetplayInputs inputs{};
+        inputs.ack = confirmedFrame;
+        inputs.firstFrame = std::max(remoteAck, frame - std::min<uint32_t>(frame, INPUT_HISTORY));
+        inputs.count = (int) (frame - inputs.firstFrame);
+        for (int i{}; i < inputs.count; i++) {
+            inputs.masks[i] = localInputs[(inputs.firstFrame + i) % INPUT_HISTORY];
+        }
+        peer.sendInputs(inputs);
+    }
+
+    [[nodiscard]] uint32_t getFrame() const {
+        return frame;
+    }
+
+    [[nodiscard]] uint32_t getConfirmedFrame() const {
+        return confirmedFrame;
+    }
+
+    // Rollbacks so far and the frames they ran again
+    [[nodiscard]] uint64_t getRollbackCount() const {
+        return rollbackCount;
+    }
+
+    [[nodiscard]] uint64_t getResimulatedCount() const {
+        return resimulatedCount;
+    }
+};
+
+#endif
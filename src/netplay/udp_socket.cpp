@@ -0,0 +1,90 @@
+#include <cstdio>
+#include <cstdlib>
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#include "udp_socket.h"
+
+bool parseEndpoint(const std::string& text, UdpEndpoint& endpoint) {
+    size_t colon{ text.rfind(':') };
+    if (colon == std::string::npos) {
+        return false;
+    }
+
+    std::string host{ text.substr(0, colon) };
+    in_addr address{};
+    if (host == "localhost") {
+        address.s_addr = htonl(INADDR_LOOPBACK);
+    } else if (inet_pton(AF_INET, host.c_str(), &address) != 1) {
+        return false;
+    }
+
+    const char* portText{ text.c_str() + colon + 1 };
+    char* end;
+    long port{ strtol(portText, &end, 10) };
+    if (end == portText || *end != '\0' || port < 1 || port > 65535) {
+        return false;
+    }
+
+    endpoint.address = ntohl(address.s_addr);
+    endpoint.port = (uint16_t) port;
+    return true;
+}
+
+UdpSocket::~UdpSocket() {
+    if (socketFd >= 0) {
+        close(socketFd);
+    }
+}
+
+bool UdpSocket::open(uint16_t localPort) {
+    socketFd = socket(AF_INET, SOCK_DGRAM, 0);
+    if (socketFd < 0) {
+        printf("Error: Could not create a UDP socket\n");
+        return false;
+    }
+
+    sockaddr_in address{};
+    address.sin_family = AF_INET;
+    address.sin_addr.s_addr = htonl(INADDR_ANY);
+    address.sin_port = htons(localPort);
+    socklen_t addressSize{ sizeof(address) };
+    if (bind(socketFd, reinterpret_cast<sockaddr*>(&address), addressSize) < 0 ||
+        getsockname(socketFd, reinterpret_cast<sockaddr*>(&address), &addressSize) < 0) {
+        printf("Error: Could not bind UDP port %d\n", localPort);
+        close(socketFd);
+        socketFd = -1;
+        return false;
+    }
+
+    port = ntohs(address.sin_port);
+    return true;
+}
+
+bool UdpSocket::sendTo(const UdpEndpoint& to, const uint8_t* data, size_t size) {
+    sockaddr_in address{};
+    address.sin_family = AF_INET;
+    address.sin_addr.s_addr = htonl(to.address);
+    address.sin_port = htons(to.port);
+    return sendto(socketFd, data, size, 0, reinterpret_cast<sockaddr*>(&address), sizeof(address)) == (ssize_t) size;
+}
+
+int UdpSocket::receiveFrom(uint8_t* buffer, size_t size, UdpEndpoint& from) {
+    sockaddr_in address{};
+    socklen_t addressSize{ sizeof(address) };
+    ssize_t received{ recvfrom(socketFd, buffer, size, MSG_DONTWAIT, reinterpret_cast<sockaddr*>(&address), &addressSize) };
+    if (received < 0) {
+        return -1;
+    }
+
+    from.address = ntohl(address.sin_addr.s_addr);
+    from.port = ntohs(address.sin_port);
+    return (int) received;
+}
+
+bool UdpSocket::waitForData(int timeoutMs) {
+    pollfd socketPoll{ socketFd, POLLIN, 0 };
+    return poll(&socketPoll, 1, timeoutMs) > 0;
+}
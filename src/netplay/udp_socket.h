@@ -0,0 +1,50 @@
+#ifndef CHIP8_EMULATOR_UDP_SOCKET_H
+#define CHIP8_EMULATOR_UDP_SOCKET_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+// IPv4 address and port, both in host byte order
+struct UdpEndpoint {
+    uint32_t address;
+    uint16_t port;
+
+    bool operator==(const UdpEndpoint& other) const {
+        return address == other.address && port == other.port;
+    }
+};
+
+// host:port, where host is a dotted IPv4 address or localhost
+bool parseEndpoint(const std::string& text, UdpEndpoint& endpoint);
+
+// Non blocking UDP socket bound to every interface
+class UdpSocket {
+private:
+    int socketFd;
+    uint16_t port;
+
+public:
+    UdpSocket(): socketFd{-1}, port{} {}
+    ~UdpSocket();
+
+    UdpSocket(const UdpSocket&) = delete;
+    UdpSocket& operator=(const UdpSocket&) = delete;
+
+    // 0 picks a free port, see getPort
+    bool open(uint16_t localPort);
+
+    [[nodiscard]] uint16_t getPort() const {
+        return port;
+    }
+
+    bool sendTo(const UdpEndpoint& to, const uint8_t* data, size_t size);
+
+    // Size of the datagram written to buffer, -1 if none is waiting. Longer datagrams are cut off at size
+    int receiveFrom(uint8_t* buffer, size_t size, UdpEndpoint& from);
+
+    // Blocks until a datagram is waiting or timeoutMs passes, returns whether one is
+    bool waitForData(int timeoutMs);
+};
+
+#endif
@@ -0,0 +1,127 @@
+#ifndef CHIP8_EMULATOR_EMULATOR_POOL_H
+#define CHIP8_EMULATOR_EMULATOR_POOL_H
+
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <thread>
+#include <type_traits>
+#include <vector>
+#include "../displays/advanced_display.h"
+#include "../displays/simple_display.h"
+#include "../emulators/chip8.h"
+#include "../emulators/rom_image.h"
+#include "../emulators/schip.h"
+#include "../extras/input_handler.h"
+#include "../extras/thread_pool.h"
+
+// N headless instances of one ROM, stepped one frame at a time on a thread pool
+// Meant for search and learning agents: reset, then step(actions) and read the framebuffers
+template<typename Core, typename Display>
+class EmulatorPool {
+private:
+    int count;
+    RomImage romImage;
+    bool isRomLoaded;
+    uint32_t seed; // Instance i is seeded with seed + i on every reset
+
+    // Structure of arrays, index i of every member belongs to instance i
+    // Framebuffers are one contiguous block so observations need no gather
+    std::vector<uint8_t> ownedFramebuffers;
+    uint8_t* framebuffers;
+    std::deque<Display> displays;
+    std::deque<InputHandler> inputHandlers;
+    std::vector<std::unique_ptr<Core>> cores;
+    std::vector<uint8_t> isDone;
+
+    ThreadPool threadPool;
+
+    // Cores are built once, a reset restores the ROM image in place without allocating or reseeding from the OS
+    void resetInstance(int i) {
+        cores[i]->reset(romImage, seed + (uint32_t) i);
+        inputHandlers[i].setKeyState(0);
+        isDone[i] = !isRomLoaded;
+    }
+
+public:
+    static constexpr int FRAMEBUFFER_SIZE{Display::BUFFER_SIZE};
+
+    // If framebuffers is given it must hold count * FRAMEBUFFER_SIZE bytes, the instances render straight into it
+    EmulatorPool(int count, const std::vector<uint8_t>& rom, uint8_t* framebuffers = nullptr,
+                 int threadCount = (int) std::thread::hardware_concurrency())
+        : count{count}, isRomLoaded{ Core::buildRomImage(rom.data(), rom.size(), romImage) }, seed{},
+        framebuffers{framebuffers}, cores(count), isDone(count), threadPool{threadCount > 0 ? threadCount : 1}
+    {
+        if (this->framebuffers == nullptr) {
+            ownedFramebuffers.resize((size_t) count * FRAMEBUFFER_SIZE);
+            this->framebuffers = ownedFramebuffers.data();
+        }
+
+        for (int i{}; i < count; i++) {
+            displays.emplace_back(this->framebuffers + (size_t) i * FRAMEBUFFER_SIZE);
+            inputHandlers.emplace_back();
+            if constexpr (std::is_same_v<Core, Chip8>) {
+                cores[i] = std::make_unique<Core>(displays[i], inputHandlers[i], MODERN_CHIP8_QUIRKS);
+            } else {
+                cores[i] = std::make_unique<Core>(displays[i], inputHandlers[i]);
+            }
+        }
+
+        reset();
+    }
+
+    [[nodiscard]] int size() const {
+        return count;
+    }
+
+    void reset() {
+        threadPool.parallelFor(count, [this](int begin, int end) {
+            for (int i{begin}; i < end; i++) {
+                resetInstance(i);
+            }
+        });
+    }
+
+    void reset(int i) {
+        resetInstance(i);
+    }
+
+    // Base of the random seeds used from the next reset on
+    void setSeed(uint32_t baseSeed) {
+        seed = baseSeed;
+    }
+
+    // actions[i] is the keypad of instance i, bit N held == key N held for the whole step
+    // Instances whose ROM has exited are left untouched until they are reset
+    void step(const uint16_t* actions, int frameCount = 1) {
+        threadPool.parallelFor(count, [this, actions, frameCount](int begin, int end) {
+            for (int i{begin}; i < end; i++) {
+                if (isDone[i]) {
+                    continue;
+                }
+
+                inputHandlers[i].setKeyState(actions[i]);
+                isDone[i] = !cores[i]->runFrames(frameCount);
+            }
+        });
+    }
+
+    // Row major framebuffer of instance i, one byte per pixel, valid until the next step
+    [[nodiscard]] const uint8_t* observe(int i) const {
+        return framebuffers + (size_t) i * FRAMEBUFFER_SIZE;
+    }
+
+    // Every framebuffer back to back
+    [[nodiscard]] const uint8_t* observe() const {
+        return framebuffers;
+    }
+
+    [[nodiscard]] bool isInstanceDone(int i) const {
+        return isDone[i];
+    }
+};
+
+using Chip8Pool = EmulatorPool<Chip8, SimpleDisplay>;
+using SChipPool = EmulatorPool<SChip, AdvancedDisplay>;
+
+#endif
@@ -0,0 +1,116 @@
+#include "emulator_scheduler.h"
+
+EmulatorScheduler::EmulatorScheduler(int threadCount, bool isPaced)
+    : isPaced{isPaced}, activeCount{}, isStopping{}
+{
+    for (int i{}; i < (threadCount > 0 ? threadCount : 1); i++) {
+        workers.emplace_back(&EmulatorScheduler::work, this);
+    }
+}
+
+EmulatorScheduler::~EmulatorScheduler() {
+    stop();
+}
+
+int EmulatorScheduler::add(Emulator& emulator, int frameCount) {
+    int id;
+    {
+        std::lock_guard<std::mutex> lock{mutex};
+        id = (int) instances.size();
+        Clock::time_point now{ Clock::now() };
+        instances.push_back(Instance{ &emulator, frameCount, now, frameCount == 0 });
+        if (frameCount > 0) {
+            activeCount++;
+            due.emplace(now, id);
+        } else if (frameCount < 0) {
+            due.emplace(now, id);
+        }
+    }
+    dueCondition.notify_one();
+    return id;
+}
+
+void EmulatorScheduler::wait() {
+    std::unique_lock<std::mutex> lock{mutex};
+    doneCondition.wait(lock, [this]() { return activeCount == 0 || isStopping; });
+}
+
+void EmulatorScheduler::stop() {
+    {
+        std::lock_guard<std::mutex> lock{mutex};
+        isStopping = true;
+    }
+    dueCondition.notify_all();
+    doneCondition.notify_all();
+
+    for (auto& worker : workers) {
+        if (worker.joinable()) {
+            worker.join();
+        }
+    }
+}
+
+bool EmulatorScheduler::isDone(int id) {
+    std::lock_guard<std::mutex> lock{mutex};
+    return instances[id].isDone;
+}
+
+void EmulatorScheduler::work() {
+    const Clock::duration period{ std::chrono::nanoseconds(FRAME_DURATION_NS) };
+
+    std::unique_lock<std::mutex> lock{mutex};
+    while (!isStopping) {
+        if (due.empty()) {
+            dueCondition.wait(lock);
+            continue;
+        }
+
+        Entry next{ due.top() };
+        if (isPaced && next.first > Clock::now()) {
+            dueCondition.wait_until(lock, next.first);
+            continue;
+        }
+        due.pop();
+
+        Instance& instance{ instances[next.second] };
+        lock.unlock();
+        StepResult result{ instance.emulator->step() };
+        lock.lock();
+
+        Clock::time_point now{ Clock::now() };
+        Clock::time_point time;
+        switch (result) {
+            case StepResult::FRAME:
+                if (instance.framesLeft > 0 && --instance.framesLeft == 0) {
+                    instance.isDone = true;
+                    break;
+                }
+
+                // Instances that fell more than a frame behind drop the frames they missed
+                instance.nextFrame += period;
+                if (isPaced && instance.nextFrame < now - period) {
+                    instance.nextFrame = now;
+                }
+                time = instance.nextFrame;
+                break;
+            case StepResult::KEY_WAIT:
+                // The rest of the frame runs at the end of its time slot, or as soon as the others had a turn
+                time = instance.nextFrame + period;
+                break;
+            case StepResult::STOPPED:
+                time = now + period;
+                break;
+            case StepResult::EXITED:
+                instance.isDone = true;
+                break;
+        }
+
+        if (!instance.isDone) {
+            due.emplace(time, next.second);
+            dueCondition.notify_one();
+        } else if (instance.framesLeft >= 0) {
+            activeCount--;
+            doneCondition.notify_all();
+        }
+    }
+}
@@ -0,0 +1,66 @@
+#ifndef CHIP8_EMULATOR_EMULATOR_SCHEDULER_H
+#define CHIP8_EMULATOR_EMULATOR_SCHEDULER_H
+
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <mutex>
+#include <queue>
+#include <thread>
+#include <utility>
+#include <vector>
+#include "../constants.h"
+#include "../emulators/emulator.h"
+
+// Many emulators on a few threads, each stepped cooperatively with Emulator::step
+// Paced instances run their frames 60 times a second like the windowed run loop, a frame whose FX0A waits is
+// finished at the end of its time slot. Unpaced instances run back to back, for batch tools
+class EmulatorScheduler {
+private:
+    using Clock = std::chrono::steady_clock;
+
+    struct Instance {
+        Emulator* emulator;
+        int framesLeft;          // -1 if the instance runs until the ROM exits or the scheduler stops
+        Clock::time_point nextFrame;
+        bool isDone;
+    };
+
+    bool isPaced;
+    std::deque<Instance> instances; // Stays in place while workers step it
+    std::vector<std::thread> workers;
+
+    // Instances waiting for their turn by due time, each is either in here or being stepped by one worker
+    // Everything below is guarded by mutex, a core itself only by being out of the queue
+    using Entry = std::pair<Clock::time_point, int>;
+    std::priority_queue<Entry, std::vector<Entry>, std::greater<>> due;
+    std::mutex mutex;
+    std::condition_variable dueCondition;
+    std::condition_variable doneCondition;
+    int activeCount; // Instances with a frame count that are not done
+    bool isStopping;
+
+    void work();
+
+public:
+    explicit EmulatorScheduler(int threadCount, bool isPaced = true);
+    ~EmulatorScheduler();
+
+    EmulatorScheduler(const EmulatorScheduler&) = delete;
+    EmulatorScheduler& operator=(const EmulatorScheduler&) = delete;
+
+    // Starts stepping a core that has its ROM loaded, for frameCount frames or until it exits if -1
+    // The core belongs to the scheduler threads until it is done or the scheduler is stopped
+    int add(Emulator& emulator, int frameCount = -1);
+
+    // Blocks until every instance with a frame count has run it or exited
+    void wait();
+
+    // Returns once no instance is being stepped, instances are left mid run
+    void stop();
+
+    [[nodiscard]] bool isDone(int id);
+};
+
+#endif
@@ -0,0 +1,100 @@
+#include <catch2/catch_test_macros.hpp>
+#include <fstream>
+#include <iterator>
+#include <memory>
+#include "../src/displays/simple_display.h"
+#include "../src/emulators/batched_chip8.h"
+#include "../src/emulators/chip8.h"
+
+// Differential test: every lane of BatchedChip8 must match a scalar Chip8 fed the same input
+
+class ScalarChip8 : public Chip8 {
+public:
+    ScalarChip8(SimpleDisplay& display, InputHandler& handler, bool isOlder)
+        : Chip8(display, handler, isOlder ? COSMAC_VIP_QUIRKS : MODERN_CHIP8_QUIRKS) {}
+
+    uint16_t getPC() { return program_counter; }
+    uint16_t getIndex() { return index_register; }
+    uint8_t getDelayTimer() { return delay_timer; }
+    uint8_t getSoundTimer() { return sound_timer; }
+    std::vector<uint8_t>& getRegisters() { return registers; }
+    PagedMemory& getMemory() { return memory; }
+};
+
+static std::vector<uint8_t> readRom(const std::string& name) {
+    std::ifstream input{ std::string(TEST_ROMS_DIR) + "/" + name, std::ios::binary };
+    REQUIRE(input.is_open());
+    return { std::istreambuf_iterator<char>(input), std::istreambuf_iterator<char>() };
+}
+
+// Lanes share a ROM but get different keys and seeds, so they split apart and meet again
+static uint16_t laneKeys(int lane, int frame) {
+    return (frame / (lane + 3)) % 4 == 0 ? (uint16_t) (1 << ((lane * 5 + frame / 16) % 16)) : 0;
+}
+
+template<int N>
+static void compareWithScalar(const std::string& name, bool isOlder, int frames) {
+    std::vector<uint8_t> rom{ readRom(name) };
+
+    auto batched{ std::make_unique<BatchedChip8<N>>(isOlder) };
+    REQUIRE(batched->loadRom(rom.data(), rom.size()));
+
+    std::vector<std::unique_ptr<SimpleDisplay>> displays;
+    std::vector<std::unique_ptr<InputHandler>> inputHandlers;
+    std::vector<std::unique_ptr<ScalarChip8>> cores;
+    std::vector<bool> isDone(N);
+    for (int lane{}; lane < N; lane++) {
+        displays.push_back(std::make_unique<SimpleDisplay>());
+        inputHandlers.push_back(std::make_unique<InputHandler>());
+        cores.push_back(std::make_unique<ScalarChip8>(*displays[lane], *inputHandlers[lane], isOlder));
+        REQUIRE(cores[lane]->loadRom(rom.data(), rom.size()));
+
+        cores[lane]->seedRandom(lane * 7919 + 1);
+        batched->seedRandom(lane, lane * 7919 + 1);
+    }
+
+    uint8_t scalarMemory[RAM_SIZE];
+    for (int frame{}; frame < frames; frame++) {
+        for (int lane{}; lane < N; lane++) {
+            inputHandlers[lane]->setKeyState(laneKeys(lane, frame));
+            batched->setKeyState(lane, laneKeys(lane, frame));
+            if (!isDone[lane]) {
+                isDone[lane] = !cores[lane]->runFrames(1);
+            }
+        }
+        batched->runFrame();
+
+        for (int lane{}; lane < N; lane++) {
+            INFO(name << " frame " << frame << " lane " << lane);
+            REQUIRE(batched->isLaneDone(lane) == isDone[lane]);
+            REQUIRE(batched->getPC(lane) == cores[lane]->getPC());
+            REQUIRE(batched->getIndex(lane) == cores[lane]->getIndex());
+            REQUIRE(batched->getDelayTimer(lane) == cores[lane]->getDelayTimer());
+            REQUIRE(batched->getSoundTimer(lane) == cores[lane]->getSoundTimer());
+            for (int x{}; x < 16; x++) {
+                REQUIRE(batched->getRegister(lane, x) == cores[lane]->getRegisters()[x]);
+            }
+            cores[lane]->getMemory().copyTo(scalarMemory);
+            REQUIRE(memcmp(batched->getMemory(lane), scalarMemory, RAM_SIZE) == 0);
+            REQUIRE(memcmp(batched->getPixels(lane), displays[lane]->getPixels(), SimpleDisplay::BUFFER_SIZE) == 0);
+        }
+    }
+
+    // Same ROM and mostly the same input, so most steps should have stayed in lockstep
+    REQUIRE(batched->getVectorSteps() > 0);
+}
+
+TEST_CASE("Batched Chip8 Matches Scalar Test ROMs") {
+    compareWithScalar<8>("1-chip8-logo.ch8", true, 60);
+    compareWithScalar<8>("3-corax+.ch8", true, 120);
+    compareWithScalar<8>("4-flags.ch8", true, 120);
+    compareWithScalar<8>("5-quirks.ch8", true, 300);
+    compareWithScalar<16>("5-quirks.ch8", false, 300);
+}
+
+TEST_CASE("Batched Chip8 Matches Scalar Games") {
+    compareWithScalar<8>("snake.ch8", false, 600);
+    compareWithScalar<16>("br8kout.ch8", false, 600);
+    compareWithScalar<8>("Tetris.ch8", true, 600);
+    compareWithScalar<16>("Airplane.ch8", true, 600);
+}
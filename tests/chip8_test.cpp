@@ -1,4 +1,10 @@
 #include <catch2/catch_test_macros.hpp>
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <iterator>
+#include <string>
+#include <thread>
 #include "../src/displays/simple_display.h"
 #include "../src/emulators/chip8.h"
 
@@ -15,18 +21,17 @@ public:
 
 class Chip8Test : public Chip8 {
 public:
-    explicit Chip8Test(SimpleDisplay& display, TestInputHandler& handler): Chip8(display, handler, true) {
+    explicit Chip8Test(SimpleDisplay& display, TestInputHandler& handler): Chip8(display, handler, COSMAC_VIP_QUIRKS) {
     }
 
-    void decodeTest(uint16_t ins) {
-        Chip8::decode(ins);
+    Chip8Test(const Chip8Test& other, SimpleDisplay& display, TestInputHandler& handler): Chip8(other, display, handler) {
     }
 
-    void decodeSpriteDataTest(uint16_t position, std::vector<bool>& v) {
-        Chip8::decodeSpriteData(position, v);
+    void decodeTest(uint16_t ins) {
+        Chip8::decode(ins);
     }
 
-    uint8_t* getMemory() {
+    PagedMemory& getMemory() {
         return memory;
     }
 
@@ -56,7 +61,7 @@ TEST_CASE("Font Loaded Correctly", "") {
     SimpleDisplay display{};
     Chip8Test chip8{display, inputHandler};
 
-    uint8_t* mem{chip8.getMemory()};
+    PagedMemory& mem{chip8.getMemory()};
     int count{};
 
     for (int i{0x50}; i <= 0x9F; i++) {
@@ -67,27 +72,6 @@ TEST_CASE("Font Loaded Correctly", "") {
     REQUIRE(count == 80);
 }
 
-TEST_CASE("Correct Helper Function", "") {
-    TestInputHandler inputHandler{};
-    SimpleDisplay display{};
-    Chip8Test chip8{display, inputHandler};
-
-    std::vector<bool> v(8);
-
-    // Point index_register to 0
-    chip8.decodeTest(0xA050);
-
-    chip8.decodeSpriteDataTest(chip8.getIndex(), v);
-
-    for (int i{}; i < 4; i++) {
-        REQUIRE(v[i]);
-    }
-
-    for (int i{4}; i < 8; i++) {
-        REQUIRE(!v[i]);
-    }
-}
-
 TEST_CASE("Registers Do Not Overflow") {
     TestInputHandler inputHandler{};
     SimpleDisplay display{};
@@ -198,7 +182,7 @@ TEST_CASE("Correct Instruction Decode", "") {
         // Check if all pixel are white
         for (int i{}; i < WIDTH; i++) {
             for (int j{}; j < HEIGHT; j++) {
-                REQUIRE(display.getArrayDisplay()[i][j] == 1);
+                REQUIRE(display.getPixel(i, j) == 1);
             }
         }
 
@@ -207,7 +191,7 @@ TEST_CASE("Correct Instruction Decode", "") {
         // Check if all pixel are black (e.g. screen is cleared)
         for (int i{}; i < WIDTH; i++) {
             for (int j{}; j < HEIGHT; j++) {
-                REQUIRE(display.getArrayDisplay()[i][j] == 0);
+                REQUIRE(display.getPixel(i, j) == 0);
             }
         }
     }
@@ -228,6 +212,25 @@ TEST_CASE("Correct Instruction Decode", "") {
         REQUIRE(chip8.getPC() == 0x0200);
     }
 
+    SECTION("Stack Wraps Around Instead Of Overrunning") {
+        // A return with nothing on the stack takes whatever the slot below holds
+        chip8.decodeTest(0x00EE);
+        REQUIRE(chip8.getPC() == 0x0000);
+        REQUIRE(chip8.getDebugRegisters().sp == 0xFF);
+        chip8.decodeTest(0x2300);
+        REQUIRE(chip8.getDebugRegisters().sp == 0);
+
+        // Seventeen calls deep the first return address is overwritten, the last sixteen still come back in order
+        for (int i{}; i <= STACK_SIZE; i++) {
+            chip8.decodeTest((uint16_t) (0x2400 + i * 2));
+        }
+        for (int i{STACK_SIZE}; i > 0; i--) {
+            chip8.decodeTest(0x00EE);
+            REQUIRE(chip8.getPC() == 0x400 + (i - 1) * 2);
+        }
+        REQUIRE(chip8.getDebugRegisters().sp == 1);
+    }
+
     SECTION("Correct 1 Instructions") {
         chip8.decodeTest(0x1234);
         REQUIRE(chip8.getPC() == 0x0234);
@@ -353,23 +356,23 @@ TEST_CASE("Correct Instruction Decode", "") {
 
         // Checking 0 has been drawn correctly
         for (int i{}; i < 4; i++) {
-            REQUIRE(display.getArrayDisplay()[i][0] == 1);
+            REQUIRE(display.getPixel(i, 0) == 1);
         }
 
         for (int i{1}; i < 4; i++) {
-            REQUIRE(display.getArrayDisplay()[0][i] == 1);
-            REQUIRE(display.getArrayDisplay()[1][i] == 0);
-            REQUIRE(display.getArrayDisplay()[2][i] == 0);
-            REQUIRE(display.getArrayDisplay()[3][i] == 1);
+            REQUIRE(display.getPixel(0, i) == 1);
+            REQUIRE(display.getPixel(1, i) == 0);
+            REQUIRE(display.getPixel(2, i) == 0);
+            REQUIRE(display.getPixel(3, i) == 1);
         }
 
         for (int i{}; i < 4; i++) {
-            REQUIRE(display.getArrayDisplay()[i][4] == 1);
+            REQUIRE(display.getPixel(i, 4) == 1);
         }
 
         for (int i{0}; i < 4; i++) {
             for (int j{}; j < 5; j++) {
-                REQUIRE(display.getArrayDisplay()[i + 4][j] == 0);
+                REQUIRE(display.getPixel(i + 4, j) == 0);
             }
         }
 
@@ -385,20 +388,20 @@ TEST_CASE("Correct Instruction Decode", "") {
         chip8.decodeTest(0xD013);
 
         // Checking 0 has been drawn correctly
-        REQUIRE(display.getArrayDisplay()[62][0] == 1);
-        REQUIRE(display.getArrayDisplay()[63][0] == 1);
+        REQUIRE(display.getPixel(62, 0) == 1);
+        REQUIRE(display.getPixel(63, 0) == 1);
 
-        REQUIRE(display.getArrayDisplay()[62][1] == 1);
-        REQUIRE(display.getArrayDisplay()[63][1] == 0);
+        REQUIRE(display.getPixel(62, 1) == 1);
+        REQUIRE(display.getPixel(63, 1) == 0);
 
-        REQUIRE(display.getArrayDisplay()[62][2] == 1);
-        REQUIRE(display.getArrayDisplay()[63][2] == 0);
+        REQUIRE(display.getPixel(62, 2) == 1);
+        REQUIRE(display.getPixel(63, 2) == 0);
 
-        REQUIRE(display.getArrayDisplay()[62][3] == 0);
-        REQUIRE(display.getArrayDisplay()[63][3] == 0);
+        REQUIRE(display.getPixel(62, 3) == 0);
+        REQUIRE(display.getPixel(63, 3) == 0);
 
-        REQUIRE(display.getArrayDisplay()[62][4] == 0);
-        REQUIRE(display.getArrayDisplay()[63][4] == 0);
+        REQUIRE(display.getPixel(62, 4) == 0);
+        REQUIRE(display.getPixel(63, 4) == 0);
 
 
 
@@ -414,7 +417,7 @@ TEST_CASE("Correct Instruction Decode", "") {
         // Checking 0 is flipped back to blank
         for (int i{}; i < 8; i++) {
             for (int j{}; j < 5; j++) {
-                REQUIRE(display.getArrayDisplay()[i][j] == 0);
+                REQUIRE(display.getPixel(i, j) == 0);
             }
         }
 
@@ -437,6 +440,15 @@ TEST_CASE("Correct Instruction Decode", "") {
         inputHandler.setKey(1);
         chip8.decodeTest(0xE191);
         REQUIRE(chip8.getPC() == 0x204);
+
+        // Only the low nibble of VX names the key
+        chip8.decodeTest(0x62F5);
+        chip8.decodeTest(0xE29E);
+        REQUIRE(chip8.getPC() == 0x204);
+
+        inputHandler.setKey(5);
+        chip8.decodeTest(0xE29E);
+        REQUIRE(chip8.getPC() == 0x206);
     }
 
     SECTION("Correct F Instructions") {
@@ -457,7 +469,22 @@ TEST_CASE("Correct Instruction Decode", "") {
         chip8.decodeTest(0xF01E);
         REQUIRE(chip8.getIndex() == 0x23);
 
-        // FX0A Not Tested
+        // FX0A rewinds the program counter until a key is pressed and released
+        uint16_t pc{ chip8.getPC() };
+        chip8.decodeTest(0xF30A);
+        REQUIRE(chip8.getPC() == pc - 2);
+
+        inputHandler.setKey(0xB);
+        chip8.decodeTest(0xF30A);
+        REQUIRE(chip8.getRegisters()[3] == 0xB);
+        REQUIRE(chip8.getPC() == pc - 4);
+
+        chip8.decodeTest(0xF30A);
+        REQUIRE(chip8.getPC() == pc - 6);
+
+        inputHandler.setKeyState(0);
+        chip8.decodeTest(0xF30A);
+        REQUIRE(chip8.getPC() == pc - 6);
 
         // FX29
         chip8.decodeTest(0x6F0F);
@@ -497,4 +524,779 @@ TEST_CASE("Correct Instruction Decode", "") {
         REQUIRE(chip8.getRegisters()[2] == 5);
         REQUIRE(chip8.getIndex() == 3);
     }
-}
\ No newline at end of file
+}
+
+TEST_CASE("Queued Input Applied At Instruction Boundaries", "") {
+    TestInputHandler inputHandler{};
+
+    inputHandler.pushEvent(InputEvent{ 100, 0x5, true });
+    inputHandler.pushEvent(InputEvent{ 200, 0x5, false });
+    inputHandler.pushEvent(InputEvent{ 300, 0xA, true });
+
+    // Nothing is applied before its timestamp
+    inputHandler.applyEvents(50);
+    REQUIRE(inputHandler.getKeyBeingPressed() == -1);
+
+    inputHandler.applyEvents(150);
+    REQUIRE(inputHandler.isKeyPressed(0x5));
+
+    // A tap shorter than one instruction is still released in order
+    inputHandler.applyEvents(250);
+    REQUIRE(!inputHandler.isKeyPressed(0x5));
+    REQUIRE(inputHandler.getKeyBeingPressed() == -1);
+
+    inputHandler.applyEvents(1000);
+    REQUIRE(inputHandler.getKeyBeingPressed() == 0xA);
+}
+
+TEST_CASE("Full Input Queue Keeps The Latest Key State", "") {
+    TestInputHandler inputHandler{};
+
+    // Fill the queue with taps of key 3 while the emulator thread is stalled
+    for (uint64_t i{}; i < 255; i++) {
+        inputHandler.pushEvent(InputEvent{ i, 0x3, i % 2 == 0 });
+    }
+
+    // None of these fit, key 5 is released last and key 7 stays held
+    inputHandler.pushEvent(InputEvent{ 300, 0x5, true });
+    inputHandler.pushEvent(InputEvent{ 301, 0x7, true });
+    inputHandler.pushEvent(InputEvent{ 302, 0x5, false });
+
+    // Overflowed state is never applied ahead of the events still queued
+    inputHandler.applyEvents(100);
+    REQUIRE(inputHandler.isKeyPressed(0x3));
+    REQUIRE(!inputHandler.isKeyPressed(0x7));
+
+    inputHandler.applyEvents(UINT64_MAX);
+    REQUIRE(inputHandler.isKeyPressed(0x3));
+    REQUIRE(!inputHandler.isKeyPressed(0x5));
+    REQUIRE(inputHandler.isKeyPressed(0x7));
+    REQUIRE(inputHandler.getNextEventTime() == UINT64_MAX);
+
+    // Once applied the queue is used again
+    inputHandler.pushEvent(InputEvent{ 400, 0x3, false });
+    inputHandler.pushEvent(InputEvent{ 401, 0x7, false });
+    REQUIRE(inputHandler.getNextEventTime() == 400);
+    inputHandler.applyEvents(UINT64_MAX);
+    REQUIRE(inputHandler.getKeyBeingPressed() == -1);
+}
+
+TEST_CASE("Fork Shares Memory Until Written", "") {
+    TestInputHandler inputHandler{};
+    SimpleDisplay display{};
+    Chip8Test chip8{display, inputHandler};
+
+    // Draw the 0 glyph and store 123 as BCD
+    chip8.decodeTest(0x6000);
+    chip8.decodeTest(0xA050);
+    chip8.decodeTest(0xD005);
+    chip8.decodeTest(0x617B);
+    chip8.decodeTest(0xA300);
+    chip8.decodeTest(0xF133);
+
+    TestInputHandler forkInputHandler{};
+    SimpleDisplay forkDisplay{};
+    Chip8Test fork{chip8, forkDisplay, forkInputHandler};
+
+    REQUIRE(fork.getMemory().getSharedPageCount() == PagedMemory::PAGE_COUNT);
+    REQUIRE(fork.getIndex() == 0x300);
+    REQUIRE(fork.getRegisters()[1] == 123);
+    REQUIRE(fork.getMemory()[0x301] == 2);
+    REQUIRE(memcmp(forkDisplay.getPixels(), display.getPixels(), SimpleDisplay::BUFFER_SIZE) == 0);
+
+    // A write in the fork only splits off its own page
+    fork.decodeTest(0x6199);
+    fork.decodeTest(0xA400);
+    fork.decodeTest(0xF133);
+
+    REQUIRE(fork.getMemory().getSharedPageCount() == PagedMemory::PAGE_COUNT - 1);
+    REQUIRE(fork.getMemory()[0x400] == 1);
+    REQUIRE(fork.getMemory()[0x401] == 5);
+    REQUIRE(fork.getMemory()[0x402] == 3);
+    REQUIRE(chip8.getMemory()[0x400] == 0);
+    REQUIRE(chip8.getRegisters()[1] == 123);
+    REQUIRE(chip8.getIndex() == 0x300);
+
+    // And the parent keeps writing to its own copy
+    chip8.decodeTest(0xA400);
+    chip8.decodeTest(0xF133);
+    REQUIRE(chip8.getMemory()[0x400] == 1);
+    REQUIRE(chip8.getMemory()[0x401] == 2);
+    REQUIRE(fork.getMemory()[0x401] == 5);
+}
+
+TEST_CASE("Quirk Profiles", "") {
+    TestInputHandler inputHandler{};
+    SimpleDisplay display{};
+    Chip8Test chip8{display, inputHandler};
+
+    REQUIRE(Quirks::fromFlags(XO_CHIP_QUIRKS.getFlags()).getFlags() == XO_CHIP_QUIRKS.getFlags());
+
+    Quirks quirks{};
+    REQUIRE(findQuirksProfile("schip", quirks));
+    REQUIRE(quirks.getFlags() == SCHIP_QUIRKS.getFlags());
+    REQUIRE(!findQuirksProfile("unknown", quirks));
+
+    chip8.decodeTest(0x6002);
+    chip8.decodeTest(0x6110);
+    chip8.decodeTest(0x6281);
+
+    SECTION("Jump Offset") {
+        chip8.decodeTest(0xB100);
+        REQUIRE(chip8.getPC() == 0x102);
+
+        chip8.setQuirks(MODERN_CHIP8_QUIRKS);
+        chip8.decodeTest(0xB100);
+        REQUIRE(chip8.getPC() == 0x110);
+    }
+
+    SECTION("Shift Source") {
+        chip8.decodeTest(0x8126);
+        REQUIRE(chip8.getRegisters()[1] == 0x40);
+
+        chip8.setQuirks(MODERN_CHIP8_QUIRKS);
+        chip8.decodeTest(0x8126);
+        REQUIRE(chip8.getRegisters()[1] == 0x20);
+    }
+
+    SECTION("Logic Resets VF") {
+        chip8.decodeTest(0x6F05);
+        chip8.decodeTest(0x8011);
+        REQUIRE(chip8.getRegisters()[15] == 0);
+
+        chip8.setQuirks(SCHIP_QUIRKS);
+        chip8.decodeTest(0x6F05);
+        chip8.decodeTest(0x8011);
+        REQUIRE(chip8.getRegisters()[15] == 5);
+    }
+
+    SECTION("Sprite Clipping") {
+        // Top row of the 0 glyph drawn two pixels before the right edge
+        chip8.decodeTest(0x603E);
+        chip8.decodeTest(0x6100);
+        chip8.decodeTest(0xA050);
+        chip8.decodeTest(0xD011);
+        REQUIRE(display.getPixel(62, 0));
+        REQUIRE(display.getPixel(63, 0));
+        REQUIRE(!display.getPixel(0, 0));
+
+        chip8.setQuirks(XO_CHIP_QUIRKS);
+        chip8.decodeTest(0x00E0);
+        chip8.decodeTest(0xD011);
+        REQUIRE(display.getPixel(62, 0));
+        REQUIRE(display.getPixel(0, 0));
+        REQUIRE(display.getPixel(1, 0));
+    }
+}
+
+TEST_CASE("Save State Round Trip") {
+    TestInputHandler inputHandler{};
+    SimpleDisplay display{};
+    Chip8Test chip8{display, inputHandler};
+    std::string path{ "chip8_save_state_test.bin" };
+
+    // 0 glyph at (5, 5), a return address on the stack and something in every other part of the machine
+    chip8.decodeTest(0x6005);
+    chip8.decodeTest(0xF015);
+    chip8.decodeTest(0xA050);
+    chip8.decodeTest(0xD005);
+    chip8.decodeTest(0x6A42);
+    chip8.decodeTest(0xA300);
+    chip8.decodeTest(0x2400);
+    chip8.getMemory().write(0x300, 0xAB);
+    REQUIRE(chip8.saveState(path));
+
+    TestInputHandler loadedInputHandler{};
+    SimpleDisplay loadedDisplay{};
+    Chip8Test loaded{loadedDisplay, loadedInputHandler};
+    REQUIRE(loaded.loadState(path));
+
+    REQUIRE(loaded.getRegisters() == chip8.getRegisters());
+    REQUIRE(loaded.getPC() == 0x400);
+    REQUIRE(loaded.getIndex() == 0x300);
+    REQUIRE(loaded.getDelayTimer() == 5);
+    REQUIRE(loaded.getMemory()[0x300] == 0xAB);
+    REQUIRE(loadedDisplay.getFrameHash() == display.getFrameHash());
+
+    SECTION("Stack and random numbers continue the same way") {
+        chip8.decodeTest(0x00EE);
+        loaded.decodeTest(0x00EE);
+        REQUIRE(loaded.getPC() == chip8.getPC());
+
+        chip8.decodeTest(0xC0FF);
+        loaded.decodeTest(0xC0FF);
+        REQUIRE(loaded.getRegisters()[0] == chip8.getRegisters()[0]);
+    }
+
+    SECTION("Truncated state is rejected and changes nothing") {
+        std::ifstream input{ path, std::ios::binary };
+        std::string contents{ std::istreambuf_iterator<char>(input), std::istreambuf_iterator<char>() };
+        input.close();
+        std::ofstream output{ path, std::ios::binary | std::ios::trunc };
+        output.write(contents.data(), (std::streamsize) contents.size() - 1);
+        output.close();
+
+        SimpleDisplay freshDisplay{};
+        Chip8Test fresh{freshDisplay, inputHandler};
+        REQUIRE(!fresh.loadState(path));
+        REQUIRE(fresh.getPC() == 0x200);
+        REQUIRE(fresh.getRegisters()[0xA] == 0);
+    }
+
+    std::remove(path.c_str());
+}
+
+TEST_CASE("Debugger Stops", "") {
+    TestInputHandler inputHandler{};
+    SimpleDisplay display{};
+    Chip8Test chip8{display, inputHandler};
+    Debugger debugger{};
+    chip8.setDebugger(&debugger);
+
+    // V0 = 5, I = 0x300, BCD of V0 at I, then V0 counts up forever
+    const uint8_t rom[]{ 0x60, 0x05, 0xA3, 0x00, 0xF0, 0x33, 0x70, 0x01, 0x12, 0x06 };
+    REQUIRE(chip8.loadRom(rom, sizeof(rom)));
+
+    SECTION("Breakpoint stops before the instruction and is stepped over on resume") {
+        debugger.addBreakpoint(0x206);
+        REQUIRE(chip8.runFrames(1));
+        REQUIRE(debugger.isStopped());
+        REQUIRE(debugger.getStopInfo().reason == StopReason::BREAKPOINT);
+        REQUIRE(chip8.getPC() == 0x206);
+        REQUIRE(chip8.getInstructionCount() == 3);
+        REQUIRE(chip8.getFrameCount() == 0);
+
+        // Stopped cores do not run
+        REQUIRE(chip8.runFrames(1));
+        REQUIRE(chip8.getInstructionCount() == 3);
+
+        uint8_t delayTimer{ chip8.getDelayTimer() };
+        debugger.resume();
+        REQUIRE(chip8.runFrames(1));
+        REQUIRE(debugger.isStopped());
+        REQUIRE(chip8.getPC() == 0x206);
+        REQUIRE(chip8.getInstructionCount() == 5);
+        REQUIRE(chip8.getDelayTimer() == delayTimer);
+    }
+
+    SECTION("Step runs one instruction") {
+        debugger.addBreakpoint(0x204);
+        REQUIRE(chip8.runFrames(1));
+        debugger.step();
+        REQUIRE(chip8.runFrames(1));
+        REQUIRE(debugger.getStopInfo().reason == StopReason::STEP);
+        REQUIRE(chip8.getPC() == 0x206);
+        REQUIRE(chip8.getMemory()[0x302] == 5);
+    }
+
+    SECTION("Write watchpoint stops after FX33") {
+        int id{ debugger.addWatchpoint(0x301, 1, WatchKind::WRITE) };
+        debugger.addWatchpoint(0x300, 3, WatchKind::READ);
+        REQUIRE(chip8.runFrames(1));
+        StopInfo stopInfo{ debugger.getStopInfo() };
+        REQUIRE(stopInfo.reason == StopReason::WATCHPOINT);
+        REQUIRE(stopInfo.id == id);
+        REQUIRE(stopInfo.address == 0x301);
+        REQUIRE(chip8.getPC() == 0x206);
+    }
+
+    SECTION("Register condition fires when it becomes true") {
+        int id{ debugger.addRegisterCondition(0, Comparison::EQUAL, 8) };
+        REQUIRE(chip8.runFrames(1));
+        REQUIRE(debugger.getStopInfo().reason == StopReason::REGISTER_CONDITION);
+        REQUIRE(debugger.getStopInfo().id == id);
+        REQUIRE(chip8.getRegisters()[0] == 8);
+        REQUIRE(chip8.getPC() == 0x208);
+    }
+
+    SECTION("Removed debugger runs the plain loop again") {
+        debugger.addBreakpoint(0x206);
+        chip8.setDebugger(nullptr);
+        REQUIRE(chip8.runFrames(1));
+        REQUIRE(chip8.getFrameCount() == 1);
+    }
+}
+
+TEST_CASE("Debugger Read Watchpoint On Sprites", "") {
+    TestInputHandler inputHandler{};
+    SimpleDisplay display{};
+    Chip8Test chip8{display, inputHandler};
+    Debugger debugger{};
+    chip8.setDebugger(&debugger);
+
+    // Five rows of sprite from 0x300, the watch covers only the last one
+    const uint8_t rom[]{ 0x60, 0x00, 0xA3, 0x00, 0xD0, 0x05, 0x12, 0x06 };
+    REQUIRE(chip8.loadRom(rom, sizeof(rom)));
+    debugger.addWatchpoint(0x304, 4, WatchKind::ACCESS);
+
+    REQUIRE(chip8.runFrames(1));
+    REQUIRE(debugger.getStopInfo().reason == StopReason::WATCHPOINT);
+    REQUIRE(debugger.getStopInfo().address == 0x304);
+    REQUIRE(chip8.getPC() == 0x206);
+
+    // DXYN ended the frame under vblank wait, so the stop completed it
+    REQUIRE(chip8.getFrameCount() == 1);
+}
+
+TEST_CASE("Idle Loops Are Skipped Without Changing State", "") {
+    // Delay timer wait, jump to self, key poll with a register load and FX0A
+    const std::vector<std::vector<uint8_t>> roms{
+            { 0x60, 0x05, 0xF0, 0x15, 0xF1, 0x07, 0x31, 0x00, 0x12, 0x04, 0x72, 0x01, 0x12, 0x0A },
+            { 0x60, 0x01, 0x12, 0x02 },
+            { 0x6A, 0x05, 0xEA, 0x9E, 0x12, 0x00, 0x7B, 0x01, 0x12, 0x06 },
+            { 0xF3, 0x0A, 0x74, 0x01, 0x12, 0x00 }
+    };
+
+    for (const auto& rom : roms) {
+        // The attached debugger selects the loop that runs every instruction
+        TestInputHandler inputHandler{};
+        SimpleDisplay display{};
+        Chip8Test chip8{display, inputHandler};
+        TestInputHandler referenceInputHandler{};
+        SimpleDisplay referenceDisplay{};
+        Chip8Test reference{referenceDisplay, referenceInputHandler};
+        Debugger debugger{};
+        reference.setDebugger(&debugger);
+
+        for (Chip8Test* core : { &chip8, &reference }) {
+            core->setInstructionsPerFrame(17);
+            REQUIRE(core->loadRom(rom.data(), rom.size()));
+        }
+
+        for (int frame{}; frame < 12; frame++) {
+            // Key 5 is held for a few frames in the middle
+            uint16_t keys{ (uint16_t) (frame >= 4 && frame < 7 ? 1 << 5 : 0) };
+            inputHandler.setKeyState(keys);
+            referenceInputHandler.setKeyState(keys);
+
+            REQUIRE(chip8.runFrames(1));
+            REQUIRE(reference.runFrames(1));
+            REQUIRE(chip8.getPC() == reference.getPC());
+            REQUIRE(chip8.getRegisters() == reference.getRegisters());
+            REQUIRE(chip8.getDelayTimer() == reference.getDelayTimer());
+            REQUIRE(chip8.getInstructionCount() == reference.getInstructionCount());
+        }
+    }
+}
+
+TEST_CASE("Fused Pairs Match The Unfused Loop", "") {
+    // Every fusion, with the second half of SET_SET at 0x216 rewritten from 66 09 to 76 09 by FX55 on the first pass
+    // and FX1E carrying into VF
+    const std::vector<uint8_t> rom{
+            0x60, 0x00, 0x61, 0x05, 0xA2, 0x50, 0xD0, 0x15, 0x70, 0x03, 0x30, 0x1E, 0x12, 0x04, 0xA2, 0x50,
+            0xF2, 0x65, 0x60, 0x76, 0x65, 0x08, 0x66, 0x09, 0xA2, 0x16, 0xF0, 0x55, 0x90, 0x10, 0x12, 0x1E,
+            0xAF, 0xFF, 0xF5, 0x1E, 0x77, 0x01, 0x78, 0x02, 0x40, 0x76, 0x12, 0x00
+    };
+    const uint8_t sprite[]{ 0xF0, 0x90, 0xF0, 0x90, 0x90 };
+
+    for (const Quirks& quirks : { COSMAC_VIP_QUIRKS, SCHIP_QUIRKS }) {
+        TestInputHandler inputHandler{};
+        SimpleDisplay display{};
+        Chip8Test chip8{display, inputHandler};
+        TestInputHandler referenceInputHandler{};
+        SimpleDisplay referenceDisplay{};
+        Chip8Test reference{referenceDisplay, referenceInputHandler};
+        // A register condition that never fires keeps the reference on the diagnostic loop, which does not fuse
+        Debugger debugger{};
+        debugger.addRegisterCondition(0xE, Comparison::NOT_EQUAL, 0);
+        reference.setDebugger(&debugger);
+
+        for (Chip8Test* core : { &chip8, &reference }) {
+            core->setQuirks(quirks);
+            core->setInstructionsPerFrame(17);
+            REQUIRE(core->loadRom(rom.data(), rom.size()));
+            core->getMemory().write(0x250, sprite, sizeof(sprite));
+        }
+
+        for (int frame{}; frame < 40; frame++) {
+            REQUIRE(chip8.runFrames(1));
+            REQUIRE(reference.runFrames(1));
+            REQUIRE(chip8.getPC() == reference.getPC());
+            REQUIRE(chip8.getIndex() == reference.getIndex());
+            REQUIRE(chip8.getRegisters() == reference.getRegisters());
+            REQUIRE(chip8.getInstructionCount() == reference.getInstructionCount());
+            REQUIRE(display.getFrameHash() == referenceDisplay.getFrameHash());
+        }
+        REQUIRE(chip8.getFusedCount() > 0);
+        REQUIRE(reference.getFusedCount() == 0);
+        REQUIRE(chip8.getMemory()[0x216] == 0x76);
+    }
+}
+
+TEST_CASE("Debugger Breakpoints Keep The Release Loop", "") {
+    TestInputHandler inputHandler{};
+    SimpleDisplay display{};
+    Chip8Test chip8{display, inputHandler};
+    Debugger debugger{};
+    chip8.setDebugger(&debugger);
+
+    // V0 = 1 and V1 = 2 fuse, then V0 counts up forever
+    const uint8_t rom[]{ 0x60, 0x01, 0x61, 0x02, 0x70, 0x01, 0x12, 0x04 };
+    REQUIRE(chip8.loadRom(rom, sizeof(rom)));
+
+    // A breakpoint on the second half of a pair stops the pair from fusing
+    debugger.addBreakpoint(0x202);
+    REQUIRE(chip8.runFrames(1));
+    REQUIRE(debugger.getStopInfo().reason == StopReason::BREAKPOINT);
+    REQUIRE(chip8.getPC() == 0x202);
+    REQUIRE(chip8.getInstructionCount() == 1);
+    REQUIRE(chip8.getFusedCount() == 0);
+
+    // Straight line code stops at the next breakpoint the start of its block looked ahead to
+    debugger.removeBreakpoint(0x202);
+    debugger.addBreakpoint(0x206);
+    debugger.resume();
+    REQUIRE(chip8.runFrames(1));
+    REQUIRE(debugger.getStopInfo().reason == StopReason::BREAKPOINT);
+    REQUIRE(chip8.getPC() == 0x206);
+    REQUIRE(chip8.getInstructionCount() == 3);
+
+    // Without breakpoints in the way an attached debugger leaves the pair fused
+    Chip8Test fused{display, inputHandler};
+    Debugger emptyDebugger{};
+    fused.setDebugger(&emptyDebugger);
+    REQUIRE(fused.loadRom(rom, sizeof(rom)));
+    REQUIRE(fused.runFrames(1));
+    REQUIRE(fused.getFusedCount() == 1);
+    REQUIRE(fused.getFrameCount() == 1);
+}
+
+TEST_CASE("Profiler Counts Opcode Pairs", "") {
+    TestInputHandler inputHandler{};
+    SimpleDisplay display{};
+    Chip8Test chip8{display, inputHandler};
+    ExecutionProfiler profiler{ "chip8_pair_profiler_test" };
+    chip8.setProfiler(&profiler);
+
+    // V0 += 1 until it is 3, then jump to self
+    const uint8_t rom[]{ 0x70, 0x01, 0x30, 0x03, 0x12, 0x00, 0x12, 0x06 };
+    REQUIRE(chip8.loadRom(rom, sizeof(rom)));
+    chip8.setInstructionsPerFrame(10);
+    REQUIRE(chip8.runFrames(1));
+
+    REQUIRE(profiler.getOpcodePairCount(Opcode::ADD_IMM, Opcode::SKIP_EQ_IMM) == 3);
+    REQUIRE(profiler.getOpcodePairCount(Opcode::SKIP_EQ_IMM, Opcode::JUMP) == 3);
+    REQUIRE(profiler.getOpcodePairCount(Opcode::JUMP, Opcode::ADD_IMM) == 2);
+    REQUIRE(profiler.getOpcodePairCount(Opcode::JUMP, Opcode::JUMP) == 1);
+    REQUIRE(profiler.getOpcodePairCount(Opcode::ADD_IMM, Opcode::JUMP) == 0);
+}
+
+TEST_CASE("Step Yields On Key Waits And Matches Whole Frames", "") {
+    // FX0A, a register increment, then back to the wait
+    const uint8_t rom[]{ 0xF3, 0x0A, 0x74, 0x01, 0x12, 0x00 };
+
+    TestInputHandler inputHandler{};
+    SimpleDisplay display{};
+    Chip8Test chip8{display, inputHandler};
+    TestInputHandler referenceInputHandler{};
+    SimpleDisplay referenceDisplay{};
+    Chip8Test reference{referenceDisplay, referenceInputHandler};
+    for (Chip8Test* core : { &chip8, &reference }) {
+        core->setInstructionsPerFrame(17);
+        REQUIRE(core->loadRom(rom, sizeof(rom)));
+    }
+
+    // The wait is the first instruction, the rest of the frame runs on the next step
+    REQUIRE(chip8.step() == StepResult::KEY_WAIT);
+    REQUIRE(chip8.getFrameCount() == 0);
+    REQUIRE(chip8.step() == StepResult::FRAME);
+    REQUIRE(reference.runFrames(1));
+
+    for (int frame{1}; frame < 12; frame++) {
+        // Key 5 is held for a few frames in the middle
+        uint16_t keys{ (uint16_t) (frame >= 4 && frame < 7 ? 1 << 5 : 0) };
+        inputHandler.setKeyState(keys);
+        referenceInputHandler.setKeyState(keys);
+
+        StepResult result;
+        do {
+            result = chip8.step();
+        } while (result == StepResult::KEY_WAIT);
+        REQUIRE(result == StepResult::FRAME);
+        REQUIRE(reference.runFrames(1));
+
+        REQUIRE(chip8.getFrameCount() == reference.getFrameCount());
+        REQUIRE(chip8.getPC() == reference.getPC());
+        REQUIRE(chip8.getRegisters() == reference.getRegisters());
+        REQUIRE(chip8.getInstructionCount() == reference.getInstructionCount());
+    }
+    REQUIRE(chip8.getRegisters()[4] == 1);
+}
+
+TEST_CASE("Run Control Steps Instructions And Frames While Paused", "") {
+    // V0 = 1, two increments, then an instruction that cannot be decoded
+    const uint8_t rom[]{ 0x60, 0x01, 0x70, 0x01, 0x70, 0x01, 0x00, 0x00 };
+
+    TestInputHandler inputHandler{};
+    SimpleDisplay display{};
+    Chip8Test chip8{display, inputHandler};
+    REQUIRE(chip8.loadRom(rom, sizeof(rom)));
+
+    // Steps are ignored until the run is paused
+    RunControl control{};
+    control.stepInstruction();
+    control.pause();
+    control.stepInstruction(2);
+    control.stepFrame();
+
+    // Two instructions, then the frame finishes and exits, all without another thread
+    chip8.resume(control);
+    REQUIRE(chip8.getRegisters()[0] == 3);
+    REQUIRE(chip8.getInstructionCount() == 3);
+
+    // Stepping directly stays inside the frame until its last instruction
+    Chip8Test stepped{display, inputHandler};
+    stepped.setInstructionsPerFrame(2);
+    REQUIRE(stepped.loadRom(rom, sizeof(rom)));
+    REQUIRE(stepped.runInstruction());
+    REQUIRE(stepped.getFrameCount() == 0);
+    REQUIRE(stepped.getPC() == 0x202);
+    REQUIRE(stepped.runInstruction());
+    REQUIRE(stepped.getFrameCount() == 1);
+    REQUIRE(stepped.runInstruction());
+    REQUIRE(stepped.getRegisters()[0] == 3);
+    REQUIRE(!stepped.runInstruction());
+    REQUIRE(stepped.getInstructionCount() == 3);
+}
+
+TEST_CASE("Run Control Stops A Paused Or Unlimited Run", "") {
+    const uint8_t rom[]{ 0x70, 0x01, 0x12, 0x00 };
+
+    for (bool isPaused : { true, false }) {
+        TestInputHandler inputHandler{};
+        SimpleDisplay display{};
+        Chip8Test chip8{display, inputHandler};
+        REQUIRE(chip8.loadRom(rom, sizeof(rom)));
+
+        RunControl control{};
+        control.setSpeed(RunControl::UNLIMITED_SPEED);
+        if (isPaused) {
+            control.pause();
+        }
+
+        std::thread cpuThread(&Chip8::resume, &chip8, std::ref(control));
+        std::this_thread::sleep_for(std::chrono::milliseconds(20));
+        control.stop();
+        cpuThread.join();
+
+        // A paused run blocks before its first frame
+        REQUIRE((chip8.getFrameCount() == 0) == isPaused);
+    }
+}
+
+TEST_CASE("Run Control Wakes A Run Stopped By The Debugger", "") {
+    const uint8_t rom[]{ 0x70, 0x01, 0x12, 0x00 };
+
+    TestInputHandler inputHandler{};
+    SimpleDisplay display{};
+    Chip8Test chip8{display, inputHandler};
+    Debugger debugger{};
+    chip8.setDebugger(&debugger);
+    REQUIRE(chip8.loadRom(rom, sizeof(rom)));
+
+    RunControl control{};
+    control.setSpeed(RunControl::UNLIMITED_SPEED);
+    debugger.requestStop();
+    std::thread cpuThread(&Chip8::resume, &chip8, std::ref(control));
+    REQUIRE(debugger.waitForStop(1000));
+
+    // Nothing runs while stopped, resuming carries on and stopping the run ends the wait
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    REQUIRE(chip8.getInstructionCount() == 0);
+    debugger.addBreakpoint(0x202);
+    debugger.resume();
+    REQUIRE(debugger.waitForStop(1000));
+    REQUIRE(chip8.getPC() == 0x202);
+    REQUIRE(chip8.getRegisters()[0] == 1);
+
+    control.stop();
+    cpuThread.join();
+    REQUIRE(debugger.isStopped());
+}
+
+TEST_CASE("Run Control Replays Taps Over Slower Frames", "") {
+    // Waits for a key and counts it in V1
+    const uint8_t rom[]{ 0xF0, 0x0A, 0x71, 0x01, 0x12, 0x00 };
+
+    TestInputHandler inputHandler{};
+    SimpleDisplay display{};
+    Chip8Test chip8{display, inputHandler};
+    chip8.setInstructionsPerFrame(1000);
+    REQUIRE(chip8.loadRom(rom, sizeof(rom)));
+
+    // A 5ms tap is a small part of a quarter speed frame, it is only seen if it is spread over the whole frame
+    uint64_t tapStart{ InputHandler::now() + 100000000 };
+    inputHandler.pushEvent(InputEvent{ tapStart, 0x5, true });
+    inputHandler.pushEvent(InputEvent{ tapStart + 5000000, 0x5, false });
+
+    RunControl control{};
+    control.setSpeed(RunControl::MIN_SPEED);
+    std::thread cpuThread(&Chip8::resume, &chip8, std::ref(control));
+    std::this_thread::sleep_for(std::chrono::milliseconds(400));
+    control.stop();
+    cpuThread.join();
+
+    REQUIRE(chip8.getRegisters()[0] == 0x5);
+    REQUIRE(chip8.getRegisters()[1] == 1);
+}
+
+TEST_CASE("Run Control Speed Limits", "") {
+    RunControl control{};
+    REQUIRE(control.getFramePeriod().count() == (int64_t) FRAME_DURATION_NS);
+
+    control.setSpeed(0.1);
+    REQUIRE(control.getSpeed() == RunControl::MIN_SPEED);
+    REQUIRE(control.getFramePeriod().count() == (int64_t) (FRAME_DURATION_NS * 4));
+
+    control.setSpeed(RunControl::UNLIMITED_SPEED);
+    REQUIRE(control.getFramePeriod().count() == 0);
+}
+
+TEST_CASE("Framebuffer Displays Draw Like Overridden Ones", "") {
+    // Sprites marching across the edges with collisions, cleared every 64 draws
+    const uint8_t rom[]{ 0xA0, 0x50, 0xD0, 0x1F, 0x70, 0x07, 0x71, 0x03, 0x72, 0x01, 0x32, 0x40, 0x12, 0x02, 0x00, 0xE0,
+                         0x62, 0x00, 0x12, 0x02 };
+
+    // Any subclass goes through the virtual calls
+    class OverriddenDisplay : public SimpleDisplay {};
+
+    for (const Quirks& quirks : { COSMAC_VIP_QUIRKS, XO_CHIP_QUIRKS }) {
+        TestInputHandler inputHandler{};
+        SimpleDisplay display{};
+        Chip8Test chip8{display, inputHandler};
+        OverriddenDisplay referenceDisplay{};
+        Chip8Test reference{referenceDisplay, inputHandler};
+        for (Chip8Test* core : { &chip8, &reference }) {
+            core->setQuirks(quirks);
+            core->setInstructionsPerFrame(50);
+            REQUIRE(core->loadRom(rom, sizeof(rom)));
+        }
+
+        for (int frame{}; frame < 60; frame++) {
+            REQUIRE(chip8.runFrames(1));
+            REQUIRE(reference.runFrames(1));
+            REQUIRE(chip8.getRegisters() == reference.getRegisters());
+            REQUIRE(display.getFrameHash() == referenceDisplay.getFrameHash());
+        }
+    }
+}
+
+TEST_CASE("Reset Matches A New Core", "") {
+    // Random sprites at random places, with a subroutine and a store so RAM pages split off the image
+    const uint8_t rom[]{ 0xC0, 0x3F, 0xC1, 0x1F, 0xF2, 0x29, 0xD0, 0x15, 0x22, 0x0C, 0x12, 0x00, 0xA3, 0x00, 0xF2, 0x55,
+                         0x72, 0x01, 0x00, 0xEE };
+    RomImage image{};
+    REQUIRE(Chip8::buildRomImage(rom, sizeof(rom), image));
+
+    TestInputHandler inputHandler{};
+    SimpleDisplay display{};
+    Chip8Test chip8{display, inputHandler};
+    REQUIRE(chip8.loadRom(rom, sizeof(rom)));
+    REQUIRE(chip8.runFrames(30));
+
+    for (uint32_t seed : { 1u, 2u }) {
+        chip8.reset(image, seed);
+        SimpleDisplay referenceDisplay{};
+        Chip8Test reference{referenceDisplay, inputHandler};
+        reference.seedRandom(seed);
+        REQUIRE(reference.loadRom(rom, sizeof(rom)));
+        REQUIRE(display.getFrameHash() == referenceDisplay.getFrameHash());
+
+        for (int frame{}; frame < 30; frame++) {
+            REQUIRE(chip8.runFrames(1));
+            REQUIRE(reference.runFrames(1));
+            REQUIRE(chip8.getRegisters() == reference.getRegisters());
+            REQUIRE(chip8.getPC() == reference.getPC());
+            REQUIRE(chip8.getInstructionCount() == reference.getInstructionCount());
+            REQUIRE(display.getFrameHash() == referenceDisplay.getFrameHash());
+        }
+        for (int address{}; address < RAM_SIZE; address++) {
+            REQUIRE(chip8.readMemory(address) == reference.readMemory(address));
+        }
+    }
+
+    // Pages the core wrote to were split off, the image is unchanged
+    REQUIRE(image.memory[0x300] == 0);
+}
+
+TEST_CASE("Snapshots Roll Back Frames", "") {
+    // Sprites marching across the edges, random numbers stored to RAM, cleared every 64 draws
+    const uint8_t rom[]{ 0xA0, 0x50, 0xD0, 0x1F, 0x70, 0x07, 0x71, 0x03, 0x72, 0x01, 0xC3, 0xFF, 0xA3, 0x00, 0xF3, 0x55,
+                         0x32, 0x40, 0x12, 0x00, 0x00, 0xE0, 0x62, 0x00, 0x12, 0x00 };
+
+    // Any subclass is repainted pixel by pixel
+    class OverriddenDisplay : public SimpleDisplay {};
+
+    SimpleDisplay framebufferDisplay{};
+    OverriddenDisplay overriddenDisplay{};
+    for (SimpleDisplay* display : { &framebufferDisplay, static_cast<SimpleDisplay*>(&overriddenDisplay) }) {
+        TestInputHandler inputHandler{};
+        Chip8Test chip8{*display, inputHandler};
+        chip8.seedRandom(7);
+        REQUIRE(chip8.loadRom(rom, sizeof(rom)));
+        REQUIRE(chip8.runFrames(20));
+
+        Chip8Snapshot snapshot{};
+        chip8.saveSnapshot(snapshot);
+        std::vector<uint64_t> hashes;
+        for (int frame{}; frame < 70; frame++) {
+            REQUIRE(chip8.runFrames(1));
+            hashes.push_back(display->getFrameHash());
+        }
+        std::vector<uint8_t> registers{ chip8.getRegisters() };
+        uint64_t instructionCount{ chip8.getInstructionCount() };
+
+        // Twice from the same snapshot, it is not used up by loading it
+        for (int replay{}; replay < 2; replay++) {
+            chip8.loadSnapshot(snapshot);
+            REQUIRE(chip8.getFrameCount() == 20);
+            for (int frame{}; frame < 70; frame++) {
+                REQUIRE(chip8.runFrames(1));
+                REQUIRE(display->getFrameHash() == hashes[frame]);
+            }
+            REQUIRE(chip8.getRegisters() == registers);
+            REQUIRE(chip8.getInstructionCount() == instructionCount);
+        }
+    }
+}
+
+TEST_CASE("Run Ahead Presents Later Frames And Keeps The Real Machine", "") {
+    // Forty random sprites at random places, one a frame, then an instruction that cannot be decoded
+    const uint8_t rom[]{ 0xC0, 0x3F, 0xC1, 0x1F, 0xF2, 0x29, 0xD0, 0x15, 0x72, 0x01, 0x32, 0x28, 0x12, 0x00, 0x00, 0x00 };
+
+    class RecordingDisplay : public SimpleDisplay {
+    public:
+        std::vector<uint64_t> presented;
+
+        void updateWindowSurface() override {
+            presented.push_back(getFrameHash());
+        }
+    };
+
+    constexpr int RUN_AHEAD_FRAMES{2};
+    TestInputHandler inputHandler{};
+    RecordingDisplay display{};
+    Chip8Test chip8{display, inputHandler};
+    RecordingDisplay referenceDisplay{};
+    Chip8Test reference{referenceDisplay, inputHandler};
+    chip8.setRunAheadFrames(RUN_AHEAD_FRAMES);
+    for (Chip8Test* core : { &chip8, &reference }) {
+        core->seedRandom(3);
+        REQUIRE(core->loadRom(rom, sizeof(rom)));
+        RunControl control{};
+        control.setSpeed(RunControl::UNLIMITED_SPEED);
+        core->resume(control);
+    }
+
+    // Every frame shows the one the real machine reaches two frames later, until the run ahead hits the exit
+    REQUIRE(display.presented.size() == referenceDisplay.presented.size());
+    for (size_t frame{}; frame + RUN_AHEAD_FRAMES < referenceDisplay.presented.size(); frame++) {
+        REQUIRE(display.presented[frame] == referenceDisplay.presented[frame + RUN_AHEAD_FRAMES]);
+    }
+
+    REQUIRE(chip8.getRegisters() == reference.getRegisters());
+    REQUIRE(chip8.getPC() == reference.getPC());
+    REQUIRE(chip8.getInstructionCount() == reference.getInstructionCount());
+    REQUIRE(chip8.getFrameCount() == reference.getFrameCount());
+    REQUIRE(display.getFrameHash() == referenceDisplay.getFrameHash());
+}
@@ -0,0 +1,88 @@
+#include <catch2/catch_test_macros.hpp>
+#include <string>
+#include <utility>
+#include <vector>
+#include "../src/extras/command_line.h"
+
+static bool parse(std::vector<const char*> arguments, CommandLineOptions& options, std::string& error) {
+    arguments.insert(arguments.begin(), "chip8_emulator");
+    return parseCommandLine((int) arguments.size(), arguments.data(), options, error);
+}
+
+TEST_CASE("Command Line Defaults") {
+    CommandLineOptions options{};
+    std::string error;
+    REQUIRE(parse({ "game.ch8" }, options, error));
+
+    REQUIRE(options.romPath == "game.ch8");
+    REQUIRE(options.core == CoreChoice::AUTO);
+    REQUIRE(!options.hasQuirks);
+    REQUIRE(options.instructionsPerFrame == 0);
+    REQUIRE(options.scale == PIXEL_SIZE);
+    REQUIRE(options.runAheadFrames == 0);
+    REQUIRE(!options.isHeadless);
+    REQUIRE(options.frameCount == 0);
+    REQUIRE(options.gdbPort == 0);
+    REQUIRE(options.netplayPeer.empty());
+    REQUIRE(options.netplayPort == DEFAULT_NETPLAY_PORT);
+}
+
+TEST_CASE("Command Line Options") {
+    CommandLineOptions options{};
+    std::string error;
+    REQUIRE(parse({ "--core", "schip", "--quirks", "vip", "--ipf", "200", "--scale", "8", "--run-ahead", "2",
+                    "--headless", "--frames", "1000", "--bench", "--trace", "run.trace", "--profile", "run",
+                    "--load-state", "in.state", "--save-state", "out.state", "--rom-db", "roms.idx", "--gdb", "1234",
+                    "--netplay", "10.0.0.2:7051", "--netplay-port", "7052", "game.ch8" }, options, error));
+
+    REQUIRE(options.romPath == "game.ch8");
+    REQUIRE(options.core == CoreChoice::SCHIP);
+    REQUIRE(options.hasQuirks);
+    REQUIRE(options.quirks.getFlags() == COSMAC_VIP_QUIRKS.getFlags());
+    REQUIRE(options.instructionsPerFrame == 200);
+    REQUIRE(options.scale == 8);
+    REQUIRE(options.runAheadFrames == 2);
+    REQUIRE(options.isHeadless);
+    REQUIRE(options.frameCount == 1000);
+    REQUIRE(options.isBenchmark);
+    REQUIRE(options.tracePath == "run.trace");
+    REQUIRE(options.profilePrefix == "run");
+    REQUIRE(options.loadStatePath == "in.state");
+    REQUIRE(options.saveStatePath == "out.state");
+    REQUIRE(options.romDatabasePath == "roms.idx");
+    REQUIRE(options.gdbPort == 1234);
+    REQUIRE(options.netplayPeer == "10.0.0.2:7051");
+    REQUIRE(options.netplayPort == 7052);
+}
+
+TEST_CASE("Command Line Headless Frame Count Default") {
+    CommandLineOptions options{};
+    std::string error;
+    REQUIRE(parse({ "game.ch8", "--headless" }, options, error));
+    REQUIRE(options.frameCount == HEADLESS_FRAME_COUNT);
+}
+
+TEST_CASE("Command Line Errors") {
+    std::string error;
+    auto fails{ [&](std::vector<const char*> arguments) {
+        CommandLineOptions options{};
+        return !parse(std::move(arguments), options, error);
+    } };
+
+    REQUIRE(fails({}));
+    REQUIRE(fails({ "game.ch8", "other.ch8" }));
+    REQUIRE(fails({ "game.ch8", "--core", "xochip" }));
+    REQUIRE(fails({ "game.ch8", "--quirks", "cosmac" }));
+    REQUIRE(fails({ "game.ch8", "--ipf", "0" }));
+    REQUIRE(fails({ "game.ch8", "--ipf", "12abc" }));
+    REQUIRE(fails({ "game.ch8", "--run-ahead", "9" }));
+    REQUIRE(fails({ "game.ch8", "--frames" }));
+    REQUIRE(fails({ "game.ch8", "--gdb", "70000" }));
+    REQUIRE(fails({ "game.ch8", "--netplay-port", "0" }));
+    REQUIRE(fails({ "game.ch8", "--fast" }));
+    REQUIRE(error == "Unknown option --fast");
+
+    CommandLineOptions helpOptions{};
+    REQUIRE(parse({ "--help" }, helpOptions, error));
+    REQUIRE(helpOptions.isHelp);
+}
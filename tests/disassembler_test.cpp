@@ -0,0 +1,68 @@
+#include <catch2/catch_test_macros.hpp>
+#include <sstream>
+#include <string>
+#include "../src/extras/disassembler.h"
+
+// 200: V0 = 0, 202: call 20C, 204: skip if V0 == 3, 206: jump back to 202, 208: exit, 20A: data
+// 20C: V0 += 1, 20E: return
+static const uint8_t ROM[]{ 0x60, 0x00, 0x22, 0x0C, 0x30, 0x03, 0x12, 0x02, 0x00, 0xFD, 0xAB, 0xCD, 0x70, 0x01,
+                            0x00, 0xEE };
+
+TEST_CASE("Disassemble Instructions", "") {
+    REQUIRE(disassembleInstruction(0x6A42, true) == "LD VA, #42");
+    REQUIRE(disassembleInstruction(0xD125, true) == "DRW V1, V2, 5");
+    REQUIRE(disassembleInstruction(0xF355, true) == "LD [I], V3");
+    REQUIRE(disassembleInstruction(0xB300, true) == "JP V0, #300");
+    REQUIRE(disassembleInstruction(0x00FF, true) == "HIGH");
+    REQUIRE(disassembleInstruction(0x00FF, false) == "DW #00FF");
+    REQUIRE(disassembleInstruction(0x8128, true) == "DW #8128");
+}
+
+TEST_CASE("Control Flow Graph", "") {
+    ControlFlowGraph graph{ analyseRom(ROM, sizeof(ROM), true) };
+
+    std::vector<uint16_t> starts;
+    for (const BasicBlock& block : graph.blocks) {
+        starts.push_back(block.start);
+    }
+    REQUIRE(starts == std::vector<uint16_t>{ 0x200, 0x202, 0x206, 0x208, 0x20C });
+
+    REQUIRE(graph.findBlock(0x202)->end == 0x206);
+    REQUIRE(graph.findBlock(0x202)->successors == std::vector<uint16_t>{ 0x206, 0x208 });
+    REQUIRE(graph.findBlock(0x206)->successors == std::vector<uint16_t>{ 0x202 });
+    REQUIRE(graph.findBlock(0x208)->successors.empty());
+    REQUIRE(graph.findBlock(0x204) == nullptr);
+
+    REQUIRE(graph.functions == std::vector<uint16_t>{ 0x200, 0x20C });
+    REQUIRE(graph.calls == std::vector<std::pair<uint16_t, uint16_t>>{ { 0x200, 0x20C } });
+    REQUIRE(!graph.code.test(0x20A));
+
+    SECTION("CHIP-8 stops at the SCHIP exit") {
+        ControlFlowGraph chip8Graph{ analyseRom(ROM, sizeof(ROM), false) };
+        REQUIRE(chip8Graph.findBlock(0x208) == nullptr);
+        REQUIRE(!chip8Graph.code.test(0x208));
+    }
+
+    SECTION("Listing and DOT") {
+        std::ostringstream listing;
+        writeListing(graph, ROM, sizeof(ROM), listing);
+        REQUIRE(listing.str().find("sub_20C:\nL_20C:\n  20C  7001  ADD V0, #01\n") != std::string::npos);
+        REQUIRE(listing.str().find("  20A  DB #AB, #CD\n") != std::string::npos);
+
+        std::ostringstream dot;
+        writeDot(graph, ROM, dot);
+        REQUIRE(dot.str().find("b206 -> b202;") != std::string::npos);
+        REQUIRE(dot.str().find("b202 -> b20C [style=dashed];") != std::string::npos);
+    }
+}
+
+TEST_CASE("Control Flow Graph Edge Cases", "") {
+    REQUIRE(analyseRom(ROM, 1, true).blocks.empty());
+
+    // Jump into the middle of straight line code splits the block
+    const uint8_t rom[]{ 0x60, 0x00, 0x61, 0x00, 0x62, 0x00, 0x12, 0x02 };
+    ControlFlowGraph graph{ analyseRom(rom, sizeof(rom), true) };
+    REQUIRE(graph.blocks.size() == 2);
+    REQUIRE(graph.findBlock(0x200)->successors == std::vector<uint16_t>{ 0x202 });
+    REQUIRE(graph.findBlock(0x202)->end == 0x208);
+}
@@ -0,0 +1,161 @@
+#include <catch2/catch_test_macros.hpp>
+#include <algorithm>
+#include <chrono>
+#include <memory>
+#include "../src/pool/emulator_pool.h"
+#include "../src/pool/emulator_scheduler.h"
+
+// Draws the font sprite for 0 at the top left while key 5 is held, then jumps to itself
+const std::vector<uint8_t> KEY_ROM{
+    0xA0, 0x50, // I = font 0
+    0x61, 0x00, // V1 = 0
+    0x62, 0x00, // V2 = 0
+    0x60, 0x05, // V0 = 5
+    0xE0, 0xA1, // Skip draw if key V0 is not pressed
+    0xD1, 0x25, // Draw at (V1, V2)
+    0x12, 0x0C  // Jump to self
+};
+
+TEST_CASE("Pool Instances Follow Their Own Actions") {
+    Chip8Pool pool{ 4, KEY_ROM, nullptr, 2 };
+    REQUIRE(pool.size() == 4);
+
+    const uint16_t actions[]{ 0, 1 << 5, 0, 1 << 5 };
+    pool.step(actions);
+
+    for (int i{}; i < 4; i++) {
+        const uint8_t* frame{ pool.observe(i) };
+        bool isDrawn{ i % 2 == 1 };
+
+        // Top row of the 0 glyph is 0xF0
+        for (int x{}; x < 8; x++) {
+            REQUIRE(frame[x] == (isDrawn && x < 4 ? 1 : 0));
+        }
+        REQUIRE(!pool.isInstanceDone(i));
+    }
+
+    // Observations are laid out back to back
+    REQUIRE(pool.observe() + Chip8Pool::FRAMEBUFFER_SIZE == pool.observe(1));
+}
+
+TEST_CASE("Pool Renders Into Caller Buffer") {
+    std::vector<uint8_t> buffer(2 * SChipPool::FRAMEBUFFER_SIZE, 0xAA);
+    SChipPool pool{ 2, KEY_ROM, buffer.data(), 1 };
+
+    // Reset clears the caller buffer
+    REQUIRE(buffer[0] == 0);
+    REQUIRE(buffer[SChipPool::FRAMEBUFFER_SIZE] == 0);
+
+    const uint16_t actions[]{ 1 << 5, 1 << 5 };
+    pool.step(actions);
+    REQUIRE(pool.observe(1) == buffer.data() + SChipPool::FRAMEBUFFER_SIZE);
+    REQUIRE(buffer[0] == 1);
+    REQUIRE(buffer[SChipPool::FRAMEBUFFER_SIZE] == 1);
+
+    pool.reset();
+    REQUIRE(buffer[0] == 0);
+}
+
+TEST_CASE("Pool Marks Exited Instances Done") {
+    // 0000 is not a valid instruction
+    Chip8Pool pool{ 2, std::vector<uint8_t>{ 0x00, 0x00 }, nullptr, 2 };
+
+    const uint16_t actions[]{ 0, 0 };
+    pool.step(actions);
+    REQUIRE(pool.isInstanceDone(0));
+    REQUIRE(pool.isInstanceDone(1));
+
+    pool.reset(0);
+    REQUIRE(!pool.isInstanceDone(0));
+    REQUIRE(pool.isInstanceDone(1));
+}
+
+TEST_CASE("Pool Resets Replay The Same Episode") {
+    // Random sprite at a random place every frame
+    const std::vector<uint8_t> randomRom{ 0xC0, 0x3F, 0xC1, 0x1F, 0xA0, 0x50, 0xD0, 0x15, 0x12, 0x00 };
+    Chip8Pool pool{ 3, randomRom, nullptr, 2 };
+    pool.setSeed(11);
+    pool.reset();
+
+    const uint16_t actions[]{ 0, 0, 0 };
+    pool.step(actions, 20);
+    std::vector<uint8_t> first{ pool.observe(), pool.observe() + 3 * Chip8Pool::FRAMEBUFFER_SIZE };
+
+    pool.reset();
+    pool.step(actions, 20);
+    REQUIRE(std::equal(first.begin(), first.end(), pool.observe()));
+
+    // Instances have seeds of their own
+    REQUIRE(!std::equal(pool.observe(0), pool.observe(1), pool.observe(1)));
+}
+
+// Core with its own display and keypad
+struct ScheduledChip8 {
+    InputHandler inputHandler{};
+    SimpleDisplay display{};
+    Chip8 core{display, inputHandler, COSMAC_VIP_QUIRKS};
+
+    explicit ScheduledChip8(const std::vector<uint8_t>& rom, uint16_t keys) {
+        core.setInstructionsPerFrame(17);
+        inputHandler.setKeyState(keys);
+        REQUIRE(core.loadRom(rom.data(), rom.size()));
+    }
+};
+
+TEST_CASE("Scheduled Instances Match Whole Frames") {
+    // Waits on FX0A, counts in V4 and draws, so instances holding no key stay in the wait
+    const std::vector<uint8_t> waitRom{ 0xA0, 0x50, 0xF3, 0x0A, 0x74, 0x01, 0xD4, 0x45, 0x12, 0x02 };
+
+    std::vector<std::unique_ptr<ScheduledChip8>> instances;
+    std::vector<std::unique_ptr<ScheduledChip8>> references;
+    EmulatorScheduler scheduler{ 2, false };
+    for (int i{}; i < 100; i++) {
+        const std::vector<uint8_t>& rom{ i % 2 == 0 ? KEY_ROM : waitRom };
+        uint16_t keys{ (uint16_t) (i % 3 == 0 ? 1 << 5 : 0) };
+        instances.push_back(std::make_unique<ScheduledChip8>(rom, keys));
+        references.push_back(std::make_unique<ScheduledChip8>(rom, keys));
+        scheduler.add(instances.back()->core, 120);
+    }
+    scheduler.wait();
+
+    for (int i{}; i < 100; i++) {
+        REQUIRE(scheduler.isDone(i));
+        REQUIRE(references[i]->core.runFrames(120));
+
+        DebugRegisters expected{ references[i]->core.getDebugRegisters() };
+        DebugRegisters actual{ instances[i]->core.getDebugRegisters() };
+        for (int v{}; v < 16; v++) {
+            REQUIRE(actual.v[v] == expected.v[v]);
+        }
+        REQUIRE(actual.pc == expected.pc);
+        REQUIRE(instances[i]->core.getInstructionCount() == references[i]->core.getInstructionCount());
+        REQUIRE(instances[i]->display.getFrameHash() == references[i]->display.getFrameHash());
+    }
+}
+
+TEST_CASE("Scheduler Marks Exited Instances Done") {
+    // 0000 is not a valid instruction
+    ScheduledChip8 instance{ std::vector<uint8_t>{ 0x00, 0x00 }, 0 };
+    EmulatorScheduler scheduler{ 1, false };
+    int id{ scheduler.add(instance.core, 10) };
+    scheduler.wait();
+    REQUIRE(scheduler.isDone(id));
+}
+
+TEST_CASE("Paced Instances Run At Sixty Frames A Second") {
+    std::vector<std::unique_ptr<ScheduledChip8>> instances;
+    EmulatorScheduler scheduler{ 1 };
+    auto start{ std::chrono::steady_clock::now() };
+    for (int i{}; i < 4; i++) {
+        instances.push_back(std::make_unique<ScheduledChip8>(KEY_ROM, 0));
+        scheduler.add(instances.back()->core, 12);
+    }
+    scheduler.wait();
+
+    // The first frame runs right away, eleven more follow one every 16.7ms
+    auto elapsed{ std::chrono::steady_clock::now() - start };
+    REQUIRE(elapsed >= std::chrono::milliseconds(180));
+    for (const auto& instance : instances) {
+        REQUIRE(instance->core.getFrameCount() == 12);
+    }
+}
@@ -0,0 +1,157 @@
+#include <catch2/catch_test_macros.hpp>
+#include <cstdio>
+#include <string>
+#include <thread>
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#include "../src/displays/simple_display.h"
+#include "../src/emulators/chip8.h"
+#include "../src/extras/gdb_stub.h"
+
+// Minimal GDB side of the protocol over a loopback socket
+class TestClient {
+private:
+    int clientSocket;
+
+    // Next byte, or -1 if nothing came within two seconds
+    int receiveByte() {
+        pollfd clientPoll{ clientSocket, POLLIN, 0 };
+        char c;
+        if (poll(&clientPoll, 1, 2000) <= 0 || recv(clientSocket, &c, 1, 0) != 1) {
+            return -1;
+        }
+        return (uint8_t) c;
+    }
+
+public:
+    explicit TestClient(uint16_t port): clientSocket{ socket(AF_INET, SOCK_STREAM, 0) } {
+        sockaddr_in address{};
+        address.sin_family = AF_INET;
+        address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        address.sin_port = htons(port);
+        connect(clientSocket, reinterpret_cast<sockaddr*>(&address), sizeof(address));
+    }
+
+    ~TestClient() {
+        close(clientSocket);
+    }
+
+    void sendRaw(const std::string& data) {
+        send(clientSocket, data.data(), data.size(), 0);
+    }
+
+    // Sends a packet and returns the reply packet, after checking both acks
+    std::string transact(const std::string& data) {
+        uint8_t checksum{};
+        for (char c : data) {
+            checksum += (uint8_t) c;
+        }
+        char trailer[4];
+        snprintf(trailer, sizeof(trailer), "#%02x", checksum);
+        sendRaw("$" + data + trailer);
+        return receiveReply();
+    }
+
+    std::string receiveReply() {
+        int c;
+        while ((c = receiveByte()) != '$') {
+            if (c < 0) {
+                return "<timeout>";
+            }
+        }
+
+        std::string reply;
+        while ((c = receiveByte()) != '#') {
+            if (c < 0) {
+                return "<timeout>";
+            }
+            reply += (char) c;
+        }
+        receiveByte();
+        receiveByte();
+        sendRaw("+");
+        return reply;
+    }
+};
+
+// PC is the little endian word after V0-VF and I in the g packet
+static std::string pcOf(const std::string& registers) {
+    return registers.substr(36, 4);
+}
+
+TEST_CASE("GDB Stub Session", "") {
+    InputHandler inputHandler{};
+    SimpleDisplay display{};
+    Chip8 chip8{display, inputHandler, COSMAC_VIP_QUIRKS};
+    Debugger debugger{};
+    chip8.setDebugger(&debugger);
+
+    // V0 = 5, I = 0x300, then BCD of V0 at I and V0 + 1 forever
+    const uint8_t rom[]{ 0x60, 0x05, 0xA3, 0x00, 0xF0, 0x33, 0x70, 0x01, 0x12, 0x04 };
+    REQUIRE(chip8.loadRom(rom, sizeof(rom)));
+
+    GdbStub stub{chip8, debugger};
+    REQUIRE(stub.listen(0));
+    REQUIRE(stub.getPort() != 0);
+
+    RunControl control{};
+    std::thread stubThread(&GdbStub::serve, &stub, std::ref(control));
+    std::thread cpuThread(&Chip8::resume, &chip8, std::ref(control));
+
+    {
+        TestClient client{stub.getPort()};
+        REQUIRE(client.transact("qSupported:swbreak+") == "PacketSize=1000");
+        REQUIRE(client.transact("?") == "S05");
+        REQUIRE(debugger.isStopped());
+
+        // Breakpoint stops before the instruction
+        REQUIRE(client.transact("Z0,206,2") == "OK");
+        REQUIRE(client.transact("c") == "S05");
+        REQUIRE(pcOf(client.transact("g")) == "0602");
+
+        // BCD of V0 has just been written
+        int v0{ std::stoi(client.transact("p0"), nullptr, 16) };
+        char bcd[8];
+        snprintf(bcd, sizeof(bcd), "%02x%02x%02x", v0 / 100, v0 / 10 % 10, v0 % 10);
+        REQUIRE(client.transact("m300,3") == bcd);
+
+        // Single step and register writes
+        REQUIRE(client.transact("s") == "S05");
+        REQUIRE(pcOf(client.transact("g")) == "0802");
+        REQUIRE(client.transact("P0=2a") == "OK");
+        REQUIRE(client.transact("p0") == "2a");
+        REQUIRE(client.transact("p11") == "0802");
+
+        // Memory writes
+        REQUIRE(client.transact("M310,2:abcd") == "OK");
+        REQUIRE(client.transact("m310,2") == "abcd");
+        REQUIRE(client.transact("M310,2:ab") == "E01");
+
+        // Write watchpoint is hit by FX33
+        REQUIRE(client.transact("z0,206,2") == "OK");
+        REQUIRE(client.transact("Z2,302,1") == "OK");
+        REQUIRE(client.transact("c") == "T05watch:302;");
+        REQUIRE(pcOf(client.transact("g")) == "0602");
+        REQUIRE(client.transact("z2,302,1") == "OK");
+        REQUIRE(client.transact("z2,302,1") == "E01");
+
+        // Interrupt while running freely
+        REQUIRE(client.transact("vMustReplyEmpty").empty());
+        client.sendRaw("$c#63");
+        std::this_thread::sleep_for(std::chrono::milliseconds(100));
+        client.sendRaw("\x03");
+        REQUIRE(client.receiveReply() == "S02");
+
+        REQUIRE(client.transact("D") == "OK");
+    }
+
+    stubThread.join();
+    REQUIRE(!debugger.isStopped());
+    REQUIRE(!debugger.hasBreakpoint(0x206));
+
+    control.stop();
+    cpuThread.join();
+}
@@ -0,0 +1,145 @@
+#include <catch2/catch_test_macros.hpp>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <iterator>
+#include <map>
+#include <memory>
+#include <set>
+#include <sstream>
+#include <string>
+#include <type_traits>
+#include <vector>
+#include "../src/displays/advanced_display.h"
+#include "../src/displays/simple_display.h"
+#include "../src/emulators/chip8.h"
+#include "../src/emulators/schip.h"
+
+// Runs every ROM in the golden file headlessly and compares screen hashes at its checkpoints
+// Set CHIP8_UPDATE_GOLDEN=1 to rewrite the hashes after an intended change in visible behaviour
+
+struct GoldenEntry {
+    std::string rom;
+    std::string core;
+    int frame;
+    uint64_t hash;
+};
+
+static std::vector<GoldenEntry> readGoldenFile(const std::string& path) {
+    std::ifstream input{ path };
+    REQUIRE(input.is_open());
+
+    std::vector<GoldenEntry> entries;
+    std::string line;
+    while (std::getline(input, line)) {
+        if (line.empty() || line[0] == '#') {
+            continue;
+        }
+
+        // ROM names may contain spaces, so the name ends at the tab
+        std::istringstream fields{ line.substr(line.find('\t') + 1) };
+        GoldenEntry entry{ line.substr(0, line.find('\t')) };
+        fields >> entry.core >> entry.frame >> std::hex >> entry.hash;
+        REQUIRE(!fields.fail());
+        entries.push_back(entry);
+    }
+    return entries;
+}
+
+static void writeGoldenFile(const std::string& path, const std::vector<GoldenEntry>& entries) {
+    std::ofstream output{ path };
+    output << "# rom<TAB>core frame hash, regenerate with CHIP8_UPDATE_GOLDEN=1\n";
+    for (auto& entry : entries) {
+        char hash[17];
+        snprintf(hash, sizeof(hash), "%016llx", (unsigned long long) entry.hash);
+        output << entry.rom << '\t' << entry.core << ' ' << entry.frame << ' ' << hash << '\n';
+    }
+}
+
+static std::vector<uint8_t> readRom(const std::string& name) {
+    std::ifstream input{ std::string(TEST_ROMS_DIR) + "/" + name, std::ios::binary };
+    REQUIRE(input.is_open());
+    return { std::istreambuf_iterator<char>(input), std::istreambuf_iterator<char>() };
+}
+
+// Hash of the screen after each checkpoint, with no input and a fixed seed
+template<typename Core, typename Display>
+static std::map<int, uint64_t> runCheckpoints(const std::string& name, const std::set<int>& frames) {
+    std::vector<uint8_t> rom{ readRom(name) };
+
+    Display display{};
+    InputHandler inputHandler{};
+    std::unique_ptr<Core> core;
+    if constexpr (std::is_same_v<Core, Chip8>) {
+        core = std::make_unique<Core>(display, inputHandler, MODERN_CHIP8_QUIRKS);
+    } else {
+        core = std::make_unique<Core>(display, inputHandler);
+    }
+    core->seedRandom(0);
+    REQUIRE(core->loadRom(rom.data(), rom.size()));
+
+    std::map<int, uint64_t> hashes;
+    int frame{};
+    bool isRunning{ true };
+    for (int checkpoint : frames) {
+        // A ROM that exits keeps its last screen
+        if (isRunning) {
+            isRunning = core->runFrames(checkpoint - frame);
+        }
+        frame = checkpoint;
+        hashes[checkpoint] = display.getFrameHash();
+    }
+    return hashes;
+}
+
+TEST_CASE("Frame Hash Changes With Every Pixel") {
+    SimpleDisplay display{};
+    std::set<uint64_t> hashes{ display.getFrameHash() };
+
+    for (int y{}; y < HEIGHT; y++) {
+        for (int x{}; x < WIDTH; x++) {
+            display.flipPixel(x, y);
+            hashes.insert(display.getFrameHash());
+            display.flipPixel(x, y);
+        }
+    }
+    REQUIRE(hashes.size() == WIDTH * HEIGHT + 1);
+
+    AdvancedDisplay lores{};
+    AdvancedDisplay hires{};
+    hires.switchOperationalMode(true);
+    REQUIRE(lores.getFrameHash() != hires.getFrameHash());
+}
+
+TEST_CASE("Test ROMs Match Golden Frame Hashes") {
+    std::string path{ std::string(GOLDEN_DIR) + "/frame_hashes.txt" };
+    std::vector<GoldenEntry> entries{ readGoldenFile(path) };
+    REQUIRE(!entries.empty());
+
+    // One run per ROM and core covers all of its checkpoints
+    std::map<std::pair<std::string, std::string>, std::set<int>> runs;
+    for (auto& entry : entries) {
+        runs[{ entry.rom, entry.core }].insert(entry.frame);
+    }
+
+    std::map<std::pair<std::string, std::string>, std::map<int, uint64_t>> results;
+    for (auto& [run, frames] : runs) {
+        REQUIRE((run.second == "chip8" || run.second == "schip"));
+        results[run] = run.second == "chip8" ? runCheckpoints<Chip8, SimpleDisplay>(run.first, frames)
+                                             : runCheckpoints<SChip, AdvancedDisplay>(run.first, frames);
+    }
+
+    if (std::getenv("CHIP8_UPDATE_GOLDEN") != nullptr) {
+        for (auto& entry : entries) {
+            entry.hash = results[{ entry.rom, entry.core }][entry.frame];
+        }
+        writeGoldenFile(path, entries);
+        WARN("Golden file rewritten: " << path);
+        return;
+    }
+
+    for (auto& entry : entries) {
+        INFO(entry.rom << " on " << entry.core << " at frame " << entry.frame);
+        REQUIRE(results[{ entry.rom, entry.core }][entry.frame] == entry.hash);
+    }
+}
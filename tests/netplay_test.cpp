@@ -0,0 +1,251 @@
+#include <catch2/catch_test_macros.hpp>
+#include <atomic>
+#include <chrono>
+#include <deque>
+#include <random>
+#include <thread>
+#include <tuple>
+#include <vector>
+#include "../src/displays/simple_display.h"
+#include "../src/emulators/chip8.h"
+#include "../src/extras/sha1.h"
+#include "../src/netplay/netplay_peer.h"
+#include "../src/netplay/rollback_session.h"
+#include "../src/netplay/udp_socket.h"
+
+// Adds a random number to V2 for every key held, then stores V2 and draws its digit at a random column
+const uint8_t ROM[]{ 0xC0, 0xFF, 0x61, 0x00, 0xE1, 0x9E, 0x12, 0x0C, 0x72, 0x01, 0x82, 0x04, 0x71, 0x01, 0x31, 0x10,
+                     0x12, 0x04, 0xA3, 0x00, 0xF2, 0x33, 0xF2, 0x29, 0xD0, 0x15, 0x12, 0x00 };
+constexpr uint32_t FRAME_COUNT{300};
+
+// Keys held for a few frames at a time, like a player would
+static std::vector<uint16_t> makeInputs(uint32_t seed) {
+    std::mt19937 random{ seed };
+    std::vector<uint16_t> inputs;
+    while (inputs.size() < FRAME_COUNT) {
+        uint16_t keys{ (uint16_t) (random() & random()) };
+        for (uint32_t hold{ (uint32_t) (random() % 10 + 1) }; hold > 0 && inputs.size() < FRAME_COUNT; hold--) {
+            inputs.push_back(keys);
+        }
+    }
+    return inputs;
+}
+
+// One player's machine
+struct Player {
+    SimpleDisplay display{};
+    InputHandler inputHandler{};
+    Chip8 core{ display, inputHandler, COSMAC_VIP_QUIRKS };
+    RollbackSession<Chip8> session{ core, inputHandler };
+
+    explicit Player(uint32_t seed) {
+        core.seedRandom(seed);
+        core.loadRom(ROM, sizeof(ROM));
+    }
+};
+
+// Both players' inputs on one machine without any prediction
+static void requireMatchesLocalRun(Chip8& core, SimpleDisplay& display, uint32_t seed,
+                                   const std::vector<uint16_t>& first, const std::vector<uint16_t>& second) {
+    SimpleDisplay referenceDisplay{};
+    InputHandler inputHandler{};
+    Chip8 reference{ referenceDisplay, inputHandler, COSMAC_VIP_QUIRKS };
+    reference.seedRandom(seed);
+    REQUIRE(reference.loadRom(ROM, sizeof(ROM)));
+    for (uint32_t frame{}; frame < FRAME_COUNT; frame++) {
+        inputHandler.setKeyState(first[frame] | second[frame]);
+        REQUIRE(reference.runFrames(1));
+    }
+
+    DebugRegisters registers{ core.getDebugRegisters() };
+    DebugRegisters referenceRegisters{ reference.getDebugRegisters() };
+    for (int i{}; i < 16; i++) {
+        REQUIRE(registers.v[i] == referenceRegisters.v[i]);
+    }
+    REQUIRE(registers.pc == referenceRegisters.pc);
+    REQUIRE(registers.i == referenceRegisters.i);
+    REQUIRE(core.getFrameCount() == FRAME_COUNT);
+    REQUIRE(core.getInstructionCount() == reference.getInstructionCount());
+    REQUIRE(display.getFrameHash() == referenceDisplay.getFrameHash());
+    for (int address{}; address < RAM_SIZE; address++) {
+        REQUIRE(core.readMemory(address) == reference.readMemory(address));
+    }
+}
+
+// Forwards between two peers, dropping every dropInterval-th packet and holding the rest back for delay
+class TestRelay {
+private:
+    struct Held {
+        std::chrono::steady_clock::time_point due;
+        UdpEndpoint to;
+        std::vector<uint8_t> packet;
+    };
+
+    UdpSocket socket;
+    UdpEndpoint first;
+    UdpEndpoint second;
+    int dropInterval;
+    std::chrono::milliseconds delay;
+    std::atomic<bool> isStopping;
+    std::thread thread;
+
+    void run() {
+        std::deque<Held> held;
+        uint8_t buffer[256];
+        int received{};
+        while (!isStopping) {
+            socket.waitForData(1);
+
+            UdpEndpoint from{};
+            int size;
+            while ((size = socket.receiveFrom(buffer, sizeof(buffer), from)) >= 0) {
+                if (++received % dropInterval == 0) {
+                    continue;
+                }
+                UdpEndpoint to{ from == first ? second : first };
+                held.push_back({ std::chrono::steady_clock::now() + delay, to, { buffer, buffer + size } });
+            }
+
+            while (!held.empty() && held.front().due <= std::chrono::steady_clock::now()) {
+                socket.sendTo(held.front().to, held.front().packet.data(), held.front().packet.size());
+                held.pop_front();
+            }
+        }
+    }
+
+public:
+    TestRelay(int dropInterval, std::chrono::milliseconds delay): first{}, second{}, dropInterval{dropInterval},
+        delay{delay}, isStopping{} {
+        socket.open(0);
+    }
+
+    ~TestRelay() {
+        isStopping = true;
+        if (thread.joinable()) {
+            thread.join();
+        }
+    }
+
+    [[nodiscard]] UdpEndpoint getEndpoint() const {
+        return { 0x7F000001, socket.getPort() };
+    }
+
+    void start(uint16_t firstPort, uint16_t secondPort) {
+        first = { 0x7F000001, firstPort };
+        second = { 0x7F000001, secondPort };
+        thread = std::thread(&TestRelay::run, this);
+    }
+};
+
+TEST_CASE("Netplay Endpoints", "") {
+    UdpEndpoint endpoint{};
+    REQUIRE(parseEndpoint("192.168.1.20:7050", endpoint));
+    REQUIRE(endpoint.address == 0xC0A80114);
+    REQUIRE(endpoint.port == 7050);
+    REQUIRE(parseEndpoint("localhost:1", endpoint));
+    REQUIRE(endpoint.address == 0x7F000001);
+
+    REQUIRE(!parseEndpoint("192.168.1.20", endpoint));
+    REQUIRE(!parseEndpoint("192.168.1.20:0", endpoint));
+    REQUIRE(!parseEndpoint("192.168.1.20:70000", endpoint));
+    REQUIRE(!parseEndpoint("example.com:7050", endpoint));
+}
+
+TEST_CASE("Rollback Sessions Match A Local Run", "") {
+    constexpr uint32_t SEED{42};
+    std::vector<uint16_t> firstInputs{ makeInputs(1) };
+    std::vector<uint16_t> secondInputs{ makeInputs(2) };
+    Player first{SEED};
+    Player second{SEED};
+
+    // Inputs arrive from zero to six frames late, with the delay changing all the time
+    std::mt19937 random{ 3 };
+    auto deliver{ [&](Player& from, Player& to, const std::vector<uint16_t>& inputs) {
+        uint32_t latency{ from.session.getFrame() < FRAME_COUNT ? (uint32_t) (random() % 7) : 0 };
+        for (uint32_t frame{ to.session.getConfirmedFrame() }; frame + latency < from.session.getFrame(); frame++) {
+            to.session.addRemoteInput(frame, inputs[frame]);
+        }
+    } };
+
+    while (first.session.getConfirmedFrame() < FRAME_COUNT || second.session.getConfirmedFrame() < FRAME_COUNT ||
+           first.session.getFrame() < FRAME_COUNT || second.session.getFrame() < FRAME_COUNT) {
+        if (first.session.getFrame() < FRAME_COUNT && first.session.canAdvance()) {
+            REQUIRE(first.session.advance(firstInputs[first.session.getFrame()]));
+        }
+        if (second.session.getFrame() < FRAME_COUNT && second.session.canAdvance()) {
+            REQUIRE(second.session.advance(secondInputs[second.session.getFrame()]));
+        }
+        deliver(first, second, firstInputs);
+        deliver(second, first, secondInputs);
+    }
+
+    // The last frames may have run on predictions, rolling back settles them on the inputs that arrived
+    for (Player* player : { &first, &second }) {
+        REQUIRE(player->session.getRollbackCount() > 0);
+        REQUIRE(player->session.rollBack());
+        requireMatchesLocalRun(player->core, player->display, SEED, firstInputs, secondInputs);
+    }
+}
+
+TEST_CASE("Netplay Over A Lossy Relay", "") {
+    std::vector<uint16_t> firstInputs{ makeInputs(4) };
+    std::vector<uint16_t> secondInputs{ makeInputs(5) };
+
+    // Every fourth packet is lost and the rest take three milliseconds
+    TestRelay relay{ 4, std::chrono::milliseconds(3) };
+    Sha1Digest digest{ sha1(ROM, sizeof(ROM)) };
+    NetplayPeer firstPeer{};
+    NetplayPeer secondPeer{};
+    REQUIRE(firstPeer.open(0, relay.getEndpoint(), digest));
+    REQUIRE(secondPeer.open(0, relay.getEndpoint(), digest));
+    relay.start(firstPeer.getPort(), secondPeer.getPort());
+
+    bool isSecondConnected{};
+    std::thread secondThread([&]() {
+        isSecondConnected = secondPeer.connect(5000);
+    });
+    REQUIRE(firstPeer.connect(5000));
+    secondThread.join();
+    REQUIRE(isSecondConnected);
+    REQUIRE(firstPeer.getSeed() == secondPeer.getSeed());
+
+    Player first{ firstPeer.getSeed() };
+    Player second{ secondPeer.getSeed() };
+    auto deadline{ std::chrono::steady_clock::now() + std::chrono::seconds(20) };
+    while (first.session.getConfirmedFrame() < FRAME_COUNT || second.session.getConfirmedFrame() < FRAME_COUNT ||
+           first.session.getFrame() < FRAME_COUNT || second.session.getFrame() < FRAME_COUNT) {
+        REQUIRE(std::chrono::steady_clock::now() < deadline);
+
+        for (auto [player, peer, inputs] : { std::tuple{ &first, &firstPeer, &firstInputs },
+                                             std::tuple{ &second, &secondPeer, &secondInputs } }) {
+            player->session.receiveInputs(*peer);
+            if (player->session.getFrame() < FRAME_COUNT && player->session.canAdvance()) {
+                REQUIRE(player->session.advance((*inputs)[player->session.getFrame()]));
+            }
+            player->session.sendInputs(*peer);
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+
+    for (Player* player : { &first, &second }) {
+        REQUIRE(player->session.rollBack());
+        requireMatchesLocalRun(player->core, player->display, firstPeer.getSeed(), firstInputs, secondInputs);
+    }
+}
+
+TEST_CASE("Netplay Refuses Another ROM", "") {
+    TestRelay relay{ 1000, std::chrono::milliseconds(0) };
+    NetplayPeer firstPeer{};
+    NetplayPeer secondPeer{};
+    REQUIRE(firstPeer.open(0, relay.getEndpoint(), sha1(ROM, sizeof(ROM))));
+    REQUIRE(secondPeer.open(0, relay.getEndpoint(), sha1(ROM, sizeof(ROM) - 2)));
+    relay.start(firstPeer.getPort(), secondPeer.getPort());
+
+    bool isSecondConnected{ true };
+    std::thread secondThread([&]() {
+        isSecondConnected = secondPeer.connect(2000);
+    });
+    REQUIRE(!firstPeer.connect(2000));
+    secondThread.join();
+    REQUIRE(!isSecondConnected);
+}
@@ -0,0 +1,101 @@
+#include <catch2/catch_test_macros.hpp>
+#include <vector>
+#include "../src/displays/simple_display.h"
+#include "../src/emulators/recompiled_chip8.h"
+
+// Generated from test_roms at build time by rom_recompiler
+extern const RecompiledRom pongRom;
+extern const RecompiledRom snakeRom;
+extern const RecompiledRom octopegRom;
+extern const RecompiledRom horseyJumpRom;
+extern const RecompiledRom breakoutRom;
+
+// Runs the recompiled ROM and the interpreter side by side, comparing the machines after every frame
+static void checkAgainstInterpreter(const RecompiledRom& compiled, const Quirks& quirks, int frameCount,
+                                    uint16_t writeAddress = 0) {
+    InputHandler inputHandler{};
+    SimpleDisplay display{};
+    RecompiledChip8 recompiled{display, inputHandler, quirks, compiled};
+    InputHandler referenceInputHandler{};
+    SimpleDisplay referenceDisplay{};
+    Chip8 reference{referenceDisplay, referenceInputHandler, quirks};
+
+    for (Chip8* core : std::vector<Chip8*>{ &recompiled, &reference }) {
+        core->seedRandom(1);
+        core->setInstructionsPerFrame(37);
+        REQUIRE(core->loadRom(compiled.rom, compiled.size));
+    }
+    REQUIRE(recompiled.isRunningCompiledCode());
+
+    for (int frame{}; frame < frameCount; frame++) {
+        // A different key held every quarter second, with gaps
+        uint16_t keys{ (uint16_t) (frame / 15 % 3 == 2 ? 0 : 1 << (frame / 15 % 16)) };
+        inputHandler.setKeyState(keys);
+        referenceInputHandler.setKeyState(keys);
+
+        if (writeAddress != 0 && frame == frameCount / 2) {
+            recompiled.writeMemory(writeAddress, reference.readMemory(writeAddress));
+            reference.writeMemory(writeAddress, reference.readMemory(writeAddress));
+            REQUIRE(!recompiled.isRunningCompiledCode());
+        }
+
+        bool isRunning{ reference.runFrames(1) };
+        REQUIRE(recompiled.runFrames(1) == isRunning);
+
+        DebugRegisters expected{ reference.getDebugRegisters() };
+        DebugRegisters actual{ recompiled.getDebugRegisters() };
+        for (int i{}; i < 16; i++) {
+            REQUIRE(actual.v[i] == expected.v[i]);
+        }
+        REQUIRE(actual.i == expected.i);
+        REQUIRE(actual.pc == expected.pc);
+        REQUIRE(actual.sp == expected.sp);
+        REQUIRE(actual.delayTimer == expected.delayTimer);
+        REQUIRE(actual.soundTimer == expected.soundTimer);
+        REQUIRE(recompiled.getInstructionCount() == reference.getInstructionCount());
+        REQUIRE(display.getFrameHash() == referenceDisplay.getFrameHash());
+        if (!isRunning) {
+            break;
+        }
+    }
+}
+
+TEST_CASE("Recompiled ROMs Match The Interpreter", "") {
+    for (const RecompiledRom* compiled : { &pongRom, &snakeRom, &octopegRom, &horseyJumpRom, &breakoutRom }) {
+        for (const Quirks& quirks : { COSMAC_VIP_QUIRKS, MODERN_CHIP8_QUIRKS }) {
+            checkAgainstInterpreter(*compiled, quirks, 600);
+        }
+    }
+}
+
+TEST_CASE("Writes To Compiled Code Fall Back To The Interpreter", "") {
+    checkAgainstInterpreter(pongRom, COSMAC_VIP_QUIRKS, 300, 0x200);
+}
+
+TEST_CASE("Interpreted Stores To Compiled Code Fall Back To The Interpreter", "") {
+    InputHandler inputHandler{};
+    SimpleDisplay display{};
+    RecompiledChip8 recompiled{display, inputHandler, COSMAC_VIP_QUIRKS, pongRom};
+    REQUIRE(recompiled.loadRom(pongRom.rom, pongRom.size));
+    REQUIRE(recompiled.isRunningCompiledCode());
+
+    // FX55 outside the ROM stores V0 over the first compiled byte, then the program waits on a jump to itself
+    uint16_t target{ pongRom.blocks[0] };
+    const uint8_t store[]{ 0xF0, 0x55, 0x16, 0x02 };
+    for (uint16_t i{}; i < sizeof(store); i++) {
+        recompiled.writeMemory(0x600 + i, store[i]);
+    }
+    DebugRegisters registers{ recompiled.getDebugRegisters() };
+    registers.v[0] = (uint8_t) ~recompiled.readMemory(target);
+    registers.i = target;
+    registers.pc = 0x600;
+    recompiled.setDebugRegisters(registers);
+    REQUIRE(recompiled.isRunningCompiledCode());
+
+    // An attached debugger sends the frame through Chip8::runFrames, which does not see the store as it happens
+    Debugger debugger{};
+    recompiled.setDebugger(&debugger);
+    REQUIRE(recompiled.runFrames(1));
+    REQUIRE(recompiled.readMemory(target) == registers.v[0]);
+    REQUIRE(!recompiled.isRunningCompiledCode());
+}
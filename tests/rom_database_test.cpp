@@ -0,0 +1,123 @@
+#include <catch2/catch_test_macros.hpp>
+#include <cstdio>
+#include <fstream>
+#include <iterator>
+#include <string>
+#include <vector>
+#include "../src/extras/json.h"
+#include "../src/extras/rom_database.h"
+#include "../src/extras/sha1.h"
+
+static std::vector<uint8_t> readRom(const std::string& name) {
+    std::ifstream input{ std::string(TEST_ROMS_DIR) + "/" + name, std::ios::binary };
+    REQUIRE(input.is_open());
+    return { std::istreambuf_iterator<char>(input), std::istreambuf_iterator<char>() };
+}
+
+static std::string hashOf(const std::string& text) {
+    return toHex(sha1(reinterpret_cast<const uint8_t*>(text.data()), text.size()));
+}
+
+TEST_CASE("SHA-1 Digests") {
+    REQUIRE(hashOf("") == "da39a3ee5e6b4b0d3255bfef95601890afd80709");
+    REQUIRE(hashOf("abc") == "a9993e364706816aba3e25717850c26c9cd0d89d");
+
+    // 56 bytes, so the length no longer fits in the last block
+    REQUIRE(hashOf("abcdbcdecdefdefgefghfghighijhijkijkljklmklmnlmnomnopnopq") == "84983e441c3bd26ebaae4aa1f95129e5e54670f1");
+    REQUIRE(hashOf(std::string(1000, 'a')) == "291e9a6c66994949b57ba5e650361e98fc36b1ba");
+
+    Sha1Digest digest{};
+    REQUIRE(parseSha1("A9993E364706816ABA3E25717850C26C9CD0D89D", digest));
+    REQUIRE(toHex(digest) == "a9993e364706816aba3e25717850c26c9cd0d89d");
+    REQUIRE(!parseSha1("a9993e", digest));
+    REQUIRE(!parseSha1("g9993e364706816aba3e25717850c26c9cd0d89d", digest));
+}
+
+TEST_CASE("JSON Parsing") {
+    JsonValue value;
+    std::string error;
+
+    REQUIRE(JsonValue::parse(R"({ "a": [1, -2.5e1, true, null], "b": { "c": "x\"é😀" } })", value, error));
+    REQUIRE(value.isObject());
+    REQUIRE(value.find("a")->getItems().size() == 4);
+    REQUIRE(value.find("a")->getItems()[1].asNumber() == -25);
+    REQUIRE(value.find("a")->getItems()[2].asBool());
+    REQUIRE(value.find("a")->getItems()[3].getType() == JsonValue::Type::NUL);
+    REQUIRE(value.find("b")->find("c")->asString() == "x\"\xC3\xA9\xF0\x9F\x98\x80");
+    REQUIRE(value.find("missing") == nullptr);
+
+    REQUIRE(!JsonValue::parse(R"({ "a": 1 )", value, error));
+    REQUIRE(!JsonValue::parse(R"([1, 2] x)", value, error));
+    REQUIRE(!JsonValue::parse(R"("unterminated)", value, error));
+    REQUIRE(!JsonValue::parse(std::string(100, '['), value, error));
+
+    // Escaped surrogate pairs decode to one character, lone or mismatched halves are rejected
+    REQUIRE(JsonValue::parse(R"("\ud83d\ude00")", value, error));
+    REQUIRE(value.asString() == "\xF0\x9F\x98\x80");
+    REQUIRE(!JsonValue::parse(R"("\ud83d")", value, error));
+    REQUIRE(!JsonValue::parse(R"("\ud83dx")", value, error));
+    REQUIRE(!JsonValue::parse(R"("\ude00")", value, error));
+    REQUIRE(!JsonValue::parse(R"("\ud83d\u0041")", value, error));
+    REQUIRE(!JsonValue::parse(R"("\ud83d\ud83d")", value, error));
+}
+
+TEST_CASE("ROM Database Lookup") {
+    RomDatabase database{};
+    REQUIRE(database.loadJson(ROM_DB_DIR));
+
+    // The megachip8 only entry has no core to run on
+    REQUIRE(database.size() == 3);
+
+    std::string indexPath{ "rom_database_test.idx" };
+    RomDatabase index{};
+    REQUIRE(database.writeIndex(indexPath));
+    REQUIRE(index.loadIndex(indexPath));
+    std::remove(indexPath.c_str());
+
+    for (RomDatabase* source : { &database, &index }) {
+        RomInfo info{};
+
+        std::vector<uint8_t> logo{ readRom("1-chip8-logo.ch8") };
+        REQUIRE(source->find(logo.data(), logo.size(), info));
+        REQUIRE(info.title == "Chip-8 Logo");
+        REQUIRE(info.platform == Platform::CHIP8);
+        REQUIRE(info.quirks.getFlags() == COSMAC_VIP_QUIRKS.getFlags());
+        REQUIRE(info.instructionsPerFrame == INSTRUCTIONS_PER_FRAME);
+
+        // Platform quirks, then the per ROM overrides, tickrate and colours
+        std::vector<uint8_t> tetris{ readRom("Tetris.ch8") };
+        REQUIRE(source->find(tetris.data(), tetris.size(), info));
+        REQUIRE(info.platform == Platform::CHIP8);
+        REQUIRE(!info.quirks.shiftUsesVY);
+        REQUIRE(info.quirks.loadStoreIncrementsI);
+        REQUIRE(!info.quirks.jumpUsesVX);
+        REQUIRE(!info.quirks.clipSprites);
+        REQUIRE(info.instructionsPerFrame == 12);
+        REQUIRE(info.backgroundColor == 0xFF1A1C2C);
+        REQUIRE(info.foregroundColor == 0xFFF4F4F4);
+
+        std::vector<uint8_t> copter{ readRom("sweetcopter.ch8") };
+        REQUIRE(source->find(copter.data(), copter.size(), info));
+        REQUIRE(info.title == "Sweet Copter \xE2\x80\x93 \"Octojam\"");
+        REQUIRE(info.platform == Platform::SCHIP);
+        REQUIRE(info.quirks.getFlags() == SCHIP_QUIRKS.getFlags());
+        REQUIRE(info.instructionsPerFrame == 200);
+
+        std::vector<uint8_t> snake{ readRom("snake.ch8") };
+        REQUIRE(!source->find(snake.data(), snake.size(), info));
+    }
+}
+
+TEST_CASE("ROM Database Rejects Broken Index") {
+    std::string indexPath{ "rom_database_broken.idx" };
+    {
+        std::ofstream output{ indexPath, std::ios::binary };
+        output << "C8ROMDB1 but much too short";
+    }
+
+    RomDatabase index{};
+    REQUIRE(!index.loadIndex(indexPath));
+    REQUIRE(index.size() == 0);
+    REQUIRE(!index.loadIndex("missing.idx"));
+    std::remove(indexPath.c_str());
+}
@@ -1,4 +1,7 @@
 #include <catch2/catch_test_macros.hpp>
+#include <cstdio>
+#include <fstream>
+#include <sstream>
 #include "../src/emulators/schip.h"
 #include "../src/constants.h"
 
@@ -22,7 +25,7 @@ public:
         SChip::decode(ins);
     }
 
-    uint8_t* getMemory() {
+    PagedMemory& getMemory() {
         return memory;
     }
 
@@ -56,7 +59,7 @@ TEST_CASE("SChip Font Loaded Correctly") {
     AdvancedDisplay display{};
     SChipTest schip{display, inputHandler};
 
-    uint8_t* mem{schip.getMemory()};
+    PagedMemory& mem{schip.getMemory()};
     int count{};
 
     for (int i{0x50}; i <= 0x9F; i++) {
@@ -73,36 +76,6 @@ TEST_CASE("SChip Font Loaded Correctly") {
     REQUIRE(count == 240);
 }
 
-TEST_CASE("SChip Correct Helper Function") {
-    TestInputHandler inputHandler{};
-    AdvancedDisplay display{};
-    SChipTest schip{display, inputHandler};
-
-    SECTION("Correct Small Sprite Decode") {
-        std::vector<bool> v(8);
-        schip.decodeTest(0xA050); // Point index_register to 0
-        schip.decodeSmallSprite(schip.getIndex(), v);
-
-        for (int i{}; i < 4; i++) {
-            REQUIRE(v[i]);
-        }
-
-        for (int i{4}; i < 8; i++) {
-            REQUIRE(!v[i]);
-        }
-    }
-
-    SECTION("Correct Big Sprite Decode") {
-        std::vector<bool> v(16);
-        schip.getMemory()[0] = 0xFF;
-        schip.getMemory()[1] = 0xFF;
-        schip.decodeBigSprite(schip.getIndex(), v);
-        for (int i{}; i < 16; i++) {
-            REQUIRE(v[i]);
-        }
-    }
-}
-
 TEST_CASE("SChip Registers Do Not Overflow") {
     TestInputHandler inputHandler{};
     AdvancedDisplay display{};
@@ -217,7 +190,7 @@ TEST_CASE("SChip Correct 0 Instructions") {
         // Check if all pixel are white
         for (int i{}; i < WIDTH; i++) {
             for (int j{}; j < HEIGHT; j++) {
-                REQUIRE(display.getDisplay()[i][j] == 1);
+                REQUIRE(display.getPixel(i, j) == 1);
             }
         }
 
@@ -226,7 +199,7 @@ TEST_CASE("SChip Correct 0 Instructions") {
         // Check if all pixel are black (e.g. display is cleared)
         for (int i{}; i < WIDTH; i++) {
             for (int j{}; j < HEIGHT; j++) {
-                REQUIRE(display.getDisplay()[i][j] == 0);
+                REQUIRE(display.getPixel(i, j) == 0);
             }
         }
 
@@ -243,7 +216,7 @@ TEST_CASE("SChip Correct 0 Instructions") {
         // Check if all pixel are white
         for (int i{}; i < 128; i++) {
             for (int j{}; j < 64; j++) {
-                REQUIRE(display.getDisplay()[i][j] == 1);
+                REQUIRE(display.getPixel(i, j) == 1);
             }
         }
 
@@ -252,7 +225,7 @@ TEST_CASE("SChip Correct 0 Instructions") {
         // Check if all pixel are black (e.g. display is cleared)
         for (int i{}; i < 128; i++) {
             for (int j{}; j < 64; j++) {
-                REQUIRE(display.getDisplay()[i][j] == 0);
+                REQUIRE(display.getPixel(i, j) == 0);
             }
         }
     }
@@ -264,9 +237,9 @@ TEST_CASE("SChip Correct 0 Instructions") {
             display.drawPixel(0, i, true);
         }
         schip.decodeTest(0x00CF);
-        REQUIRE(display.getDisplay()[0][14] == 0);
+        REQUIRE(display.getPixel(0, 14) == 0);
         for (int i{15}; i < 30; i++) {
-            REQUIRE(display.getDisplay()[0][i] == 1);
+            REQUIRE(display.getPixel(0, i) == 1);
         }
 
         display.clearScreen();
@@ -277,9 +250,9 @@ TEST_CASE("SChip Correct 0 Instructions") {
             display.drawPixel(0, i, true);
         }
         schip.decodeTest(0x00C5);
-        REQUIRE(display.getDisplay()[0][1] == 0);
+        REQUIRE(display.getPixel(0, 1) == 0);
         for (int i{2}; i < 7; i++) {
-            REQUIRE(display.getDisplay()[0][i] == 1);
+            REQUIRE(display.getPixel(0, i) == 1);
         }
     }
 
@@ -290,8 +263,8 @@ TEST_CASE("SChip Correct 0 Instructions") {
             display.drawPixel(i, 0, true);
         }
         schip.decodeTest(0x00FB);
-        REQUIRE(display.getDisplay()[3][0] == 0);
-        REQUIRE(display.getDisplay()[4][0] == 1);
+        REQUIRE(display.getPixel(3, 0) == 0);
+        REQUIRE(display.getPixel(4, 0) == 1);
 
         // LORES
         schip.decodeTest(0x00FE);
@@ -299,8 +272,8 @@ TEST_CASE("SChip Correct 0 Instructions") {
             display.drawPixel(i, 0, true);
         }
         schip.decodeTest(0x00FB);
-        REQUIRE(display.getDisplay()[1][0] == 0);
-        REQUIRE(display.getDisplay()[2][0] == 1);
+        REQUIRE(display.getPixel(1, 0) == 0);
+        REQUIRE(display.getPixel(2, 0) == 1);
     }
 
     SECTION("Correct 00FC Instruction") {
@@ -310,8 +283,8 @@ TEST_CASE("SChip Correct 0 Instructions") {
             display.drawPixel(i, 0, true);
         }
         schip.decodeTest(0x00FC);
-        REQUIRE(display.getDisplay()[0][0] == 1);
-        REQUIRE(display.getDisplay()[1][0] == 0);
+        REQUIRE(display.getPixel(0, 0) == 1);
+        REQUIRE(display.getPixel(1, 0) == 0);
 
         // LORES
         schip.decodeTest(0x00FE);
@@ -319,8 +292,8 @@ TEST_CASE("SChip Correct 0 Instructions") {
             display.drawPixel(i, 0, true);
         }
         schip.decodeTest(0x00FC);
-        REQUIRE(display.getDisplay()[0][0] == 1);
-        REQUIRE(display.getDisplay()[1][0] == 0);
+        REQUIRE(display.getPixel(0, 0) == 1);
+        REQUIRE(display.getPixel(1, 0) == 0);
     }
 
     // 00FD, 00FE, 00FF will be tested in operation
@@ -552,23 +525,23 @@ TEST_CASE("SChip Correct Other Instruction Decode", "") {
 //
 //        // Checking 0 has been drawn correctly
 //        for (int i{}; i < 4; i++) {
-//            REQUIRE(display.getDisplay()[0][i] == 1);
+//            REQUIRE(display.getPixel(0, i) == 1);
 //        }
 //
 //        for (int i{1}; i < 4; i++) {
-//            REQUIRE(display.getDisplay()[i][0] == 1);
-//            REQUIRE(display.getDisplay()[i][1] == 0);
-//            REQUIRE(display.getDisplay()[i][2] == 0);
-//            REQUIRE(display.getDisplay()[i][3] == 1);
+//            REQUIRE(display.getPixel(i, 0) == 1);
+//            REQUIRE(display.getPixel(i, 1) == 0);
+//            REQUIRE(display.getPixel(i, 2) == 0);
+//            REQUIRE(display.getPixel(i, 3) == 1);
 //        }
 //
 //        for (int i{}; i < 4; i++) {
-//            REQUIRE(display.getDisplay()[4][i] == 1);
+//            REQUIRE(display.getPixel(4, i) == 1);
 //        }
 //
 //        for (int i{0}; i < 4; i++) {
 //            for (int j{}; j < 5; j++) {
-//                REQUIRE(display.getDisplay()[j][i + 4] == 0);
+//                REQUIRE(display.getPixel(j, i + 4) == 0);
 //            }
 //        }
 //
@@ -584,20 +557,20 @@ TEST_CASE("SChip Correct Other Instruction Decode", "") {
 //        schip.decodeTest(0xD013);
 //
 //        // Checking 0 has been drawn correctly
-//        REQUIRE(display.getDisplay()[0][62] == 1);
-//        REQUIRE(display.getDisplay()[0][63] == 1);
+//        REQUIRE(display.getPixel(0, 62) == 1);
+//        REQUIRE(display.getPixel(0, 63) == 1);
 //
-//        REQUIRE(display.getDisplay()[1][62] == 1);
-//        REQUIRE(display.getDisplay()[1][63] == 0);
+//        REQUIRE(display.getPixel(1, 62) == 1);
+//        REQUIRE(display.getPixel(1, 63) == 0);
 //
-//        REQUIRE(display.getDisplay()[2][62] == 1);
-//        REQUIRE(display.getDisplay()[2][63] == 0);
+//        REQUIRE(display.getPixel(2, 62) == 1);
+//        REQUIRE(display.getPixel(2, 63) == 0);
 //
-//        REQUIRE(display.getDisplay()[3][62] == 0);
-//        REQUIRE(display.getDisplay()[3][63] == 0);
+//        REQUIRE(display.getPixel(3, 62) == 0);
+//        REQUIRE(display.getPixel(3, 63) == 0);
 //
-//        REQUIRE(display.getDisplay()[4][62] == 0);
-//        REQUIRE(display.getDisplay()[4][63] == 0);
+//        REQUIRE(display.getPixel(4, 62) == 0);
+//        REQUIRE(display.getPixel(4, 63) == 0);
 //
 //
 //
@@ -613,7 +586,7 @@ TEST_CASE("SChip Correct Other Instruction Decode", "") {
 //        // Checking 0 is flipped back to blank
 //        for (int i{}; i < 8; i++) {
 //            for (int j{}; j < 5; j++) {
-//                REQUIRE(display.getDisplay()[j][i] == 0);
+//                REQUIRE(display.getPixel(j, i) == 0);
 //            }
 //        }
 //
@@ -636,5 +609,322 @@ TEST_CASE("SChip Correct Other Instruction Decode", "") {
         inputHandler.setKey(1);
         schip.decodeTest(0xE191);
         REQUIRE(schip.getPC() == 0x204);
+
+        // Only the low nibble of VX names the key
+        schip.decodeTest(0x62F5);
+        schip.decodeTest(0xE29E);
+        REQUIRE(schip.getPC() == 0x204);
+
+        inputHandler.setKey(5);
+        schip.decodeTest(0xE29E);
+        REQUIRE(schip.getPC() == 0x206);
+    }
+}
+
+TEST_CASE("SChip Profiler Counts Hot Spots") {
+    TestInputHandler inputHandler{};
+    AdvancedDisplay display{};
+    SChipTest schip{display, inputHandler};
+
+    // Set V0, call a subroutine, draw, clear and exit
+    const uint8_t rom[]{
+        0x60, 0x05, 0x22, 0x0A, 0xD0, 0x11, 0x00, 0xE0, 0x00, 0xFD,
+        0x70, 0x01, 0x00, 0xEE
+    };
+    std::string filename{ "schip_profiler_test.ch8" };
+    std::ofstream out{ filename, std::ios::binary };
+    out.write(reinterpret_cast<const char*>(rom), sizeof(rom));
+    out.close();
+
+    ExecutionProfiler profiler{ "schip_profiler_test" };
+    schip.setProfiler(&profiler);
+
+    RunControl control{};
+    schip.run(filename, control);
+
+    REQUIRE(profiler.getPCCount(0x200) == 1);
+    REQUIRE(profiler.getPCCount(0x20A) == 1);
+    REQUIRE(profiler.getOpcodeCount(Opcode::CALL) == 1);
+    REQUIRE(profiler.getOpcodeCount(Opcode::RETURN) == 1);
+    REQUIRE(profiler.getOpcodeCount(Opcode::EXIT) == 1);
+    REQUIRE(profiler.getDisplayCount(ExecutionProfiler::SPRITE) == 1);
+    REQUIRE(profiler.getDisplayCount(ExecutionProfiler::CLEAR) == 1);
+    REQUIRE(profiler.getDisplayCount(ExecutionProfiler::SCROLL) == 0);
+
+    std::stringstream folded;
+    profiler.writeFoldedStacks(folded);
+    REQUIRE(folded.str() == "0x200 5\n0x200;0x20A 2\n");
+}
+
+TEST_CASE("SChip Tracer Records Changed Registers") {
+    TestInputHandler inputHandler{};
+    AdvancedDisplay display{};
+    SChipTest schip{display, inputHandler};
+
+    // Set V0 and V1, add them, then exit
+    const uint8_t rom[]{ 0x60, 0x05, 0x61, 0xFF, 0x80, 0x14, 0xA1, 0x23, 0x00, 0xFD };
+    std::string filename{ "schip_tracer_test.ch8" };
+    std::ofstream out{ filename, std::ios::binary };
+    out.write(reinterpret_cast<const char*>(rom), sizeof(rom));
+    out.close();
+
+    InstructionTracer tracer{ 16 };
+    REQUIRE(tracer.open("schip_tracer_test.trace"));
+    schip.setTracer(&tracer);
+
+    RunControl control{};
+    schip.run(filename, control);
+    tracer.close();
+    REQUIRE(tracer.getRecordCount() == 5);
+    REQUIRE(tracer.getDroppedCount() == 0);
+
+    std::ifstream in{ "schip_tracer_test.trace", std::ios::binary };
+    in.seekg(sizeof(TRACE_MAGIC) + sizeof(uint32_t));
+    TraceRecord records[5]{};
+    in.read(reinterpret_cast<char*>(records), sizeof(records));
+    REQUIRE(in.gcount() == sizeof(records));
+
+    REQUIRE(records[0].pc == 0x200);
+    REQUIRE(records[0].opcode == 0x6005);
+    REQUIRE(records[0].changedRegisters == 0x0001);
+
+    // 8014 changes V0 and sets the carry in VF
+    REQUIRE(records[2].changedRegisters == 0x8001);
+    REQUIRE(records[2].registers[0] == 0x04);
+    REQUIRE(records[2].registers[15] == 1);
+
+    REQUIRE(records[3].index == 0x123);
+    REQUIRE(records[3].changedRegisters == 0);
+    REQUIRE(records[4].sequence == 4);
+}
+
+TEST_CASE("SChip Tracer Drops Records Instead Of Overwriting Unsaved Ones") {
+    // Without a writer thread nothing is saved, so a full buffer drops everything after it
+    InstructionTracer tracer{ 4 };
+    uint8_t registers[16]{};
+    for (int i{}; i < 6; i++) {
+        tracer.beginInstruction(0x200, 0x6000, registers);
+        tracer.endInstruction(0, registers, 0, 0, 0);
     }
-}
\ No newline at end of file
+    REQUIRE(tracer.getRecordCount() == 6);
+    REQUIRE(tracer.getDroppedCount() == 2);
+}
+
+TEST_CASE("SChip Fork Copies Display Mode") {
+    TestInputHandler inputHandler{};
+    AdvancedDisplay display{};
+    SChipTest schip{display, inputHandler};
+
+    // Big 0 glyph in hires mode
+    schip.decodeTest(0x00FF);
+    schip.decodeTest(0x6000);
+    schip.decodeTest(0xF030);
+    schip.decodeTest(0xD000);
+
+    TestInputHandler forkInputHandler{};
+    AdvancedDisplay forkDisplay{};
+    std::unique_ptr<SChip> fork{ schip.fork(forkDisplay, forkInputHandler) };
+
+    REQUIRE(forkDisplay.isHiresMode());
+    REQUIRE(memcmp(forkDisplay.getPixels(), display.getPixels(), AdvancedDisplay::BUFFER_SIZE) == 0);
+    REQUIRE(fork->index_register == schip.index_register);
+    REQUIRE(fork->memory.getSharedPageCount() == PagedMemory::PAGE_COUNT);
+
+    // FX75 flags live outside RAM, so they are copied rather than shared
+    fork->flags[0] = 0x42;
+    REQUIRE(schip.flags[0] == 0);
+}
+
+TEST_CASE("SChip Save State Keeps Hires Screen And Flags") {
+    TestInputHandler inputHandler{};
+    AdvancedDisplay display{};
+    SChipTest schip{display, inputHandler};
+    std::string path{ "schip_save_state_test.bin" };
+
+    // Big 7 glyph in hires mode and V0 in the FX75 flags
+    schip.decodeTest(0x00FF);
+    schip.decodeTest(0x6007);
+    schip.decodeTest(0xF075);
+    schip.decodeTest(0xF030);
+    schip.decodeTest(0xD000);
+    REQUIRE(schip.saveState(path));
+
+    TestInputHandler loadedInputHandler{};
+    AdvancedDisplay loadedDisplay{};
+    SChipTest loaded{loadedDisplay, loadedInputHandler};
+    REQUIRE(loaded.loadState(path));
+
+    REQUIRE(loadedDisplay.isHiresMode());
+    REQUIRE(loadedDisplay.getFrameHash() == display.getFrameHash());
+    REQUIRE(loaded.flags == schip.flags);
+    REQUIRE(loaded.index_register == schip.index_register);
+    REQUIRE(loaded.program_counter == schip.program_counter);
+
+    std::remove(path.c_str());
+}
+
+TEST_CASE("SChip Idle Loops Are Skipped Without Changing State") {
+    // Delay timer wait with SNE and a key poll
+    const std::vector<std::vector<uint8_t>> roms{
+            { 0x60, 0x03, 0xF0, 0x15, 0xF1, 0x07, 0x41, 0x00, 0x12, 0x0A, 0x12, 0x04, 0x72, 0x01, 0x12, 0x0C },
+            { 0x6A, 0x05, 0xEA, 0xA1, 0x12, 0x02, 0x7B, 0x01, 0x12, 0x00 }
+    };
+
+    for (const auto& rom : roms) {
+        TestInputHandler inputHandler{};
+        AdvancedDisplay display{};
+        SChipTest schip{display, inputHandler};
+        TestInputHandler referenceInputHandler{};
+        AdvancedDisplay referenceDisplay{};
+        SChipTest reference{referenceDisplay, referenceInputHandler};
+        Debugger debugger{};
+        reference.setDebugger(&debugger);
+
+        for (SChipTest* core : { &schip, &reference }) {
+            core->setInstructionsPerFrame(23);
+            REQUIRE(core->loadRom(rom.data(), rom.size()));
+        }
+
+        for (int frame{}; frame < 10; frame++) {
+            uint16_t keys{ (uint16_t) (frame >= 2 && frame < 6 ? 1 << 5 : 0) };
+            inputHandler.setKeyState(keys);
+            referenceInputHandler.setKeyState(keys);
+
+            REQUIRE(schip.runFrames(1));
+            REQUIRE(reference.runFrames(1));
+            REQUIRE(schip.getPC() == reference.getPC());
+            REQUIRE(schip.getRegisters() == reference.getRegisters());
+            REQUIRE(schip.getInstructionCount() == reference.getInstructionCount());
+        }
+    }
+}
+
+TEST_CASE("SChip Fused Pairs Match The Unfused Loop") {
+    // Sprite loop with SET_SET, INDEX_DRAW, ADD_SKIP and SKIP_JUMP, then INDEX_LOAD and a register compare
+    const std::vector<uint8_t> rom{
+            0x60, 0x00, 0x61, 0x05, 0xA2, 0x50, 0xD0, 0x15, 0x70, 0x03, 0x30, 0x1E, 0x12, 0x04, 0xA2, 0x50,
+            0xF2, 0x65, 0x50, 0x10, 0x12, 0x00, 0x12, 0x00
+    };
+    const uint8_t sprite[]{ 0xF0, 0x90, 0xF0, 0x90, 0x90 };
+
+    TestInputHandler inputHandler{};
+    AdvancedDisplay display{};
+    SChipTest schip{display, inputHandler};
+    TestInputHandler referenceInputHandler{};
+    AdvancedDisplay referenceDisplay{};
+    SChipTest reference{referenceDisplay, referenceInputHandler};
+    Debugger debugger{};
+    reference.setDebugger(&debugger);
+
+    for (SChipTest* core : { &schip, &reference }) {
+        core->setInstructionsPerFrame(23);
+        REQUIRE(core->loadRom(rom.data(), rom.size()));
+        core->getMemory().write(0x250, sprite, sizeof(sprite));
+    }
+
+    for (int frame{}; frame < 30; frame++) {
+        REQUIRE(schip.runFrames(1));
+        REQUIRE(reference.runFrames(1));
+        REQUIRE(schip.getPC() == reference.getPC());
+        REQUIRE(schip.getIndex() == reference.getIndex());
+        REQUIRE(schip.getRegisters() == reference.getRegisters());
+        REQUIRE(schip.getInstructionCount() == reference.getInstructionCount());
+        REQUIRE(display.getFrameHash() == referenceDisplay.getFrameHash());
+    }
+    REQUIRE(schip.getFusedCount() > 0);
+}
+
+TEST_CASE("SChip Framebuffer Displays Draw Like Overridden Ones") {
+    // Hires, big and small sprites marching across the edges, cleared every 64 draws, then the same in lores
+    const uint8_t rom[]{ 0x00, 0xFF, 0xA0, 0x50, 0xD0, 0x10, 0xD0, 0x1F, 0x70, 0x0B, 0x71, 0x05, 0x72, 0x01, 0x32, 0x40,
+                         0x12, 0x04, 0x00, 0xE0, 0x62, 0x00, 0x73, 0x01, 0x33, 0x02, 0x12, 0x04, 0x00, 0xFE, 0x63, 0x00,
+                         0x12, 0x04 };
+
+    // Any subclass goes through the virtual calls
+    class OverriddenDisplay : public AdvancedDisplay {};
+
+    TestInputHandler inputHandler{};
+    AdvancedDisplay display{};
+    SChipTest schip{display, inputHandler};
+    OverriddenDisplay referenceDisplay{};
+    SChipTest reference{referenceDisplay, inputHandler};
+    for (SChipTest* core : { &schip, &reference }) {
+        core->setInstructionsPerFrame(50);
+        REQUIRE(core->loadRom(rom, sizeof(rom)));
+    }
+
+    for (int frame{}; frame < 120; frame++) {
+        REQUIRE(schip.runFrames(1));
+        REQUIRE(reference.runFrames(1));
+        REQUIRE(schip.getRegisters() == reference.getRegisters());
+        REQUIRE(display.getFrameHash() == referenceDisplay.getFrameHash());
+    }
+}
+
+TEST_CASE("SChip Reset Matches A New Core") {
+    // Hires, then random big sprites at random places and a store into RAM
+    const uint8_t rom[]{ 0x00, 0xFF, 0xC0, 0x7F, 0xC1, 0x3F, 0xA0, 0xA0, 0xD0, 0x10, 0xA3, 0x00, 0xF1, 0x55, 0x12, 0x02 };
+    RomImage image{};
+    REQUIRE(SChip::buildRomImage(rom, sizeof(rom), image));
+
+    TestInputHandler inputHandler{};
+    AdvancedDisplay display{};
+    SChipTest schip{display, inputHandler};
+    REQUIRE(schip.loadRom(rom, sizeof(rom)));
+    REQUIRE(schip.runFrames(30));
+
+    schip.reset(image, 7);
+    REQUIRE(!display.isHiresMode());
+    AdvancedDisplay referenceDisplay{};
+    SChipTest reference{referenceDisplay, inputHandler};
+    reference.seedRandom(7);
+    REQUIRE(reference.loadRom(rom, sizeof(rom)));
+
+    for (int frame{}; frame < 30; frame++) {
+        REQUIRE(schip.runFrames(1));
+        REQUIRE(reference.runFrames(1));
+        REQUIRE(schip.getRegisters() == reference.getRegisters());
+        REQUIRE(schip.getInstructionCount() == reference.getInstructionCount());
+        REQUIRE(display.getFrameHash() == referenceDisplay.getFrameHash());
+    }
+}
+
+TEST_CASE("SChip Snapshots Roll Back Frames And The Screen Mode") {
+    // A random sprite a frame with the registers stored to the flags, hires from the sixteenth sprite on,
+    // lores again from the forty eighth
+    const uint8_t rom[]{ 0xC0, 0x7F, 0xC1, 0x3F, 0xF2, 0x29, 0xD0, 0x15, 0x72, 0x01, 0xF2, 0x75, 0x42, 0x10, 0x00, 0xFF,
+                         0x42, 0x30, 0x00, 0xFE, 0x12, 0x00 };
+
+    // Any subclass is repainted pixel by pixel
+    class OverriddenDisplay : public AdvancedDisplay {};
+
+    AdvancedDisplay framebufferDisplay{};
+    OverriddenDisplay overriddenDisplay{};
+    for (AdvancedDisplay* display : { &framebufferDisplay, static_cast<AdvancedDisplay*>(&overriddenDisplay) }) {
+        TestInputHandler inputHandler{};
+        SChipTest schip{*display, inputHandler};
+        schip.seedRandom(5);
+        schip.setInstructionsPerFrame(9);
+        REQUIRE(schip.loadRom(rom, sizeof(rom)));
+        REQUIRE(schip.runFrames(4));
+
+        SChipSnapshot snapshot{};
+        schip.saveSnapshot(snapshot);
+        std::vector<uint64_t> hashes;
+        for (int frame{}; frame < 20; frame++) {
+            REQUIRE(schip.runFrames(1));
+            hashes.push_back(display->getFrameHash());
+        }
+        REQUIRE(display->isHiresMode());
+        std::vector<uint8_t> flags{ schip.getFlags() };
+
+        schip.loadSnapshot(snapshot);
+        REQUIRE(!display->isHiresMode());
+        REQUIRE(schip.getRegisters()[2] == 4);
+        for (int frame{}; frame < 20; frame++) {
+            REQUIRE(schip.runFrames(1));
+            REQUIRE(display->getFrameHash() == hashes[frame]);
+        }
+        REQUIRE(schip.getFlags() == flags);
+    }
+}
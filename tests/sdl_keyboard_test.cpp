@@ -0,0 +1,29 @@
+#include <catch2/catch_test_macros.hpp>
+#include "../src/extras/input_handler.h"
+#include "../src/frontend/sdl_keyboard.h"
+
+TEST_CASE("Key Mapping Table", "") {
+    InputHandler inputHandler{};
+    SDLKeyboard keyboard{inputHandler};
+
+    SDL_Event e{};
+    e.type = SDL_KEYDOWN;
+
+    // Unmapped keys are ignored
+    e.key.keysym.sym = SDLK_p;
+    keyboard.handleInput(e);
+    inputHandler.applyEvents(UINT64_MAX);
+    REQUIRE(inputHandler.getKeyBeingPressed() == -1);
+
+    // Remapped key
+    keyboard.setKeyMapping(SDLK_p, 0x3);
+    keyboard.handleInput(e);
+    inputHandler.applyEvents(UINT64_MAX);
+    REQUIRE(inputHandler.isKeyPressed(0x3));
+
+    // Default layout
+    e.key.keysym.sym = SDLK_v;
+    keyboard.handleInput(e);
+    inputHandler.applyEvents(UINT64_MAX);
+    REQUIRE(inputHandler.isKeyPressed(0xF));
+}
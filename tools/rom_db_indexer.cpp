@@ -0,0 +1,19 @@
+#include <cstdio>
+#include "../src/extras/rom_database.h"
+
+// Builds the ROM database index loaded by the emulator at startup
+// Usage: rom_db_indexer <chip-8-database directory with programs.json> <index file>
+int main(int argc, char* argv[]) {
+    if (argc < 3) {
+        printf("Usage: %s <database directory> <index file>\n", argv[0]);
+        return 1;
+    }
+
+    RomDatabase database{};
+    if (!database.loadJson(argv[1]) || !database.writeIndex(argv[2])) {
+        return 1;
+    }
+
+    printf("%zu ROMs indexed into %s\n", database.size(), argv[2]);
+    return 0;
+}
@@ -0,0 +1,108 @@
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <string>
+#include <thread>
+#include <vector>
+#include "../src/extras/disassembler.h"
+#include "../src/extras/thread_pool.h"
+
+// Disassembles ROMs into annotated listings and control flow graphs
+// Usage: rom_disassembler [--chip8] [--dot <file>] <rom>...
+// One ROM prints its listing, several print one summary line each and are analysed in parallel
+struct RomSummary {
+    bool isLoaded;
+    size_t blocks;
+    size_t functions;
+    size_t calls;
+    size_t codeBytes;
+    size_t indirectJumps;
+};
+
+static bool readRom(const char* path, std::vector<uint8_t>& rom) {
+    std::ifstream input{ path, std::ios::binary };
+    if (!input.is_open()) {
+        return false;
+    }
+
+    rom.assign(std::istreambuf_iterator<char>(input), std::istreambuf_iterator<char>());
+    return true;
+}
+
+int main(int argc, char* argv[]) {
+    bool isSchip{true};
+    const char* dotPath{};
+    std::vector<const char*> romPaths;
+    for (int i{1}; i < argc; i++) {
+        if (strcmp(argv[i], "--chip8") == 0) {
+            isSchip = false;
+        } else if (strcmp(argv[i], "--dot") == 0 && i + 1 < argc) {
+            dotPath = argv[++i];
+        } else {
+            romPaths.push_back(argv[i]);
+        }
+    }
+
+    if (romPaths.empty()) {
+        printf("Usage: %s [--chip8] [--dot <file>] <rom>...\n", argv[0]);
+        return 1;
+    }
+
+    if (romPaths.size() == 1) {
+        std::vector<uint8_t> rom;
+        if (!readRom(romPaths[0], rom)) {
+            printf("Error: Specified input file not found\n");
+            return 1;
+        }
+
+        ControlFlowGraph graph{ analyseRom(rom.data(), rom.size(), isSchip) };
+        writeListing(graph, rom.data(), rom.size(), std::cout);
+        if (dotPath != nullptr) {
+            std::ofstream dot{ dotPath };
+            if (!dot.is_open()) {
+                printf("Error: Could not open %s\n", dotPath);
+                return 1;
+            }
+            writeDot(graph, rom.data(), dot);
+        }
+        return 0;
+    }
+
+    // Every ROM is independent, the pool splits them between the cores
+    std::vector<RomSummary> summaries(romPaths.size());
+    ThreadPool pool{ (int) std::max(1u, std::thread::hardware_concurrency()) };
+    pool.parallelFor((int) romPaths.size(), [&](int begin, int end) {
+        std::vector<uint8_t> rom;
+        for (int i{begin}; i < end; i++) {
+            RomSummary& summary{ summaries[i] };
+            summary.isLoaded = readRom(romPaths[i], rom);
+            if (!summary.isLoaded) {
+                continue;
+            }
+
+            ControlFlowGraph graph{ analyseRom(rom.data(), rom.size(), isSchip) };
+            summary.blocks = graph.blocks.size();
+            summary.functions = graph.functions.size();
+            summary.calls = graph.calls.size();
+            summary.codeBytes = graph.code.count() * 2;
+            for (const BasicBlock& block : graph.blocks) {
+                summary.indirectJumps += block.isIndirect;
+            }
+        }
+    });
+
+    printf("%-40s %7s %9s %6s %9s %8s\n", "rom", "blocks", "functions", "calls", "code", "indirect");
+    for (size_t i{}; i < romPaths.size(); i++) {
+        const RomSummary& summary{ summaries[i] };
+        if (!summary.isLoaded) {
+            printf("%-40s not found\n", romPaths[i]);
+            continue;
+        }
+        printf("%-40s %7zu %9zu %6zu %9zu %8zu\n", romPaths[i], summary.blocks, summary.functions, summary.calls,
+               summary.codeBytes, summary.indirectJumps);
+    }
+    return 0;
+}
@@ -0,0 +1,52 @@
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <string>
+#include <vector>
+#include "../src/constants.h"
+#include "../src/extras/recompiler.h"
+
+// Recompiles a CHIP-8 ROM into a C++ translation unit for RecompiledChip8
+// Usage: rom_recompiler [--symbol <name>] [--include <header>] <rom> <output.cpp>
+// The unit defines "extern const RecompiledRom <name>" and includes recompiled_chip8.h through <header>
+int main(int argc, char* argv[]) {
+    std::string symbol{ "recompiledRom" };
+    std::string header{ "recompiled_chip8.h" };
+    std::vector<const char*> paths;
+    for (int i{1}; i < argc; i++) {
+        if (strcmp(argv[i], "--symbol") == 0 && i + 1 < argc) {
+            symbol = argv[++i];
+        } else if (strcmp(argv[i], "--include") == 0 && i + 1 < argc) {
+            header = argv[++i];
+        } else {
+            paths.push_back(argv[i]);
+        }
+    }
+
+    if (paths.size() != 2) {
+        printf("Usage: %s [--symbol <name>] [--include <header>] <rom> <output.cpp>\n", argv[0]);
+        return 1;
+    }
+
+    std::ifstream input{ paths[0], std::ios::binary };
+    if (!input.is_open()) {
+        printf("Error: Specified input file not found\n");
+        return 1;
+    }
+    std::vector<uint8_t> rom{ std::istreambuf_iterator<char>(input), std::istreambuf_iterator<char>() };
+    if (rom.empty() || rom.size() > RAM_SIZE - 0x200) {
+        printf("Error: ROM is empty or larger than the available memory\n");
+        return 1;
+    }
+
+    std::ofstream output{ paths[1] };
+    if (!output.is_open()) {
+        printf("Error: Could not open %s\n", paths[1]);
+        return 1;
+    }
+
+    std::string romName{ paths[0] };
+    writeRecompiledRom(rom.data(), rom.size(), romName.substr(romName.find_last_of('/') + 1), symbol, header, output);
+    return 0;
+}
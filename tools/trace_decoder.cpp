@@ -0,0 +1,61 @@
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include "../src/extras/tracer.h"
+#include "../src/emulators/opcodes.h"
+
+// Prints a binary trace written by InstructionTracer
+// Usage: trace_decoder <trace file> [first record] [record count]
+int main(int argc, char* argv[]) {
+    if (argc < 2) {
+        printf("Usage: %s <trace file> [first record] [record count]\n", argv[0]);
+        return 1;
+    }
+
+    std::ifstream input{ argv[1], std::ios::binary };
+    if (!input.is_open()) {
+        printf("Error: Specified trace file not found\n");
+        return 1;
+    }
+
+    char magic[sizeof(TRACE_MAGIC)];
+    uint32_t recordSize{};
+    input.read(magic, sizeof(magic));
+    input.read(reinterpret_cast<char*>(&recordSize), sizeof(recordSize));
+    if (!input || memcmp(magic, TRACE_MAGIC, sizeof(TRACE_MAGIC)) != 0 || recordSize != sizeof(TraceRecord)) {
+        printf("Error: %s is not a trace file\n", argv[1]);
+        return 1;
+    }
+
+    unsigned long long first{ argc > 2 ? strtoull(argv[2], nullptr, 10) : 0 };
+    unsigned long long count{ argc > 3 ? strtoull(argv[3], nullptr, 10) : ~0ULL };
+
+    TraceRecord record{};
+    unsigned long long printed{};
+    uint32_t expected{};
+    bool isFirst{true};
+    while (printed < count && input.read(reinterpret_cast<char*>(&record), sizeof(record))) {
+        // Gaps in the sequence mean the writer thread fell behind and records were dropped
+        if (!isFirst && record.sequence != expected) {
+            printf("... %u records dropped ...\n", record.sequence - expected);
+        }
+        isFirst = false;
+        expected = record.sequence + 1;
+
+        if (record.sequence < first) {
+            continue;
+        }
+
+        printf("%10u  %03X  %04X  %-4s  I=%03X  DT=%02X ST=%02X SP=%u ", record.sequence, record.pc, record.opcode,
+               opcodePattern(classifyOpcode(record.opcode)), record.index, record.delayTimer, record.soundTimer, record.stackDepth);
+        for (int i{}; i < 16; i++) {
+            if (record.changedRegisters & (1 << i)) {
+                printf(" V%X=%02X", i, record.registers[i]);
+            }
+        }
+        printf("\n");
+        printed++;
+    }
+
+    return 0;
+}